@@ -0,0 +1,47 @@
+/*
+ * Duncan Horn
+ */
+
+#include <benchmark/benchmark.h>
+#include <dhorn/experimental/event_source.h>
+
+
+
+template <typename EventSource>
+void TestInvokeAll(benchmark::State& state)
+{
+    EventSource source;
+    int value = 0;
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        source.add([&value](int x) { value += x; });
+    }
+
+    for (auto _ : state)
+    {
+        source.invoke_all(1);
+    }
+
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+
+void InvokeAll_EventSourceTest(benchmark::State& state)
+{
+    TestInvokeAll<dhorn::experimental::event_source<void(int)>>(state);
+}
+BENCHMARK(InvokeAll_EventSourceTest)->Arg(8)->Arg(64)->Arg(512);
+
+void InvokeAll_FlatEventSourceTest(benchmark::State& state)
+{
+    TestInvokeAll<dhorn::experimental::flat_event_source<void(int)>>(state);
+}
+BENCHMARK(InvokeAll_FlatEventSourceTest)->Arg(8)->Arg(64)->Arg(512);
+
+void InvokeAll_ConcurrentEventSourceTest(benchmark::State& state)
+{
+    TestInvokeAll<dhorn::experimental::concurrent_event_source<void(int)>>(state);
+}
+BENCHMARK(InvokeAll_ConcurrentEventSourceTest)->Arg(8)->Arg(64)->Arg(512);
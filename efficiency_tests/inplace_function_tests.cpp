@@ -4,6 +4,8 @@
 
 #include <benchmark/benchmark.h>
 #include <dhorn/inplace_function.h>
+#include <string>
+#include <vector>
 
 struct test_object
 {
@@ -93,3 +95,140 @@ void Member_InplaceFunctionTest(benchmark::State& state)
     TestInvoke(state, func, o);
 }
 BENCHMARK(Member_InplaceFunctionTest);
+
+
+
+template <typename FuncTy, typename Func>
+void TestMove(benchmark::State& state, Func func)
+{
+    FuncTy a(std::move(func));
+    FuncTy b;
+    for (auto _ : state)
+    {
+        b = std::move(a);
+        a = std::move(b);
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+template <typename FuncTy, typename Func>
+void TestCopy(benchmark::State& state, Func func)
+{
+    FuncTy a(std::move(func));
+    for (auto _ : state)
+    {
+        FuncTy b(a);
+        benchmark::DoNotOptimize(b);
+    }
+}
+
+template <typename FuncTy, typename Func>
+void TestVectorResize(benchmark::State& state, Func func)
+{
+    for (auto _ : state)
+    {
+        // Let the vector grow on its own so that the functions get relocated several times
+        std::vector<FuncTy> funcs;
+        for (std::size_t i = 0; i < 256; ++i)
+        {
+            funcs.emplace_back(func);
+        }
+        benchmark::DoNotOptimize(funcs.data());
+    }
+}
+
+// Trivially copyable lambda that still fits within std::function's small buffer
+static const auto trivial_lambda = [a = 1, b = 2]() { return a + b; };
+
+// Non-trivially copyable lambda
+static const auto string_lambda = [str = std::string("foo")]() { return static_cast<int>(str.size()); };
+
+
+
+void Move_StdFunctionTest(benchmark::State& state)
+{
+    TestMove<std::function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(Move_StdFunctionTest);
+
+void Move_InplaceFunctionTest(benchmark::State& state)
+{
+    TestMove<dhorn::inplace_function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(Move_InplaceFunctionTest);
+
+void Move_InplaceUniqueFunctionTest(benchmark::State& state)
+{
+    TestMove<dhorn::inplace_unique_function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(Move_InplaceUniqueFunctionTest);
+
+void Move_NonTrivial_StdFunctionTest(benchmark::State& state)
+{
+    TestMove<std::function<int()>>(state, string_lambda);
+}
+BENCHMARK(Move_NonTrivial_StdFunctionTest);
+
+void Move_NonTrivial_InplaceFunctionTest(benchmark::State& state)
+{
+    TestMove<dhorn::inplace_function<int()>>(state, string_lambda);
+}
+BENCHMARK(Move_NonTrivial_InplaceFunctionTest);
+
+
+
+void Copy_StdFunctionTest(benchmark::State& state)
+{
+    TestCopy<std::function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(Copy_StdFunctionTest);
+
+void Copy_InplaceFunctionTest(benchmark::State& state)
+{
+    TestCopy<dhorn::inplace_function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(Copy_InplaceFunctionTest);
+
+void Copy_NonTrivial_StdFunctionTest(benchmark::State& state)
+{
+    TestCopy<std::function<int()>>(state, string_lambda);
+}
+BENCHMARK(Copy_NonTrivial_StdFunctionTest);
+
+void Copy_NonTrivial_InplaceFunctionTest(benchmark::State& state)
+{
+    TestCopy<dhorn::inplace_function<int()>>(state, string_lambda);
+}
+BENCHMARK(Copy_NonTrivial_InplaceFunctionTest);
+
+
+
+void VectorResize_StdFunctionTest(benchmark::State& state)
+{
+    TestVectorResize<std::function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(VectorResize_StdFunctionTest);
+
+void VectorResize_InplaceFunctionTest(benchmark::State& state)
+{
+    TestVectorResize<dhorn::inplace_function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(VectorResize_InplaceFunctionTest);
+
+void VectorResize_InplaceUniqueFunctionTest(benchmark::State& state)
+{
+    TestVectorResize<dhorn::inplace_unique_function<int()>>(state, trivial_lambda);
+}
+BENCHMARK(VectorResize_InplaceUniqueFunctionTest);
+
+void VectorResize_NonTrivial_StdFunctionTest(benchmark::State& state)
+{
+    TestVectorResize<std::function<int()>>(state, string_lambda);
+}
+BENCHMARK(VectorResize_NonTrivial_StdFunctionTest);
+
+void VectorResize_NonTrivial_InplaceFunctionTest(benchmark::State& state)
+{
+    TestVectorResize<dhorn::inplace_function<int()>>(state, string_lambda);
+}
+BENCHMARK(VectorResize_NonTrivial_InplaceFunctionTest);
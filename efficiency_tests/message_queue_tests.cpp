@@ -0,0 +1,109 @@
+/*
+ * Duncan Horn
+ */
+
+#include <atomic>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <dhorn/experimental/message_queue.h>
+
+static constexpr std::size_t queue_capacity = 1024;
+static constexpr std::size_t batch_size = 256;
+
+
+
+template <typename QueueType>
+void TestPushPop(benchmark::State& state, QueueType& queue)
+{
+    int value = 0;
+    for (auto _ : state)
+    {
+        queue.push_back([&value]() { ++value; });
+        queue.pop_front()();
+    }
+
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename QueueType>
+void TestProducerConsumer(benchmark::State& state, QueueType& queue)
+{
+    std::atomic_size_t consumed{ 0 };
+    bool done = false;
+
+    std::thread consumer([&]()
+    {
+        while (!done)
+        {
+            queue.pop_front()();
+        }
+    });
+
+    std::size_t produced = 0;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < batch_size; ++i)
+        {
+            queue.push_back([&consumed]() { consumed.fetch_add(1, std::memory_order_relaxed); });
+        }
+
+        // Wait for the consumer to catch up so that each iteration measures the full round trip
+        produced += batch_size;
+        while (consumed.load(std::memory_order_relaxed) != produced)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    queue.push_back([&done]() { done = true; });
+    consumer.join();
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+
+
+void PushPop_MessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::message_queue<void()> queue;
+    TestPushPop(state, queue);
+}
+BENCHMARK(PushPop_MessageQueueTest);
+
+void PushPop_LockFreeMessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::lock_free_message_queue<void()> queue(queue_capacity);
+    TestPushPop(state, queue);
+}
+BENCHMARK(PushPop_LockFreeMessageQueueTest);
+
+void PushPop_SpscMessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::spsc_message_queue<void()> queue(queue_capacity);
+    TestPushPop(state, queue);
+}
+BENCHMARK(PushPop_SpscMessageQueueTest);
+
+
+
+void ProducerConsumer_MessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::message_queue<void()> queue;
+    TestProducerConsumer(state, queue);
+}
+BENCHMARK(ProducerConsumer_MessageQueueTest)->UseRealTime();
+
+void ProducerConsumer_LockFreeMessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::lock_free_message_queue<void()> queue(queue_capacity);
+    TestProducerConsumer(state, queue);
+}
+BENCHMARK(ProducerConsumer_LockFreeMessageQueueTest)->UseRealTime();
+
+void ProducerConsumer_SpscMessageQueueTest(benchmark::State& state)
+{
+    dhorn::experimental::spsc_message_queue<void()> queue(queue_capacity);
+    TestProducerConsumer(state, queue);
+}
+BENCHMARK(ProducerConsumer_SpscMessageQueueTest)->UseRealTime();
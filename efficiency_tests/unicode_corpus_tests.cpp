@@ -0,0 +1,235 @@
+/*
+ * Duncan Horn
+ *
+ * unicode_corpus_tests.cpp
+ *
+ * Throughput tests for the unicode headers and utf_string, run over a set of corpora that each stress a different mix
+ * of code point sizes. Every test is run for each corpus and, where it makes sense, each encoding. Throughput is
+ * reported in bytes of input per second so that results are comparable across encodings.
+ */
+
+#include <benchmark/benchmark.h>
+#include <dhorn/experimental/utf_string.h>
+#include <dhorn/unicode/iterator.h>
+#include <dhorn/unicode/transcode.h>
+#include <string>
+#include <vector>
+
+using namespace dhorn::unicode;
+
+// Corpora are generated by repeating a sample until it's at least this many code points long
+static constexpr std::size_t corpus_length = 16 * 1024;
+
+enum class corpus
+{
+    ascii,  // English text; all single byte in UTF-8
+    latin,  // Western/Central European text; mostly ASCII with some two byte UTF-8 characters
+    cjk,    // Chinese and Japanese text; mostly three byte UTF-8 characters
+    emoji,  // Emoji with a little ASCII mixed in; mostly surrogate pairs in UTF-16
+    mixed,  // All of the above, alternating every sentence or so
+};
+
+static const char32_t* corpus_sample(corpus kind)
+{
+    switch (kind)
+    {
+    case corpus::ascii:
+        return U"The quick brown fox jumps over the lazy dog. It was the best of times, it was the worst of times; it "
+            U"was the age of wisdom, it was the age of foolishness. ";
+
+    case corpus::latin:
+        return U"Le c\u0153ur a ses raisons que la raison ne conna\u00EEt point. \u00DCber allen Gipfeln ist Ruh. "
+            U"\u00BFD\u00F3nde est\u00E1 la estaci\u00F3n? \u00C7a va tr\u00E8s bien, merci. \u00C5 v\u00E6re eller "
+            U"ikke v\u00E6re. Za\u017C\u00F3\u0142\u0107 g\u0119\u015Bl\u0105 ja\u017A\u0144. ";
+
+    case corpus::cjk:
+        return U"\u5929\u5730\u7384\u9EC4\uFF0C\u5B87\u5B99\u6D2A\u8352\u3002\u65E5\u6708\u76C8\u6603\uFF0C\u8FB0"
+            U"\u5BBF\u5217\u5F20\u3002\u543E\u8F29\u306F\u732B\u3067\u3042\u308B\u3002\u540D\u524D\u306F\u307E\u3060"
+            U"\u7121\u3044\u3002\u3069\u3053\u3067\u751F\u308C\u305F\u304B\u3068\u3093\u3068\u898B\u5F53\u304C\u3064"
+            U"\u304B\u306C\u3002";
+
+    case corpus::emoji:
+        return U"\U0001F600\U0001F603\U0001F604 Hi \U0001F44B\U0001F30D! \U0001F389\U0001F38A\U0001F388 \U0001F680"
+            U"\u2728\U0001F525 \U0001F4AF\U0001F44D \U0001F431\U0001F436\U0001F98A ";
+
+    default:
+        return nullptr;
+    }
+}
+
+static std::u32string make_corpus(corpus kind)
+{
+    std::u32string result;
+    while (result.size() < corpus_length)
+    {
+        if (kind == corpus::mixed)
+        {
+            for (auto sample : { corpus::ascii, corpus::latin, corpus::cjk, corpus::emoji })
+            {
+                result += corpus_sample(sample);
+            }
+        }
+        else
+        {
+            result += corpus_sample(kind);
+        }
+    }
+
+    return result;
+}
+
+template <encoding Encoding>
+using code_unit_t = typename encoding_traits<Encoding>::value_type;
+
+template <corpus Corpus, encoding Encoding>
+static const std::basic_string<code_unit_t<Encoding>>& corpus_string()
+{
+    static const auto result = []()
+    {
+        std::basic_string<code_unit_t<Encoding>> str;
+        for (auto ch : make_corpus(Corpus))
+        {
+            encoding_traits<Encoding>::write(std::back_inserter(str), ch);
+        }
+
+        return str;
+    }();
+
+    return result;
+}
+
+template <typename CharTy>
+static void set_bytes_processed(benchmark::State& state, const std::basic_string<CharTy>& str)
+{
+    state.SetBytesProcessed(state.iterations() * str.size() * sizeof(CharTy));
+}
+
+
+
+/*
+ * Iteration
+ */
+template <corpus Corpus, encoding Encoding>
+void Corpus_Iterate_Test(benchmark::State& state)
+{
+    auto& str = corpus_string<Corpus, Encoding>();
+    for (auto _ : state)
+    {
+        char32_t sum = 0;
+        auto end = iterator<const code_unit_t<Encoding>*, Encoding>(str.data() + str.size());
+        for (auto itr = iterator<const code_unit_t<Encoding>*, Encoding>(str.data()); itr != end; ++itr)
+        {
+            sum += *itr;
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    set_bytes_processed(state, str);
+}
+
+
+
+/*
+ * Length
+ */
+template <corpus Corpus, encoding Encoding>
+void Corpus_Length_Test(benchmark::State& state)
+{
+    auto& str = corpus_string<Corpus, Encoding>();
+    for (auto _ : state)
+    {
+        auto length = encoding_traits<Encoding>::length(str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(length);
+    }
+
+    set_bytes_processed(state, str);
+}
+
+
+
+/*
+ * Validation
+ */
+template <corpus Corpus, encoding Encoding>
+void Corpus_Validate_Test(benchmark::State& state)
+{
+    auto& str = corpus_string<Corpus, Encoding>();
+    for (auto _ : state)
+    {
+        auto pos = encoding_traits<Encoding>::validate(str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(pos);
+    }
+
+    set_bytes_processed(state, str);
+}
+
+
+
+/*
+ * Transcoding
+ */
+template <corpus Corpus, encoding Encoding>
+void Corpus_Transcode_Test(benchmark::State& state)
+{
+    // UTF-8 gets transcoded to UTF-16; everything else gets transcoded to UTF-8
+    constexpr auto target = (Encoding == encoding::utf_8) ? encoding::utf_16 : encoding::utf_8;
+
+    auto& str = corpus_string<Corpus, Encoding>();
+    auto length = transcoded_length<Encoding, target>(str.data(), str.data() + str.size()).length;
+    std::vector<code_unit_t<target>> buffer(length);
+    for (auto _ : state)
+    {
+        auto result = transcode<Encoding, target>(str.data(), str.data() + str.size(), buffer.data());
+        benchmark::DoNotOptimize(result);
+    }
+
+    set_bytes_processed(state, str);
+}
+
+
+
+/*
+ * utf_string Construction
+ */
+template <corpus Corpus, encoding Encoding>
+void Corpus_UtfStringConstruct_Test(benchmark::State& state)
+{
+    auto& str = corpus_string<Corpus, Encoding>();
+    for (auto _ : state)
+    {
+        dhorn::experimental::utf_string<code_unit_t<Encoding>> utfStr(str);
+        benchmark::DoNotOptimize(utfStr.c_str());
+    }
+
+    set_bytes_processed(state, str);
+}
+
+
+
+/*
+ * Registration
+ */
+#define CORPUS_BENCHMARK(Function, Encoding) \
+    BENCHMARK_TEMPLATE(Function, corpus::ascii, Encoding); \
+    BENCHMARK_TEMPLATE(Function, corpus::latin, Encoding); \
+    BENCHMARK_TEMPLATE(Function, corpus::cjk, Encoding); \
+    BENCHMARK_TEMPLATE(Function, corpus::emoji, Encoding); \
+    BENCHMARK_TEMPLATE(Function, corpus::mixed, Encoding)
+
+#define CORPUS_BENCHMARK_ALL_ENCODINGS(Function) \
+    CORPUS_BENCHMARK(Function, encoding::utf_8); \
+    CORPUS_BENCHMARK(Function, encoding::utf_16le); \
+    CORPUS_BENCHMARK(Function, encoding::utf_16be); \
+    CORPUS_BENCHMARK(Function, encoding::utf_32le); \
+    CORPUS_BENCHMARK(Function, encoding::utf_32be)
+
+CORPUS_BENCHMARK_ALL_ENCODINGS(Corpus_Iterate_Test);
+CORPUS_BENCHMARK_ALL_ENCODINGS(Corpus_Length_Test);
+CORPUS_BENCHMARK_ALL_ENCODINGS(Corpus_Validate_Test);
+CORPUS_BENCHMARK_ALL_ENCODINGS(Corpus_Transcode_Test);
+
+// NOTE: utf_string only deals with host endian strings
+CORPUS_BENCHMARK(Corpus_UtfStringConstruct_Test, encoding::utf_8);
+CORPUS_BENCHMARK(Corpus_UtfStringConstruct_Test, encoding::utf_16);
+CORPUS_BENCHMARK(Corpus_UtfStringConstruct_Test, encoding::utf_32);
@@ -2,8 +2,12 @@
  * Duncan Horn
  */
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
+#include <dhorn/unicode/index.h>
 #include <dhorn/unicode/iterator.h>
+#include <dhorn/unicode/transcode.h>
+#include <string>
 
 char ansi_string[] = "this is a relatively long ansi string that should be long enough to negate any setup or function"
     "calls. I want this to be pretty long, so here's some repeated ANSII text: foobarfoobarfoobarfoobarfoobarfoobar"
@@ -117,3 +121,349 @@ void FindCharacter_CodePointSize_Test(benchmark::State& state)
     }
 }
 BENCHMARK(FindCharacter_CodePointSize_Test);
+
+
+
+static std::string make_validate_string(bool ascii)
+{
+    // Roughly 1 MB of text. The non-ASCII version mixes in one, two, three, and four byte sequences
+    const char* pieces[] = { "The quick brown fox jumps over the lazy dog. ", u8"été ", u8"中文 ",
+        u8"\U0001F600 " };
+    std::string result;
+    std::size_t index = 0;
+    while (result.size() < (1 << 20))
+    {
+        result += pieces[ascii ? 0 : (index++ % std::size(pieces))];
+    }
+
+    return result;
+}
+
+static const std::string validate_ascii_string = make_validate_string(true);
+static const std::string validate_mixed_string = make_validate_string(false);
+
+template <typename Func>
+void TestValidate(benchmark::State& state, const std::string& str, Func&& func)
+{
+    for (auto _ : state)
+    {
+        auto ptr = func(str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(ptr);
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+
+static const char* checked_read_validate(const char* begin, const char* end)
+{
+    using traits = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_8, true>;
+    while (begin != end)
+    {
+        auto [ch, next] = traits::read(begin);
+        if (ch == dhorn::unicode::eof)
+        {
+            break;
+        }
+        begin = next;
+    }
+
+    return begin;
+}
+
+void Validate_Ascii_CheckedRead_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_ascii_string, checked_read_validate);
+}
+BENCHMARK(Validate_Ascii_CheckedRead_Test);
+
+void Validate_Ascii_Scalar_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_ascii_string, dhorn::unicode::details::utf8_validate_scalar<const char*>);
+}
+BENCHMARK(Validate_Ascii_Scalar_Test);
+
+void Validate_Ascii_Sse2_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_ascii_string, dhorn::unicode::details::utf8_validate_sse2);
+}
+BENCHMARK(Validate_Ascii_Sse2_Test);
+
+void Validate_Ascii_Avx2_Test(benchmark::State& state)
+{
+    if (!dhorn::cpu_features::get().avx2)
+    {
+        state.SkipWithError("AVX2 not supported");
+        return;
+    }
+
+    TestValidate(state, validate_ascii_string, dhorn::unicode::details::utf8_validate_avx2);
+}
+BENCHMARK(Validate_Ascii_Avx2_Test);
+
+void Validate_Mixed_CheckedRead_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_mixed_string, checked_read_validate);
+}
+BENCHMARK(Validate_Mixed_CheckedRead_Test);
+
+void Validate_Mixed_Scalar_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_mixed_string, dhorn::unicode::details::utf8_validate_scalar<const char*>);
+}
+BENCHMARK(Validate_Mixed_Scalar_Test);
+
+void Validate_Mixed_Sse2_Test(benchmark::State& state)
+{
+    TestValidate(state, validate_mixed_string, dhorn::unicode::details::utf8_validate_sse2);
+}
+BENCHMARK(Validate_Mixed_Sse2_Test);
+
+void Validate_Mixed_Avx2_Test(benchmark::State& state)
+{
+    if (!dhorn::cpu_features::get().avx2)
+    {
+        state.SkipWithError("AVX2 not supported");
+        return;
+    }
+
+    TestValidate(state, validate_mixed_string, dhorn::unicode::details::utf8_validate_avx2);
+}
+BENCHMARK(Validate_Mixed_Avx2_Test);
+
+
+
+template <typename Func>
+void TestTranscode(benchmark::State& state, const std::string& str, Func&& func)
+{
+    std::u16string buffer(str.size(), u'\0');
+    for (auto _ : state)
+    {
+        auto ptr = func(str.data(), str.data() + str.size(), buffer.data());
+        benchmark::DoNotOptimize(ptr);
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+
+static char16_t* code_point_transcode(const char* begin, const char* end, char16_t* dest)
+{
+    using namespace dhorn::unicode;
+    while (begin != end)
+    {
+        auto [ch, next] = encoding_traits<encoding::utf_8, true>::read(begin);
+        if (ch == eof)
+        {
+            break;
+        }
+
+        dest = encoding_traits<encoding::utf_16>::write(dest, ch);
+        begin = next;
+    }
+
+    return dest;
+}
+
+static char16_t* bulk_transcode(const char* begin, const char* end, char16_t* dest)
+{
+    using namespace dhorn::unicode;
+    return transcode<encoding::utf_8, encoding::utf_16>(begin, end, dest).output;
+}
+
+void Transcode_Ascii_CodePoint_Test(benchmark::State& state)
+{
+    TestTranscode(state, validate_ascii_string, code_point_transcode);
+}
+BENCHMARK(Transcode_Ascii_CodePoint_Test);
+
+void Transcode_Ascii_Bulk_Test(benchmark::State& state)
+{
+    TestTranscode(state, validate_ascii_string, bulk_transcode);
+}
+BENCHMARK(Transcode_Ascii_Bulk_Test);
+
+void Transcode_Mixed_CodePoint_Test(benchmark::State& state)
+{
+    TestTranscode(state, validate_mixed_string, code_point_transcode);
+}
+BENCHMARK(Transcode_Mixed_CodePoint_Test);
+
+void Transcode_Mixed_Bulk_Test(benchmark::State& state)
+{
+    TestTranscode(state, validate_mixed_string, bulk_transcode);
+}
+BENCHMARK(Transcode_Mixed_Bulk_Test);
+
+
+
+static std::u16string to_utf16(const std::string& str)
+{
+    std::u16string result;
+    dhorn::unicode::transcode<dhorn::unicode::encoding::utf_8, dhorn::unicode::encoding::utf_16>(
+        str.data(), str.data() + str.size(), result);
+    return result;
+}
+
+static const std::u16string length_mixed_utf16_string = to_utf16(validate_mixed_string);
+
+template <typename CharTy, typename Func>
+void TestLength(benchmark::State& state, const std::basic_string<CharTy>& str, Func&& func)
+{
+    for (auto _ : state)
+    {
+        auto length = func(str.c_str());
+        benchmark::DoNotOptimize(length);
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size() * sizeof(CharTy));
+}
+
+template <dhorn::unicode::encoding Encoding>
+static dhorn::unicode::string_length scalar_length(
+    const typename dhorn::unicode::encoding_traits<Encoding>::value_type* str)
+{
+    return dhorn::unicode::details::length<dhorn::unicode::encoding_traits<Encoding>>(str);
+}
+
+template <dhorn::unicode::encoding Encoding>
+static dhorn::unicode::string_length traits_length(
+    const typename dhorn::unicode::encoding_traits<Encoding>::value_type* str)
+{
+    return dhorn::unicode::encoding_traits<Encoding>::length(str);
+}
+
+void StringLength_Ascii_Scalar_Test(benchmark::State& state)
+{
+    TestLength(state, validate_ascii_string, scalar_length<dhorn::unicode::encoding::utf_8>);
+}
+BENCHMARK(StringLength_Ascii_Scalar_Test);
+
+void StringLength_Ascii_Vectorized_Test(benchmark::State& state)
+{
+    TestLength(state, validate_ascii_string, traits_length<dhorn::unicode::encoding::utf_8>);
+}
+BENCHMARK(StringLength_Ascii_Vectorized_Test);
+
+void StringLength_Mixed_Scalar_Test(benchmark::State& state)
+{
+    TestLength(state, validate_mixed_string, scalar_length<dhorn::unicode::encoding::utf_8>);
+}
+BENCHMARK(StringLength_Mixed_Scalar_Test);
+
+void StringLength_Mixed_Vectorized_Test(benchmark::State& state)
+{
+    TestLength(state, validate_mixed_string, traits_length<dhorn::unicode::encoding::utf_8>);
+}
+BENCHMARK(StringLength_Mixed_Vectorized_Test);
+
+void StringLength_MixedUtf16_Scalar_Test(benchmark::State& state)
+{
+    TestLength(state, length_mixed_utf16_string, scalar_length<dhorn::unicode::encoding::utf_16>);
+}
+BENCHMARK(StringLength_MixedUtf16_Scalar_Test);
+
+void StringLength_MixedUtf16_Vectorized_Test(benchmark::State& state)
+{
+    TestLength(state, length_mixed_utf16_string, traits_length<dhorn::unicode::encoding::utf_16>);
+}
+BENCHMARK(StringLength_MixedUtf16_Vectorized_Test);
+
+void StringLength_Mixed_Range_Test(benchmark::State& state)
+{
+    // Same as above, but without needing to find the null terminator first
+    auto& str = validate_mixed_string;
+    for (auto _ : state)
+    {
+        auto length = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_8>::length(
+            str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(length);
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(StringLength_Mixed_Range_Test);
+
+void StringLength_MixedUtf16_Range_Test(benchmark::State& state)
+{
+    auto& str = length_mixed_utf16_string;
+    for (auto _ : state)
+    {
+        auto length = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_16>::length(
+            str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(length);
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size() * sizeof(char16_t));
+}
+BENCHMARK(StringLength_MixedUtf16_Range_Test);
+
+void Transcode_Mixed_Streaming_Test(benchmark::State& state)
+{
+    // Same as Transcode_Mixed_Bulk_Test, but fed in 1500 byte chunks (roughly the size of a network packet)
+    using transcoder_type = dhorn::unicode::streaming_transcoder<
+        dhorn::unicode::encoding::utf_8,
+        dhorn::unicode::encoding::utf_16>;
+    constexpr std::size_t chunk_size = 1500;
+
+    auto& str = validate_mixed_string;
+    std::u16string buffer(transcoder_type::max_output_length(chunk_size), u'\0');
+    for (auto _ : state)
+    {
+        transcoder_type transcoder;
+        for (std::size_t pos = 0; pos < str.size(); pos += chunk_size)
+        {
+            auto end = str.data() + std::min(pos + chunk_size, str.size());
+            auto result = transcoder.feed(str.data() + pos, end, buffer.data());
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(Transcode_Mixed_Streaming_Test);
+
+void CodePointIndex_Build_Test(benchmark::State& state)
+{
+    auto& str = validate_mixed_string;
+    for (auto _ : state)
+    {
+        dhorn::unicode::code_point_index<dhorn::unicode::encoding::utf_8> index(str.data(), str.data() + str.size());
+        benchmark::DoNotOptimize(index.length());
+    }
+
+    state.SetBytesProcessed(state.iterations() * str.size());
+}
+BENCHMARK(CodePointIndex_Build_Test);
+
+void CodePointIndex_Iterator_Lookup_Test(benchmark::State& state)
+{
+    // Look up code points spread throughout the string by advancing an iterator from the start
+    auto& str = validate_mixed_string;
+    auto length = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_8>::length(
+        str.data(), str.data() + str.size()).code_points;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < length; i += length / 16)
+        {
+            auto itr = dhorn::unicode::iterator(str.data());
+            std::advance(itr, i);
+            benchmark::DoNotOptimize(*itr);
+        }
+    }
+}
+BENCHMARK(CodePointIndex_Iterator_Lookup_Test);
+
+void CodePointIndex_Index_Lookup_Test(benchmark::State& state)
+{
+    // Same as above, but with the lookups going through a code_point_index
+    auto& str = validate_mixed_string;
+    dhorn::unicode::code_point_index<dhorn::unicode::encoding::utf_8> index(str.data(), str.data() + str.size());
+    auto length = index.length();
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < length; i += length / 16)
+        {
+            benchmark::DoNotOptimize(index[i]);
+        }
+    }
+}
+BENCHMARK(CodePointIndex_Index_Lookup_Test);
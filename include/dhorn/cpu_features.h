@@ -0,0 +1,147 @@
+/*
+ * Duncan Horn
+ *
+ * cpu_features.h
+ *
+ * Runtime detection of the instruction set extensions supported by the processor (and operating system) that the code
+ * is running on. Code that wants to use an extension beyond what the compiler targets by default should mark the
+ * functions that use it with the corresponding DHORN_TARGET_* macro and only call them when cpu_features says that it's
+ * safe to do so. E.g.
+ *
+ *      DHORN_TARGET_AVX2 void do_avx2(...) { ... }
+ *      ...
+ *      if (dhorn::cpu_features::get().avx2)
+ *      {
+ *          do_avx2(...);
+ *      }
+ *
+ * All features are reported as unsupported on non-x86 architectures.
+ */
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_AMD64) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define DHORN_X86 1
+#else
+#define DHORN_X86 0
+#endif
+
+// SSE2 is part of the baseline for x64, so code that only needs SSE2 can check for it at compile time
+#if defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DHORN_SSE2 1
+#else
+#define DHORN_SSE2 0
+#endif
+
+#if DHORN_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC allows the use of intrinsics regardless of the target architecture. Clang and GCC require that the function be
+// marked as targeting the required extension(s)
+#if defined(_MSC_VER) && !defined(__clang__)
+#define DHORN_TARGET(features)
+#else
+#define DHORN_TARGET(features) __attribute__((target(features)))
+#endif
+
+#define DHORN_TARGET_SSE2 DHORN_TARGET("sse2")
+#define DHORN_TARGET_SSSE3 DHORN_TARGET("ssse3")
+#define DHORN_TARGET_SSE4_1 DHORN_TARGET("sse4.1")
+#define DHORN_TARGET_AVX2 DHORN_TARGET("avx2")
+
+namespace dhorn
+{
+    /*
+     * cpu_features
+     */
+    struct cpu_features
+    {
+        bool sse2 = false;
+        bool sse3 = false;
+        bool ssse3 = false;
+        bool sse4_1 = false;
+        bool sse4_2 = false;
+        bool popcnt = false;
+        bool avx = false;
+        bool avx2 = false;
+        bool bmi1 = false;
+        bool bmi2 = false;
+
+        static const cpu_features& get() noexcept
+        {
+            static const cpu_features result = detect();
+            return result;
+        }
+
+        static cpu_features detect() noexcept
+        {
+            cpu_features result;
+
+#if DHORN_X86
+            std::uint32_t regs[4];
+            cpuid(0, regs);
+            const auto maxLeaf = regs[0];
+
+            if (maxLeaf >= 1)
+            {
+                cpuid(1, regs);
+                result.sse2 = (regs[3] & (1u << 26)) != 0;
+                result.sse3 = (regs[2] & (1u << 0)) != 0;
+                result.ssse3 = (regs[2] & (1u << 9)) != 0;
+                result.sse4_1 = (regs[2] & (1u << 19)) != 0;
+                result.sse4_2 = (regs[2] & (1u << 20)) != 0;
+                result.popcnt = (regs[2] & (1u << 23)) != 0;
+
+                // AVX requires that the OS save/restore the YMM registers on context switch
+                const bool osxsave = (regs[2] & (1u << 27)) != 0;
+                result.avx = osxsave && ((regs[2] & (1u << 28)) != 0) && ((xgetbv() & 0x06) == 0x06);
+            }
+
+            if (maxLeaf >= 7)
+            {
+                cpuid(7, regs);
+                result.avx2 = result.avx && ((regs[1] & (1u << 5)) != 0);
+                result.bmi1 = (regs[1] & (1u << 3)) != 0;
+                result.bmi2 = (regs[1] & (1u << 8)) != 0;
+            }
+#endif
+
+            return result;
+        }
+
+    private:
+
+#if DHORN_X86
+        static void cpuid(std::uint32_t leaf, std::uint32_t (&regs)[4]) noexcept
+        {
+#if defined(_MSC_VER)
+            int result[4];
+            __cpuidex(result, static_cast<int>(leaf), 0);
+            for (int i = 0; i < 4; ++i)
+            {
+                regs[i] = static_cast<std::uint32_t>(result[i]);
+            }
+#else
+            __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        }
+
+        static std::uint64_t xgetbv() noexcept
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            std::uint32_t eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+        }
+#endif
+    };
+}
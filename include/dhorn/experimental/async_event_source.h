@@ -0,0 +1,391 @@
+/*
+ * Duncan Horn
+ *
+ * async_event_source.h
+ *
+ * An event source whose callbacks are run on a thread pool rather than on the thread that raises the event, so that
+ * slow subscribers cannot stall the publisher. Each subscriber receives its events one at a time and in the order that
+ * they were raised, however different subscribers run independently of one another. When a subscriber falls behind,
+ * events that are waiting to be delivered to it are coalesced according to the policy that it was added with:
+ *
+ *      bounded_queue           Up to `max_pending` events are kept. If another event arrives, the oldest waiting event
+ *                              is discarded. This is the default, with an unbounded limit. A limit of zero is rejected.
+ *      latest_wins             At most one event is kept. If another event arrives, it replaces the one waiting.
+ *      drop                    If the subscriber is still busy with a prior event, the new event is discarded.
+ *
+ * Event arguments are copied once per event and that copy is shared by all subscribers. Subscribers are handed const
+ * references to that copy, so each argument type must either be a value type or a const lvalue reference. The
+ * invoke_all_for_completion function returns a future that becomes ready once every subscriber has either handled or
+ * discarded the event. If any callback throws, or if the thread pool refuses the work needed to deliver the event to a
+ * subscriber, the future holds the first exception thrown. Either way, the event is still delivered to all of the other
+ * subscribers.
+ *
+ * Note that callbacks may still be running (or may start running) after remove returns, and that the thread pool must
+ * outlive the async_event_source.
+ */
+#pragma once
+
+#include <deque>
+#include <exception>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+#include "../thread_pool.h"
+#include "event_source.h"
+
+namespace dhorn
+{
+    namespace experimental
+    {
+        /*
+         * async_event_policy
+         */
+        enum class async_event_policy
+        {
+            bounded_queue = 0,
+            latest_wins = 1,
+            drop = 2,
+        };
+
+
+
+        namespace details
+        {
+            /*
+             * async_event
+             *
+             * The arguments for a single call to invoke_all, shared between all subscribers. The event is complete once
+             * all subscribers have released their reference, so completion is reported from the destructor.
+             */
+            template <typename... Args>
+            struct async_event
+            {
+                template <typename... Ts>
+                async_event(bool tracked, Ts &&...values) :
+                    args(std::forward<Ts>(values)...),
+                    tracked(tracked)
+                {
+                }
+
+                ~async_event(void)
+                {
+                    if (this->tracked)
+                    {
+                        if (this->error)
+                        {
+                            this->promise.set_exception(this->error);
+                        }
+                        else
+                        {
+                            this->promise.set_value();
+                        }
+                    }
+                }
+
+                void set_error(std::exception_ptr ptr)
+                {
+                    // Acquire errorMutex
+                    std::lock_guard<std::mutex> lock(this->errorMutex);
+                    if (!this->error)
+                    {
+                        this->error = std::move(ptr);
+                    }
+                    // Release errorMutex
+                }
+
+                const std::tuple<std::decay_t<Args>...> args;
+                const bool tracked;
+                std::promise<void> promise;
+                std::mutex errorMutex;
+                std::exception_ptr error;
+            };
+
+
+
+            /*
+             * async_subscriber
+             */
+            template <typename... Args>
+            struct async_subscriber
+            {
+                using event_ptr = std::shared_ptr<async_event<Args...>>;
+
+                async_subscriber(
+                    std::function<void(Args...)> callback,
+                    async_event_policy policy,
+                    std::size_t maxPending) :
+                    callback(std::move(callback)),
+                    policy(policy),
+                    maxPending((policy == async_event_policy::latest_wins) ? 1 : maxPending)
+                {
+                }
+
+                const std::function<void(Args...)> callback;
+                const async_event_policy policy;
+                const std::size_t maxPending;
+
+                // Protected by mutex
+                std::deque<event_ptr> pending;
+                bool scheduled = false;
+                bool removed = false;
+                std::mutex mutex;
+            };
+        }
+
+
+
+        /*
+         * async_event_source
+         */
+        template <typename Func, typename ThreadPoolTraits = default_thread_pool_traits>
+        class async_event_source;
+
+        template <typename... Args, typename ThreadPoolTraits>
+        class async_event_source<void(Args...), ThreadPoolTraits> final
+        {
+            static_assert(((!std::is_reference_v<Args> ||
+                (std::is_lvalue_reference_v<Args> && std::is_const_v<std::remove_reference_t<Args>>)) && ...),
+                "async_event_source arguments must be value types or const lvalue references");
+
+            using subscriber_type = details::async_subscriber<Args...>;
+            using event_type = details::async_event<Args...>;
+            using event_ptr = std::shared_ptr<event_type>;
+
+        public:
+
+            /*
+             * Type Definitions
+             */
+            using callback_type = std::function<void(Args...)>;
+            using thread_pool_type = basic_thread_pool<ThreadPoolTraits>;
+            using size_type = std::size_t;
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            explicit async_event_source(thread_pool_type &pool) :
+                _pool(&pool)
+            {
+            }
+
+            ~async_event_source(void)
+            {
+                // Discard all events that haven't been delivered yet. Any callbacks that are currently running will run
+                // to completion in the background
+                for (auto &pair : this->_subscribers)
+                {
+                    this->Discard(*pair.second);
+                }
+            }
+
+            // Cannot copy or move (does not make sense to...)
+            async_event_source(const async_event_source &) = delete;
+            async_event_source &operator=(const async_event_source &) = delete;
+
+
+
+            /*
+             * Public Functions
+             */
+            event_cookie add(
+                callback_type func,
+                async_event_policy policy = async_event_policy::bounded_queue,
+                std::size_t maxPending = std::numeric_limits<std::size_t>::max())
+            {
+                if (maxPending == 0)
+                {
+                    throw std::invalid_argument("Cannot subscribe with a maxPending of zero");
+                }
+
+                auto subscriber = std::make_shared<subscriber_type>(std::move(func), policy, maxPending);
+
+                // Acquire _mutex
+                std::lock_guard<std::mutex> lock(this->_mutex);
+                auto cookie = this->_targets.add([this, subscriber](const event_ptr &event)
+                {
+                    this->Enqueue(subscriber, event);
+                });
+
+                this->_subscribers.emplace(cookie, std::move(subscriber));
+                return cookie;
+                // Release _mutex
+            }
+
+            void remove(event_cookie cookie)
+            {
+                std::shared_ptr<subscriber_type> subscriber;
+
+                {
+                    // Acquire _mutex
+                    std::lock_guard<std::mutex> lock(this->_mutex);
+                    auto itr = this->_subscribers.find(cookie);
+                    if (itr == this->_subscribers.end())
+                    {
+                        throw std::out_of_range("Event does not exist");
+                    }
+
+                    this->_targets.remove(cookie);
+                    subscriber = std::move(itr->second);
+                    this->_subscribers.erase(itr);
+                    // Release _mutex
+                }
+
+                this->Discard(*subscriber);
+            }
+
+            template <typename... Ts>
+            void invoke_all(Ts &&...args)
+            {
+                this->_targets.invoke_all(std::make_shared<event_type>(false, std::forward<Ts>(args)...));
+            }
+
+            template <typename... Ts>
+            std::future<void> invoke_all_for_completion(Ts &&...args)
+            {
+                auto event = std::make_shared<event_type>(true, std::forward<Ts>(args)...);
+                auto result = event->promise.get_future();
+
+                // The future becomes ready once the last reference to the event goes away
+                this->_targets.invoke_all(event);
+                return result;
+            }
+
+            // NOTE: The values returned by size/empty are only snapshots and may be stale by the time they are used
+            size_type size(void) const
+            {
+                return this->_targets.size();
+            }
+
+            bool empty(void) const
+            {
+                return this->_targets.empty();
+            }
+
+
+
+        private:
+
+            void Enqueue(const std::shared_ptr<subscriber_type> &subscriber, const event_ptr &event)
+            {
+                // NOTE: Events that get discarded must be released outside of the lock since that may complete them
+                event_ptr discarded;
+                bool schedule = false;
+
+                {
+                    // Acquire subscriber->mutex
+                    std::lock_guard<std::mutex> lock(subscriber->mutex);
+                    if (subscriber->removed)
+                    {
+                        return;
+                    }
+
+                    if ((subscriber->policy == async_event_policy::drop) && subscriber->scheduled)
+                    {
+                        return;
+                    }
+
+                    if (subscriber->pending.size() >= subscriber->maxPending)
+                    {
+                        discarded = std::move(subscriber->pending.front());
+                        subscriber->pending.pop_front();
+                    }
+
+                    subscriber->pending.push_back(event);
+                    schedule = !subscriber->scheduled;
+                    subscriber->scheduled = true;
+                    // Release subscriber->mutex
+                }
+
+                if (schedule)
+                {
+                    try
+                    {
+                        this->_pool->submit([subscriber]()
+                        {
+                            Deliver(*subscriber);
+                        });
+                    }
+                    catch (...)
+                    {
+                        // Nothing will deliver the pending events, so throw them away so that they still complete. We
+                        // are in the middle of fanning the event out, so report the failure through the event rather
+                        // than throwing; otherwise the remaining subscribers would never see it
+                        std::deque<event_ptr> undelivered;
+
+                        {
+                            // Acquire subscriber->mutex
+                            std::lock_guard<std::mutex> lock(subscriber->mutex);
+                            undelivered.swap(subscriber->pending);
+                            subscriber->scheduled = false;
+                            // Release subscriber->mutex
+                        }
+
+                        for (auto &value : undelivered)
+                        {
+                            value->set_error(std::current_exception());
+                        }
+                    }
+                }
+            }
+
+            static void Deliver(subscriber_type &subscriber)
+            {
+                while (true)
+                {
+                    event_ptr event;
+
+                    {
+                        // Acquire subscriber.mutex
+                        std::lock_guard<std::mutex> lock(subscriber.mutex);
+                        if (subscriber.pending.empty())
+                        {
+                            subscriber.scheduled = false;
+                            return;
+                        }
+
+                        event = std::move(subscriber.pending.front());
+                        subscriber.pending.pop_front();
+                        // Release subscriber.mutex
+                    }
+
+                    try
+                    {
+                        std::apply(subscriber.callback, event->args);
+                    }
+                    catch (...)
+                    {
+                        event->set_error(std::current_exception());
+                    }
+                }
+            }
+
+            static void Discard(subscriber_type &subscriber)
+            {
+                std::deque<event_ptr> discarded;
+
+                {
+                    // Acquire subscriber.mutex
+                    std::lock_guard<std::mutex> lock(subscriber.mutex);
+                    subscriber.removed = true;
+                    discarded.swap(subscriber.pending);
+                    // Release subscriber.mutex
+                }
+            }
+
+            thread_pool_type *_pool;
+            concurrent_event_source<void(const event_ptr &)> _targets;
+
+            // Protected by _mutex
+            std::map<event_cookie, std::shared_ptr<subscriber_type>> _subscribers;
+            std::mutex _mutex;
+        };
+    }
+}
@@ -5,6 +5,20 @@
  *
  * Represents a source of event firing in event-driven scenarios. Note that the event_source maintains order of what's
  * inserted and will fire events in the same order that they are added to the event_source
+ *
+ * The flat_event_source type has the same interface, but stores its callbacks as inplace_function objects in a single
+ * contiguous vector rather than a std::map of std::function objects. Since cookies are handed out in increasing order
+ * and new callbacks are always appended, the vector is always sorted by cookie, so removal can binary search and
+ * invoke_all is a linear walk over contiguous memory with no per-callback heap indirection. This makes it a better fit
+ * for sources that fire often and/or have many subscribers. Note that neither type supports adding or removing
+ * callbacks from within a callback that is being invoked, but for flat_event_source this is especially important as
+ * doing so may move the callback that is currently executing.
+ *
+ * The concurrent_event_source type is safe to use from multiple threads at once. Calls to add/remove build a new,
+ * immutable array of callbacks and atomically publish it, so invoking callbacks only requires announcing the reader
+ * and a single atomic load of the current array; it never blocks on, or is blocked by, concurrent calls to add/remove.
+ * Old arrays are reclaimed (see rcu_object.h) once no reader can still be using them, so it is also safe to add or
+ * remove callbacks from within a callback, although the change will not be visible until the next invocation.
  */
 #pragma once
 
@@ -12,7 +26,12 @@
 #include <cassert>
 #include <functional>
 #include <map>
+#include <stdexcept>
 #include <utility>
+#include <vector>
+
+#include "../inplace_function.h"
+#include "rcu_object.h"
 
 namespace dhorn
 {
@@ -166,5 +185,309 @@ namespace dhorn
             storage_type _eventTargets;
             event_cookie _nextEventCookie;
         };
+
+
+
+        /*
+         * flat_event_source
+         */
+        template <typename Func, std::size_t CallbackSize = (8 * sizeof(void*))>
+        class flat_event_source;
+
+        template <typename ReturnType, typename... Args, std::size_t CallbackSize>
+        class flat_event_source<ReturnType(Args...), CallbackSize> final
+        {
+            using CallbackType = inplace_function<ReturnType(Args...), CallbackSize>;
+            using value_type = std::pair<event_cookie, CallbackType>;
+            using storage_type = std::vector<value_type>;
+
+        public:
+
+            /*
+             * Type Definitions
+             */
+            using callback_type = CallbackType;
+            using size_type = typename storage_type::size_type;
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            flat_event_source(void) :
+                _nextEventCookie(invalid_event_cookie)
+            {
+            }
+
+            flat_event_source(flat_event_source &&other) :
+                _eventTargets(std::move(other._eventTargets)),
+                _nextEventCookie(other._nextEventCookie)
+            {
+            }
+
+            // Cannot copy (does not make sense to...)
+            flat_event_source(const flat_event_source &) = delete;
+            flat_event_source &operator=(const flat_event_source &) = delete;
+
+
+
+            /*
+             * Operators
+             */
+            flat_event_source &operator=(flat_event_source &&other)
+            {
+                this->_eventTargets = std::move(other._eventTargets);
+                this->_nextEventCookie = other._nextEventCookie;
+                return *this;
+            }
+
+
+
+            /*
+             * Public Functions
+             */
+            event_cookie add(callback_type func)
+            {
+                // NOTE: Cookies are strictly increasing, so appending keeps the storage sorted
+                this->_eventTargets.emplace_back(this->_nextEventCookie + 1, std::move(func));
+                return ++this->_nextEventCookie;
+            }
+
+            void remove(event_cookie cookie)
+            {
+                this->_eventTargets.erase(this->FindEvent(cookie));
+            }
+
+            void reserve(size_type capacity)
+            {
+                this->_eventTargets.reserve(capacity);
+            }
+
+            void invoke_one(Args ...args) const
+            {
+                if (!this->_eventTargets.empty())
+                {
+                    this->_eventTargets.front().second(args...);
+                }
+            }
+
+            template <typename ResultFunc>
+            void invoke_one(Args ...args, const ResultFunc &func) const
+            {
+                // Allow callers to handle failures
+                if (!this->_eventTargets.empty())
+                {
+                    func(this->_eventTargets.front().second(args...));
+                }
+            }
+
+            void invoke_all(Args ...args) const
+            {
+                for (auto &pair : this->_eventTargets)
+                {
+                    pair.second(args...);
+                }
+            }
+
+            template <typename ResultFunc>
+            void invoke_all(Args ...args, const ResultFunc &func) const
+            {
+                for (auto &pair : this->_eventTargets)
+                {
+                    // Allow callers to handle failures
+                    func(pair.second(args...));
+                }
+            }
+
+            size_type size(void) const
+            {
+                return this->_eventTargets.size();
+            }
+
+            bool empty(void) const
+            {
+                return this->_eventTargets.empty();
+            }
+
+
+
+        private:
+
+            typename storage_type::const_iterator FindEvent(event_cookie cookie) const
+            {
+                auto itr = std::lower_bound(this->_eventTargets.begin(), this->_eventTargets.end(), cookie,
+                    [](const value_type &pair, event_cookie value)
+                {
+                    return pair.first < value;
+                });
+
+                if ((itr == this->_eventTargets.end()) || (itr->first != cookie))
+                {
+                    throw std::out_of_range("Event does not exist");
+                }
+
+                return itr;
+            }
+
+            // NOTE: inplace_function::operator() is non-const. Mark the storage as mutable so that, like event_source,
+            // callbacks can be invoked through a const reference
+            mutable storage_type _eventTargets;
+            event_cookie _nextEventCookie;
+        };
+
+
+
+        /*
+         * concurrent_event_source
+         *
+         * The array of callbacks is held in an rcu_object, so readers (i.e. the invoke functions) only hold a
+         * read_guard for the duration of the invocation, and writers (serialized by the rcu_object) publish a new
+         * array.
+         */
+        template <typename Func, std::size_t CallbackSize = (8 * sizeof(void*))>
+        class concurrent_event_source;
+
+        template <typename ReturnType, typename... Args, std::size_t CallbackSize>
+        class concurrent_event_source<ReturnType(Args...), CallbackSize> final
+        {
+            using CallbackType = inplace_function<ReturnType(Args...), CallbackSize>;
+
+            struct value_type
+            {
+                event_cookie cookie;
+
+                // NOTE: inplace_function::operator() is non-const, but published arrays are only accessible through a
+                // const reference
+                mutable CallbackType callback;
+            };
+
+            using storage_type = std::vector<value_type>;
+
+        public:
+
+            /*
+             * Type Definitions
+             */
+            using callback_type = CallbackType;
+            using size_type = typename storage_type::size_type;
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            concurrent_event_source(void) = default;
+
+            // Cannot copy or move (does not make sense to...)
+            concurrent_event_source(const concurrent_event_source &) = delete;
+            concurrent_event_source &operator=(const concurrent_event_source &) = delete;
+
+
+
+            /*
+             * Public Functions
+             */
+            event_cookie add(callback_type func)
+            {
+                event_cookie cookie = invalid_event_cookie;
+                this->_eventTargets.update([&](const storage_type &current)
+                {
+                    storage_type targets;
+                    targets.reserve(current.size() + 1);
+                    targets.insert(targets.end(), current.begin(), current.end());
+
+                    // NOTE: Writers are serialized, so this is safe. Cookies are strictly increasing, so appending keeps
+                    // the storage sorted
+                    cookie = ++this->_nextEventCookie;
+                    targets.push_back(value_type{ cookie, std::move(func) });
+                    return targets;
+                });
+
+                return cookie;
+            }
+
+            void remove(event_cookie cookie)
+            {
+                this->_eventTargets.update([&](const storage_type &current)
+                {
+                    auto itr = std::lower_bound(current.begin(), current.end(), cookie,
+                        [](const value_type &value, event_cookie key)
+                    {
+                        return value.cookie < key;
+                    });
+
+                    if ((itr == current.end()) || (itr->cookie != cookie))
+                    {
+                        throw std::out_of_range("Event does not exist");
+                    }
+
+                    storage_type targets;
+                    targets.reserve(current.size() - 1);
+                    targets.insert(targets.end(), current.begin(), itr);
+                    targets.insert(targets.end(), itr + 1, current.end());
+                    return targets;
+                });
+            }
+
+            void invoke_one(Args ...args) const
+            {
+                auto targets = this->_eventTargets.read();
+                if (!targets->empty())
+                {
+                    targets->front().callback(args...);
+                }
+            }
+
+            template <typename ResultFunc>
+            void invoke_one(Args ...args, const ResultFunc &func) const
+            {
+                // Allow callers to handle failures
+                auto targets = this->_eventTargets.read();
+                if (!targets->empty())
+                {
+                    func(targets->front().callback(args...));
+                }
+            }
+
+            void invoke_all(Args ...args) const
+            {
+                auto targets = this->_eventTargets.read();
+                for (auto &value : *targets)
+                {
+                    value.callback(args...);
+                }
+            }
+
+            template <typename ResultFunc>
+            void invoke_all(Args ...args, const ResultFunc &func) const
+            {
+                auto targets = this->_eventTargets.read();
+                for (auto &value : *targets)
+                {
+                    // Allow callers to handle failures
+                    func(value.callback(args...));
+                }
+            }
+
+            // NOTE: The values returned by size/empty are only snapshots and may be stale by the time they are used
+            size_type size(void) const
+            {
+                return this->_eventTargets.read()->size();
+            }
+
+            bool empty(void) const
+            {
+                return this->size() == 0;
+            }
+
+
+
+        private:
+
+            rcu_object<storage_type> _eventTargets;
+
+            // Only accessed by writers
+            event_cookie _nextEventCookie = invalid_event_cookie;
+        };
     }
 }
@@ -3,15 +3,37 @@
  *
  * message_queue.h
  *
+ * Thread safe FIFO queues of function objects. The message_queue type is an unbounded, lock-based queue. The
+ * lock_free_message_queue type is a bounded multi-producer/multi-consumer ring buffer whose push and pop operations
+ * never take a lock unless the caller needs to block (i.e. pushing to a full queue, or popping from an empty queue).
+ * The spsc_message_queue type is a bounded ring buffer of inplace_unique_function objects for the common case where
+ * there is exactly one producer thread and exactly one consumer thread, in which case pushing and popping are
+ * wait-free.
  *
+ * A message_queue can be closed, which wakes up all threads blocked in pop_front (or one of its timed variants). Once
+ * closed, pop operations never block: they continue to hand out any messages still in the queue and then return an
+ * empty function object. This makes consumer loops such as the following exit cleanly on shutdown:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * while (auto func = queue.pop_front())
+ * {
+ *     func();
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <thread>
 
+#include "../inplace_function.h"
 #include "../scope_guard.h"
 
 namespace dhorn
@@ -27,6 +49,9 @@ namespace dhorn
             struct message_queue_types
             {
                 using function_type = std::function<FuncType>;
+
+                // The maximum number of unused nodes that a message_queue will hold onto for re-use
+                static constexpr std::size_t max_free_nodes = 1024;
             };
 
 
@@ -56,10 +81,16 @@ namespace dhorn
                 {
                 }
 
-                ~message_queue_node(void)
+                // NOTE: Nodes do not own 'next'. Lists of nodes must be destroyed iteratively via delete_list, otherwise
+                // destroying a long list would overflow the stack
+                static void delete_list(message_queue_node *pNode) noexcept
                 {
-                    // Recursive delete; NOP if nullptr
-                    delete this->next;
+                    while (pNode)
+                    {
+                        auto next = pNode->next;
+                        delete pNode;
+                        pNode = next;
+                    }
                 }
             };
         }
@@ -81,11 +112,17 @@ namespace dhorn
              * Constructor(s)/Destructor
              */
             message_queue(void) :
-                _size(0),
-                _back(&this->_front)
+                _back(&this->_front),
+                _size(0)
             {
             }
 
+            ~message_queue(void)
+            {
+                details::message_queue_node<MyTypes>::delete_list(this->_front.next);
+                details::message_queue_node<MyTypes>::delete_list(this->_freeList);
+            }
+
             // Cannot copy
             message_queue(const message_queue &other) = delete;
             message_queue &operator=(const message_queue &other) = delete;
@@ -107,28 +144,81 @@ namespace dhorn
             void push_back(const FunctionType &func)
             {
                 // Do all initialization work that does not need to occur under lock first
-                auto pNode = new details::message_queue_node<MyTypes>(func);
+                FunctionType value = func;
+                details::message_queue_node<MyTypes> *pNode = nullptr;
 
                 { // Acquire _backMutex
-                    std::lock_guard<std::mutex> lock(this->_backMutex);
+                    std::unique_lock<std::mutex> lock(this->_backMutex);
+
+                    // Prefer re-using a node from the free list. We only need to allocate (outside of the lock) when the
+                    // free list is empty, which should only happen until the queue reaches its steady state size
+                    pNode = this->PopFreeNode();
+                    if (!pNode)
+                    {
+                        lock.unlock();
+                        pNode = new details::message_queue_node<MyTypes>();
+                        lock.lock();
+                    }
+
+                    // NOTE: Moving a function object should not throw (or allocate)
+                    pNode->func = std::move(value);
 
                     assert(!this->_back->next);
                     this->_back->next = pNode;
                     this->_back = pNode;
                 } // Release _backMutex
 
-                { // Acquire _sizeMutex
-                    std::lock_guard<std::mutex> lock(this->_sizeMutex);
+                this->IncrementSize(1);
+            }
 
-                    ++this->_size;
-                    assert(this->_size);
+            template <typename ForwardItr>
+            void push_back_range(ForwardItr first, ForwardItr last)
+            {
+                // NOTE: This requires (at least) ForwardIterator so that we know how many nodes we need up front
+                auto count = static_cast<std::size_t>(std::distance(first, last));
+                if (count == 0)
+                {
+                    return;
+                }
 
-                    // Check to see if we need to notify any other threads that the queue is no longer empty
-                    if (this->_size == 1)
-                    {
-                        this->_notEmpty.notify_all();
-                    }
-                } // Release _sizeMutex
+                // Build up the chain of nodes outside of the lock, re-using as many nodes from the free list as we can
+                std::pair<details::message_queue_node<MyTypes> *, std::size_t> freeNodes;
+                { // Acquire _backMutex
+                    std::lock_guard<std::mutex> lock(this->_backMutex);
+                    freeNodes = this->PopFreeNodes(count);
+                } // Release _backMutex
+
+                auto head = freeNodes.first;
+                auto cleanup = make_scope_guard([&]()
+                {
+                    details::message_queue_node<MyTypes>::delete_list(head);
+                });
+
+                for (auto i = freeNodes.second; i < count; ++i)
+                {
+                    auto pNode = new details::message_queue_node<MyTypes>();
+                    pNode->next = head;
+                    head = pNode;
+                }
+
+                details::message_queue_node<MyTypes> *tail = nullptr;
+                for (auto pNode = head; pNode; pNode = pNode->next, ++first)
+                {
+                    pNode->func = *first;
+                    tail = pNode;
+                }
+
+                // Now that everything has been constructed, we can't fail; splice the whole chain in at once
+                cleanup.cancel();
+                { // Acquire _backMutex
+                    std::lock_guard<std::mutex> lock(this->_backMutex);
+
+                    assert(!this->_back->next);
+                    this->_back->next = head;
+                    this->_back = tail;
+                } // Release _backMutex
+
+                this->IncrementSize(count);
             }
 
             FunctionType pop_front(void)
@@ -136,11 +226,17 @@ namespace dhorn
                 { // Acquire _sizeMutex
                     std::unique_lock<std::mutex> lock(this->_sizeMutex);
 
-                    while (!this->_size)
+                    while (!this->_size && !this->_closed)
                     {
                         this->_notEmpty.wait(lock);
                     }
 
+                    if (!this->_size)
+                    {
+                        // Closed and empty
+                        return FunctionType{};
+                    }
+
                     // Decrementing the count is equivalent to "reserving" an entry in the queue. It does not necessarily
                     // mean that this thread will get the first value, but that's not really all that important
                     --this->_size;
@@ -149,6 +245,31 @@ namespace dhorn
                 return this->PopFront();
             }
 
+            template <typename Rep, typename Period>
+            FunctionType pop_front_for(const std::chrono::duration<Rep, Period> &timeout)
+            {
+                return this->pop_front_until(std::chrono::steady_clock::now() + timeout);
+            }
+
+            template <typename Clock, typename Duration>
+            FunctionType pop_front_until(const std::chrono::time_point<Clock, Duration> &timeout)
+            {
+                { // Acquire _sizeMutex
+                    std::unique_lock<std::mutex> lock(this->_sizeMutex);
+
+                    // Returns an empty function object on timeout, or if the queue gets closed while we wait
+                    if (!this->_notEmpty.wait_until(lock, timeout, [&]() { return this->_size || this->_closed; }) ||
+                        !this->_size)
+                    {
+                        return FunctionType{};
+                    }
+
+                    --this->_size;
+                } // Release _sizeMutex
+
+                return this->PopFront();
+            }
+
             bool try_pop_front(FunctionType &func)
             {
                 { // Acquire _sizeMutex
@@ -168,6 +289,51 @@ namespace dhorn
                 return true;
             }
 
+            template <typename OutputItr>
+            std::size_t try_pop_front_n(std::size_t count, OutputItr output)
+            {
+                { // Acquire _sizeMutex
+                    std::lock_guard<std::mutex> lock(this->_sizeMutex);
+
+                    // Reserve as many entries as we can in one go
+                    count = std::min(count, this->_size);
+                    this->_size -= count;
+                } // Release _sizeMutex
+
+                return this->PopFrontN(count, std::move(output));
+            }
+
+            template <typename OutputItr>
+            std::size_t drain(OutputItr output)
+            {
+                std::size_t count;
+                { // Acquire _sizeMutex
+                    std::lock_guard<std::mutex> lock(this->_sizeMutex);
+
+                    count = this->_size;
+                    this->_size = 0;
+                } // Release _sizeMutex
+
+                return this->PopFrontN(count, std::move(output));
+            }
+
+            void close(void)
+            {
+                { // Acquire _sizeMutex
+                    std::lock_guard<std::mutex> lock(this->_sizeMutex);
+                    this->_closed = true;
+                } // Release _sizeMutex
+
+                // Wake up everyone so that they can observe that the queue has been closed
+                this->_notEmpty.notify_all();
+            }
+
+            bool closed(void) const
+            {
+                std::lock_guard<std::mutex> lock(this->_sizeMutex);
+                return this->_closed;
+            }
+
 
 
         private:
@@ -175,6 +341,7 @@ namespace dhorn
             FunctionType PopFront(void)
             {
                 // !!! NOTE: _size must have been previously decremented !!!
+                FunctionType result;
                 details::message_queue_node<MyTypes> *pNode;
                 { // Acquire _frontMutex
                     std::lock_guard<std::mutex> lock(this->_frontMutex);
@@ -189,26 +356,662 @@ namespace dhorn
                         {
                             this->_back = &this->_front;
                         }
-                    }// Release _backMutex
+
+                        // Moving the function object out is cheap, so do it now so that the node can go straight back
+                        // onto the free list (which is protected by _backMutex)
+                        result = std::move(pNode->func);
+                        pNode->func = nullptr;
+                        pNode = this->PushFreeNode(pNode);
+                    } // Release _backMutex
                 } // Release _frontMutex
 
-                auto destroy = make_scope_guard([&]()
+                // If the free list was full, the node was handed back to us to delete outside of the lock
+                delete pNode;
+
+                return result;
+            }
+
+            template <typename OutputItr>
+            std::size_t PopFrontN(std::size_t count, OutputItr output)
+            {
+                // !!! NOTE: _size must have been previously decremented by 'count' !!!
+                if (count == 0)
                 {
-                    pNode->next = nullptr;
-                    delete pNode;
+                    return 0;
+                }
+
+                details::message_queue_node<MyTypes> *head;
+                details::message_queue_node<MyTypes> *tail;
+                { // Acquire _frontMutex
+                    std::lock_guard<std::mutex> lock(this->_frontMutex);
+                    head = this->_front.next;
+                    assert(head);
+
+                    // Since we've reserved 'count' entries, the links between the first 'count' nodes are guaranteed to
+                    // be visible and can't be modified by producers, so we only need _frontMutex to walk them
+                    tail = head;
+                    for (std::size_t i = 1; i < count; ++i)
+                    {
+                        tail = tail->next;
+                        assert(tail);
+                    }
+
+                    { // Acquire _backMutex
+                        std::lock_guard<std::mutex> guard(this->_backMutex);
+
+                        this->_front.next = tail->next;
+                        if (tail == this->_back)
+                        {
+                            this->_back = &this->_front;
+                        }
+                        tail->next = nullptr;
+                    } // Release _backMutex
+                } // Release _frontMutex
+
+                // The whole segment is now owned by this thread. Hand off the function objects and recycle the nodes,
+                // even if writing to the output iterator throws (in which case the remaining messages are discarded)
+                auto recycle = make_scope_guard([&]()
+                {
+                    for (auto pNode = head; pNode; pNode = pNode->next)
+                    {
+                        pNode->func = nullptr;
+                    }
+
+                    details::message_queue_node<MyTypes> *leftover;
+                    { // Acquire _backMutex
+                        std::lock_guard<std::mutex> guard(this->_backMutex);
+                        leftover = this->PushFreeNodes(head, tail, count);
+                    } // Release _backMutex
+
+                    details::message_queue_node<MyTypes>::delete_list(leftover);
                 });
 
-                return std::move(pNode->func);
+                for (auto pNode = head; pNode; pNode = pNode->next)
+                {
+                    *output = std::move(pNode->func);
+                    ++output;
+                }
+
+                return count;
+            }
+
+            void IncrementSize(std::size_t count)
+            {
+                { // Acquire _sizeMutex
+                    std::lock_guard<std::mutex> lock(this->_sizeMutex);
+
+                    auto oldSize = this->_size;
+                    this->_size += count;
+                    assert(this->_size > oldSize);
+
+                    // Check to see if we need to notify any other threads that the queue is no longer empty
+                    if (oldSize == 0)
+                    {
+                        this->_notEmpty.notify_all();
+                    }
+                } // Release _sizeMutex
+            }
+
+            details::message_queue_node<MyTypes> *PopFreeNode(void) noexcept
+            {
+                // !!! NOTE: _backMutex must be held !!!
+                auto pNode = this->_freeList;
+                if (pNode)
+                {
+                    this->_freeList = pNode->next;
+                    pNode->next = nullptr;
+                    --this->_freeCount;
+                }
+
+                return pNode;
+            }
+
+            std::pair<details::message_queue_node<MyTypes> *, std::size_t> PopFreeNodes(std::size_t count) noexcept
+            {
+                // !!! NOTE: _backMutex must be held !!!
+                count = std::min(count, this->_freeCount);
+                if (count == 0)
+                {
+                    return { nullptr, 0 };
+                }
+
+                auto head = this->_freeList;
+                auto tail = head;
+                for (std::size_t i = 1; i < count; ++i)
+                {
+                    tail = tail->next;
+                }
+
+                this->_freeList = tail->next;
+                this->_freeCount -= count;
+                tail->next = nullptr;
+                return { head, count };
+            }
+
+            details::message_queue_node<MyTypes> *PushFreeNode(details::message_queue_node<MyTypes> *pNode) noexcept
+            {
+                // !!! NOTE: _backMutex must be held !!!
+                if (this->_freeCount >= MyTypes::max_free_nodes)
+                {
+                    pNode->next = nullptr;
+                    return pNode;
+                }
+
+                pNode->next = this->_freeList;
+                this->_freeList = pNode;
+                ++this->_freeCount;
+                return nullptr;
+            }
+
+            details::message_queue_node<MyTypes> *PushFreeNodes(
+                details::message_queue_node<MyTypes> *head,
+                details::message_queue_node<MyTypes> *tail,
+                std::size_t count) noexcept
+            {
+                // !!! NOTE: _backMutex must be held !!!
+                auto room = (this->_freeCount < MyTypes::max_free_nodes) ? MyTypes::max_free_nodes - this->_freeCount : 0;
+                if (room >= count)
+                {
+                    // Common case; splice the whole list in
+                    tail->next = this->_freeList;
+                    this->_freeList = head;
+                    this->_freeCount += count;
+                    return nullptr;
+                }
+
+                // Otherwise, only keep what fits and give the rest back to the caller to delete outside of the lock
+                for (std::size_t i = 0; i < room; ++i)
+                {
+                    auto pNode = head;
+                    head = head->next;
+
+                    pNode->next = this->_freeList;
+                    this->_freeList = pNode;
+                }
+
+                this->_freeCount += room;
+                return head;
             }
 
             details::message_queue_node<MyTypes> _front;
             details::message_queue_node<MyTypes> *_back;
             std::size_t _size;
 
+            // Nodes that have been popped are kept around for re-use so that steady state traffic doesn't need to go
+            // through the allocator. Protected by _backMutex
+            details::message_queue_node<MyTypes> *_freeList = nullptr;
+            std::size_t _freeCount = 0;
+
+            // Once closed, pop operations no longer block. Protected by _sizeMutex
+            bool _closed = false;
+
             std::mutex _frontMutex;
             std::mutex _backMutex;
-            std::mutex _sizeMutex;
+            mutable std::mutex _sizeMutex;
             std::condition_variable _notEmpty;
         };
+
+
+
+        /*
+         * lock_free_message_queue
+         *
+         * A bounded multi-producer/multi-consumer queue based off of Dmitry Vyukov's array-based queue. Each cell in the
+         * ring buffer carries a sequence number that tells producers and consumers whether or not the cell is ready for
+         * them, so claiming a slot is a single compare-exchange on either the enqueue or dequeue position and no locks
+         * are taken. The capacity is rounded up to the next power of two.
+         *
+         * The push_back and pop_front functions will block if the queue is full or empty respectively. Blocking threads
+         * spin for a short while before parking on a condition variable, and threads that publish/consume a value only
+         * ever touch that condition variable's mutex if they observe that someone is actually parked.
+         */
+        template <typename FuncType>
+        class lock_free_message_queue final
+        {
+            using MyTypes = details::message_queue_types<FuncType>;
+            using FunctionType = typename MyTypes::function_type;
+
+            // Assume 64 byte cache lines; used to keep the producer and consumer positions from false sharing
+            static constexpr std::size_t cache_line_size = 64;
+
+            // Number of times that push_back/pop_front will retry before parking the thread
+            static constexpr std::size_t spin_count = 64;
+
+            struct cell
+            {
+                std::atomic<std::size_t> sequence;
+                FunctionType func;
+            };
+
+        public:
+            /*
+             * Public Types/Constants
+             */
+            static constexpr std::size_t default_capacity = 1024;
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            lock_free_message_queue(void) :
+                lock_free_message_queue(default_capacity)
+            {
+            }
+
+            explicit lock_free_message_queue(std::size_t capacity) :
+                _capacity(RoundCapacity(capacity)),
+                _mask(_capacity - 1),
+                _buffer(std::make_unique<cell[]>(_capacity))
+            {
+                for (std::size_t i = 0; i < this->_capacity; ++i)
+                {
+                    this->_buffer[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            // Cannot copy
+            lock_free_message_queue(const lock_free_message_queue &other) = delete;
+            lock_free_message_queue &operator=(const lock_free_message_queue &other) = delete;
+
+
+
+            /*
+             * Public Functions
+             */
+            std::size_t capacity(void) const noexcept
+            {
+                return this->_capacity;
+            }
+
+            // NOTE: The values returned by size/empty are only snapshots and may be stale by the time they are used
+            std::size_t size(void) const noexcept
+            {
+                auto dequeuePos = this->_dequeuePos.load(std::memory_order_relaxed);
+                auto enqueuePos = this->_enqueuePos.load(std::memory_order_relaxed);
+                return (enqueuePos > dequeuePos) ? std::min(enqueuePos - dequeuePos, this->_capacity) : 0;
+            }
+
+            bool empty(void) const noexcept
+            {
+                return this->size() == 0;
+            }
+
+            void push_back(const FunctionType &func)
+            {
+                // Copy up front so that we aren't copying on every retry
+                FunctionType value = func;
+                for (std::size_t i = 0; i < spin_count; ++i)
+                {
+                    if (this->TryPushBack(value))
+                    {
+                        this->NotifyIfWaiting(this->_waitingConsumers, this->_notEmpty);
+                        return;
+                    }
+
+                    std::this_thread::yield();
+                }
+
+                { // Acquire _waitMutex
+                    std::unique_lock<std::mutex> lock(this->_waitMutex);
+                    this->_waitingProducers.fetch_add(1);
+                    auto stopWaiting = make_scope_guard([&]()
+                    {
+                        this->_waitingProducers.fetch_sub(1);
+                    });
+
+                    // NOTE: The waiting count must be visible before we re-check the queue, otherwise a consumer could
+                    // free up a slot without knowing it needs to wake us
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    while (!this->TryPushBack(value))
+                    {
+                        this->_notFull.wait(lock);
+                    }
+                } // Release _waitMutex
+
+                this->NotifyIfWaiting(this->_waitingConsumers, this->_notEmpty);
+            }
+
+            bool try_push_back(const FunctionType &func)
+            {
+                FunctionType value = func;
+                if (this->TryPushBack(value))
+                {
+                    this->NotifyIfWaiting(this->_waitingConsumers, this->_notEmpty);
+                    return true;
+                }
+
+                return false;
+            }
+
+            FunctionType pop_front(void)
+            {
+                FunctionType result;
+                for (std::size_t i = 0; i < spin_count; ++i)
+                {
+                    if (this->TryPopFront(result))
+                    {
+                        this->NotifyIfWaiting(this->_waitingProducers, this->_notFull);
+                        return result;
+                    }
+
+                    std::this_thread::yield();
+                }
+
+                { // Acquire _waitMutex
+                    std::unique_lock<std::mutex> lock(this->_waitMutex);
+                    this->_waitingConsumers.fetch_add(1);
+                    auto stopWaiting = make_scope_guard([&]()
+                    {
+                        this->_waitingConsumers.fetch_sub(1);
+                    });
+
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    while (!this->TryPopFront(result))
+                    {
+                        this->_notEmpty.wait(lock);
+                    }
+                } // Release _waitMutex
+
+                this->NotifyIfWaiting(this->_waitingProducers, this->_notFull);
+                return result;
+            }
+
+            bool try_pop_front(FunctionType &func)
+            {
+                if (this->TryPopFront(func))
+                {
+                    this->NotifyIfWaiting(this->_waitingProducers, this->_notFull);
+                    return true;
+                }
+
+                return false;
+            }
+
+
+
+        private:
+
+            static std::size_t RoundCapacity(std::size_t capacity)
+            {
+                // Capacity must be a power of two (and at least two so that sequence numbers don't alias)
+                std::size_t result = 2;
+                while (result < capacity)
+                {
+                    result <<= 1;
+                }
+
+                return result;
+            }
+
+            bool TryPushBack(FunctionType &func)
+            {
+                cell *target;
+                auto pos = this->_enqueuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    target = &this->_buffer[pos & this->_mask];
+                    auto seq = target->sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                    if (diff == 0)
+                    {
+                        // The cell is free; try and claim it
+                        if (this->_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // The cell still holds a value from the previous lap; the queue is full
+                        return false;
+                    }
+                    else
+                    {
+                        // Another producer claimed the cell before us
+                        pos = this->_enqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                // NOTE: 'func' is only moved from once we've successfully claimed a slot. Callers are responsible for
+                // waking any parked consumers (this may be called with _waitMutex held)
+                target->func = std::move(func);
+                target->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool TryPopFront(FunctionType &func)
+            {
+                cell *target;
+                auto pos = this->_dequeuePos.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    target = &this->_buffer[pos & this->_mask];
+                    auto seq = target->sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                    if (diff == 0)
+                    {
+                        if (this->_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            break;
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // Nothing has been published to this cell yet; the queue is empty
+                        return false;
+                    }
+                    else
+                    {
+                        pos = this->_dequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+
+                // Hand the cell back to producers for the next lap, even if the move throws
+                auto release = make_scope_guard([&]()
+                {
+                    target->func = nullptr;
+                    target->sequence.store(pos + this->_capacity, std::memory_order_release);
+                });
+
+                func = std::move(target->func);
+                return true;
+            }
+
+            void NotifyIfWaiting(const std::atomic<std::size_t> &waitCount, std::condition_variable &cond)
+            {
+                // Pairs with the fence in push_back/pop_front. Either the waiting thread sees the change we just made, or
+                // we see that it is waiting (or about to wait)
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (waitCount.load(std::memory_order_relaxed))
+                {
+                    // Acquiring the lock guarantees that the waiting thread is either blocked on the condition variable
+                    // or has yet to re-check the queue
+                    std::lock_guard<std::mutex> lock(this->_waitMutex);
+                    cond.notify_one();
+                }
+            }
+
+            const std::size_t _capacity;
+            const std::size_t _mask;
+            std::unique_ptr<cell[]> _buffer;
+
+            alignas(cache_line_size) std::atomic<std::size_t> _enqueuePos{ 0 };
+            alignas(cache_line_size) std::atomic<std::size_t> _dequeuePos{ 0 };
+
+            // Only used when threads need to block
+            alignas(cache_line_size) std::atomic<std::size_t> _waitingProducers{ 0 };
+            std::atomic<std::size_t> _waitingConsumers{ 0 };
+            std::mutex _waitMutex;
+            std::condition_variable _notEmpty;
+            std::condition_variable _notFull;
+        };
+
+
+
+        /*
+         * spsc_message_queue
+         *
+         * A bounded single-producer/single-consumer ring buffer. Exactly one thread may push and exactly one (possibly
+         * different) thread may pop at any given time. The producer only ever writes to the tail index and the consumer
+         * only ever writes to the head index, and each keeps a cached copy of the other's index so that the shared cache
+         * line only needs to be read when the cached value says the queue looks full/empty. The capacity is rounded up to
+         * the next power of two.
+         *
+         * Function objects are stored as inplace_unique_function objects directly in the ring buffer, so pushing and
+         * popping never allocate, and move-only function objects (e.g. ones that capture a std::promise) can be used.
+         * The try_push_back and try_pop_front functions are wait-free. The push_back and pop_front functions spin
+         * (yielding the thread's time slice) while the queue is full/empty.
+         */
+        template <typename FuncType, std::size_t FuncSize = (8 * sizeof(void*))>
+        class spsc_message_queue final
+        {
+            static constexpr std::size_t cache_line_size = 64;
+
+        public:
+            /*
+             * Public Types/Constants
+             */
+            using function_type = inplace_unique_function<FuncType, FuncSize>;
+            static constexpr std::size_t default_capacity = 1024;
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            spsc_message_queue(void) :
+                spsc_message_queue(default_capacity)
+            {
+            }
+
+            explicit spsc_message_queue(std::size_t capacity) :
+                _capacity(RoundCapacity(capacity)),
+                _mask(_capacity - 1),
+                _buffer(std::make_unique<function_type[]>(_capacity))
+            {
+            }
+
+            // Cannot copy
+            spsc_message_queue(const spsc_message_queue &other) = delete;
+            spsc_message_queue &operator=(const spsc_message_queue &other) = delete;
+
+
+
+            /*
+             * Public Functions
+             */
+            std::size_t capacity(void) const noexcept
+            {
+                return this->_capacity;
+            }
+
+            // NOTE: The values returned by size/empty are only snapshots and may be stale by the time they are used
+            std::size_t size(void) const noexcept
+            {
+                auto head = this->_head.load(std::memory_order_acquire);
+                auto tail = this->_tail.load(std::memory_order_acquire);
+                return tail - head;
+            }
+
+            bool empty(void) const noexcept
+            {
+                return this->size() == 0;
+            }
+
+            void push_back(function_type func)
+            {
+                while (!this->try_push_back(func))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            // NOTE: If the queue is full, func is left untouched so that the caller can try again later
+            bool try_push_back(function_type &func)
+            {
+                // NOTE: Only the producer writes to _tail, so a relaxed load is sufficient
+                auto tail = this->_tail.load(std::memory_order_relaxed);
+                if (tail - this->_cachedHead == this->_capacity)
+                {
+                    // Looks full; refresh our view of the consumer's position
+                    this->_cachedHead = this->_head.load(std::memory_order_acquire);
+                    if (tail - this->_cachedHead == this->_capacity)
+                    {
+                        return false;
+                    }
+                }
+
+                this->_buffer[tail & this->_mask] = std::move(func);
+                this->_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool try_push_back(function_type &&func)
+            {
+                return this->try_push_back(func);
+            }
+
+            function_type pop_front(void)
+            {
+                function_type result;
+                while (!this->try_pop_front(result))
+                {
+                    std::this_thread::yield();
+                }
+
+                return result;
+            }
+
+            bool try_pop_front(function_type &func)
+            {
+                // NOTE: Only the consumer writes to _head, so a relaxed load is sufficient
+                auto head = this->_head.load(std::memory_order_relaxed);
+                if (head == this->_cachedTail)
+                {
+                    // Looks empty; refresh our view of the producer's position
+                    this->_cachedTail = this->_tail.load(std::memory_order_acquire);
+                    if (head == this->_cachedTail)
+                    {
+                        return false;
+                    }
+                }
+
+                auto &slot = this->_buffer[head & this->_mask];
+                func = std::move(slot);
+                slot = nullptr;
+                this->_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+
+
+        private:
+
+            static std::size_t RoundCapacity(std::size_t capacity)
+            {
+                std::size_t result = 1;
+                while (result < capacity)
+                {
+                    result <<= 1;
+                }
+
+                return result;
+            }
+
+            const std::size_t _capacity;
+            const std::size_t _mask;
+            std::unique_ptr<function_type[]> _buffer;
+
+            // Consumer owned
+            alignas(cache_line_size) std::atomic<std::size_t> _head{ 0 };
+            std::size_t _cachedTail = 0;
+
+            // Producer owned
+            alignas(cache_line_size) std::atomic<std::size_t> _tail{ 0 };
+            std::size_t _cachedHead = 0;
+        };
     }
 }
@@ -0,0 +1,268 @@
+/*
+ * Duncan Horn
+ *
+ * rcu_object.h
+ *
+ * A container for read-mostly shared state that uses read-copy-update semantics. The rcu_object always holds a pointer
+ * to an immutable value. Readers call read to get a read_guard, which is a cheap handle to the current value that stays
+ * valid for as long as the guard is alive, no matter how many times the value gets replaced in the meantime. Writers
+ * build an entirely new value and atomically publish it, either via publish or via update, which hands the current
+ * value to a function that creates its replacement. Writers serialize with one another, but never with readers.
+ *
+ * E.g.
+ *
+ *      rcu_object<std::map<std::string, route>> routes;
+ *      ...
+ *      // Readers
+ *      auto guard = routes.read();
+ *      auto itr = guard->find(name);
+ *      ...
+ *      // Writers
+ *      routes.update([&](const auto &current)
+ *      {
+ *          auto result = current;
+ *          result[name] = newRoute;
+ *          return result;
+ *      });
+ *
+ * Old values are reclaimed using epochs. Readers announce themselves by incrementing one of two counters, selected by
+ * the parity of the current epoch, before loading the current value. Each value that a writer replaces is stashed in a
+ * retire list tagged with the current epoch, and the writer then tries to advance the epoch. The epoch can only advance
+ * from e to e + 1 once all readers of the parity that e + 1 maps to (i.e. readers who announced themselves during epoch
+ * e - 1) have released their guards. Therefore, a value that was retired in epoch e can no longer be referenced by any
+ * reader once the epoch has reached e + 2. Writers never wait for readers, so it is safe to publish while holding a
+ * read_guard, however retired values will stick around until a later write (or call to synchronize) once the guard has
+ * been released. The synchronize function blocks until all retired values have been freed, so it must not be called
+ * while the calling thread holds a read_guard.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dhorn
+{
+    namespace experimental
+    {
+        /*
+         * rcu_object
+         */
+        template <typename Ty>
+        class rcu_object final
+        {
+        public:
+            /*
+             * Public Types
+             */
+            using value_type = Ty;
+
+            class read_guard final
+            {
+                friend class rcu_object;
+
+            public:
+                read_guard(read_guard &&other) noexcept :
+                    _owner(other._owner),
+                    _parity(other._parity),
+                    _value(other._value)
+                {
+                    other._owner = nullptr;
+                    other._value = nullptr;
+                }
+
+                ~read_guard(void)
+                {
+                    if (this->_owner)
+                    {
+                        this->_owner->_readers[this->_parity].fetch_sub(1, std::memory_order_release);
+                    }
+                }
+
+                // Cannot copy
+                read_guard(const read_guard &) = delete;
+                read_guard &operator=(const read_guard &) = delete;
+                read_guard &operator=(read_guard &&) = delete;
+
+                const Ty &operator*(void) const noexcept
+                {
+                    return *this->_value;
+                }
+
+                const Ty *operator->(void) const noexcept
+                {
+                    return this->_value;
+                }
+
+                const Ty *get(void) const noexcept
+                {
+                    return this->_value;
+                }
+
+            private:
+
+                read_guard(const rcu_object *owner, std::size_t parity, const Ty *value) noexcept :
+                    _owner(owner),
+                    _parity(parity),
+                    _value(value)
+                {
+                }
+
+                const rcu_object *_owner;
+                std::size_t _parity;
+                const Ty *_value;
+            };
+
+
+
+            /*
+             * Constructor(s)/Destructor
+             */
+            rcu_object(void) :
+                rcu_object(Ty{})
+            {
+            }
+
+            explicit rcu_object(Ty value) :
+                _value(new Ty(std::move(value)))
+            {
+            }
+
+            ~rcu_object(void)
+            {
+                // NOTE: There cannot be any readers at this point, so everything can be freed
+                delete this->_value.load(std::memory_order_relaxed);
+                for (auto &entry : this->_retired)
+                {
+                    delete entry.second;
+                }
+            }
+
+            // Cannot copy or move
+            rcu_object(const rcu_object &) = delete;
+            rcu_object &operator=(const rcu_object &) = delete;
+
+
+
+            /*
+             * Readers
+             */
+            read_guard read(void) const noexcept
+            {
+                std::size_t epoch;
+                while (true)
+                {
+                    epoch = this->_epoch.load();
+                    this->_readers[epoch & 1].fetch_add(1);
+
+                    // If the epoch changed before we announced ourselves, the writer may not have seen us
+                    if (this->_epoch.load() == epoch)
+                    {
+                        break;
+                    }
+
+                    this->_readers[epoch & 1].fetch_sub(1, std::memory_order_release);
+                }
+
+                return read_guard(this, epoch & 1, this->_value.load(std::memory_order_acquire));
+            }
+
+
+
+            /*
+             * Writers
+             */
+            void publish(Ty value)
+            {
+                this->publish(std::make_unique<Ty>(std::move(value)));
+            }
+
+            void publish(std::unique_ptr<Ty> value)
+            {
+                // Acquire _writeMutex
+                std::lock_guard<std::mutex> lock(this->_writeMutex);
+                this->Publish(std::move(value));
+                // Release _writeMutex
+            }
+
+            template <typename Func>
+            void update(const Func &func)
+            {
+                // Acquire _writeMutex
+                std::lock_guard<std::mutex> lock(this->_writeMutex);
+
+                // NOTE: Writers are serialized, so the current value can't go away while we're using it
+                const Ty &current = *this->_value.load(std::memory_order_relaxed);
+                this->Publish(std::make_unique<Ty>(func(current)));
+                // Release _writeMutex
+            }
+
+            void synchronize(void)
+            {
+                while (true)
+                {
+                    {
+                        // Acquire _writeMutex
+                        std::lock_guard<std::mutex> lock(this->_writeMutex);
+                        this->Reclaim();
+                        if (this->_retired.empty())
+                        {
+                            return;
+                        }
+                        // Release _writeMutex
+                    }
+
+                    std::this_thread::yield();
+                }
+            }
+
+
+
+        private:
+
+            void Publish(std::unique_ptr<Ty> value)
+            {
+                // NOTE: Must be called with _writeMutex held
+                this->_retired.reserve(this->_retired.size() + 1);
+                auto old = this->_value.exchange(value.release());
+                this->_retired.emplace_back(this->_epoch.load(std::memory_order_relaxed), old);
+                this->Reclaim();
+            }
+
+            void Reclaim(void)
+            {
+                // NOTE: Must be called with _writeMutex held. Advance the epoch as far as we can (at most twice, which is
+                // enough to reclaim everything that's been retired when there are no active readers)
+                auto epoch = this->_epoch.load(std::memory_order_relaxed);
+                for (int i = 0; (i < 2) && (this->_readers[(epoch + 1) & 1].load() == 0); ++i)
+                {
+                    this->_epoch.store(++epoch);
+                }
+
+                // Anything retired two or more epochs ago can no longer be referenced by any reader
+                auto end = std::partition(this->_retired.begin(), this->_retired.end(), [&](const auto &entry)
+                {
+                    return (entry.first + 2) > epoch;
+                });
+
+                for (auto itr = end; itr != this->_retired.end(); ++itr)
+                {
+                    delete itr->second;
+                }
+                this->_retired.erase(end, this->_retired.end());
+            }
+
+            std::atomic<Ty *> _value;
+            mutable std::atomic_size_t _epoch{ 0 };
+            mutable std::atomic_size_t _readers[2] = {};
+
+            // Protected by _writeMutex
+            std::vector<std::pair<std::size_t, Ty *>> _retired;
+            std::mutex _writeMutex;
+        };
+    }
+}
@@ -22,15 +22,108 @@
  * The synchronized_object class also provides the lock function which allows a LockType (e.g. std::lock_guard, etc.)
  * as well as an optional std::defer_lock_t or std::try_to_lock_t. Note that an overload for std::adopt_lock_t is not
  * provided since such an operation would not exist (you cannot lock in a non-RAII way).
+ *
+ * When the mutex type supports shared ownership (e.g. std::shared_mutex), readers can use execute_with_shared_lock and
+ * copy_shared_locked, which acquire the mutex via std::shared_lock and only hand out const access to the value.
+ *
+ * Finally, synchronized_object can be used with the seqlock "mutex" type for small, trivially copyable values that are
+ * read far more often than they are written. Writers still serialize with one another, but readers never write to
+ * memory that is shared with other threads. Instead, they optimistically copy the value and retry if a write happened
+ * at the same time. Since readers only ever see a copy of the value, this specialization has a reduced interface:
+ * execute_with_shared_lock passes only a const reference to a consistent copy of the value (readers don't hold any lock
+ * that could be passed along). execute_with_lock still passes the lock as its second argument (std::lock_guard<seqlock>
+ * by default), but the first argument is a reference to a copy of the value that gets published once the function
+ * returns. The lock must therefore be held when the function returns.
  */
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
 
 namespace dhorn
 {
     namespace experimental
     {
+        /*
+         * seqlock
+         *
+         * A sequence lock. Writers serialize with one another using lock/unlock (and therefore seqlock can be used with
+         * std::lock_guard, etc.) and bump the sequence number to an odd value for the duration of the write. Readers
+         * don't acquire anything; they call read_begin, read the data, and then call read_retry to see if a write may
+         * have happened concurrently, in which case the data they read may be inconsistent and they must try again.
+         * Data protected by a seqlock must therefore be accessed with atomic operations, even if relaxed.
+         */
+        class seqlock
+        {
+        public:
+            seqlock(void) = default;
+
+            // Cannot copy
+            seqlock(const seqlock &) = delete;
+            seqlock &operator=(const seqlock &) = delete;
+
+
+
+            /*
+             * Writers
+             */
+            void lock(void)
+            {
+                this->_writeMutex.lock();
+                this->_sequence.store(this->_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            void unlock(void)
+            {
+                this->_sequence.store(this->_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                this->_writeMutex.unlock();
+            }
+
+
+
+            /*
+             * Readers
+             */
+            std::size_t read_begin(void) const noexcept
+            {
+                while (true)
+                {
+                    auto sequence = this->_sequence.load(std::memory_order_acquire);
+                    if ((sequence & 1) == 0)
+                    {
+                        return sequence;
+                    }
+
+                    // A write is in progress
+                    std::this_thread::yield();
+                }
+            }
+
+            bool read_retry(std::size_t sequence) const noexcept
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return this->_sequence.load(std::memory_order_relaxed) != sequence;
+            }
+
+
+
+        private:
+
+            std::atomic_size_t _sequence{ 0 };
+            std::mutex _writeMutex;
+        };
+
+
+
+        /*
+         * synchronized_object
+         */
         template <typename Ty, typename MutexType = std::mutex>
         class synchronized_object
         {
@@ -63,6 +156,13 @@ namespace dhorn
                 fn(this->_value, lock);
             }
 
+            template <typename Func>
+            void execute_with_shared_lock(const Func &fn) const
+            {
+                std::shared_lock<MutexType> lock(this->_mutex);
+                fn(this->_value, lock);
+            }
+
             template <typename Func>
             void execute_without_lock(const Func &fn)
             {
@@ -100,6 +200,12 @@ namespace dhorn
                 return this->_value;
             }
 
+            Ty copy_shared_locked(void) const
+            {
+                std::shared_lock<MutexType> lock(this->_mutex);
+                return this->_value;
+            }
+
             void set_unlocked(const Ty &value)
             {
                 this->_value = value;
@@ -140,7 +246,120 @@ namespace dhorn
         private:
 
             Ty _value;
-            MutexType _mutex;
+            mutable MutexType _mutex;
+        };
+
+
+
+        /*
+         * synchronized_object<Ty, seqlock>
+         */
+        template <typename Ty>
+        class synchronized_object<Ty, seqlock>
+        {
+            static_assert(std::is_trivially_copyable_v<Ty> && std::is_default_constructible_v<Ty>,
+                "synchronized_object with seqlock requires a trivially copyable, default constructible type");
+
+            using word_type = std::uintptr_t;
+            static constexpr std::size_t word_count = (sizeof(Ty) + sizeof(word_type) - 1) / sizeof(word_type);
+
+        public:
+            /*
+             * Constructor(s)/Destructor
+             */
+            synchronized_object() :
+                synchronized_object(Ty{})
+            {
+            }
+
+            synchronized_object(Ty value)
+            {
+                this->Store(value);
+            }
+
+            // Cannot copy
+            synchronized_object(const synchronized_object &) = delete;
+            synchronized_object &operator=(const synchronized_object &) = delete;
+
+
+
+            /*
+             * Execution
+             */
+            template <typename LockType = std::lock_guard<seqlock>, typename Func>
+            void execute_with_lock(const Func &fn)
+            {
+                LockType lock(this->_lock);
+                auto value = this->Load();
+                fn(value, lock);
+                this->Store(value);
+            }
+
+            template <typename Func>
+            void execute_with_shared_lock(const Func &fn) const
+            {
+                const auto value = this->copy_shared_locked();
+                fn(value);
+            }
+
+
+
+            /*
+             * Value get/set
+             */
+            Ty copy_locked(void) const
+            {
+                return this->copy_shared_locked();
+            }
+
+            Ty copy_shared_locked(void) const
+            {
+                while (true)
+                {
+                    auto sequence = this->_lock.read_begin();
+                    auto value = this->Load();
+                    if (!this->_lock.read_retry(sequence))
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            void set_locked(const Ty &value)
+            {
+                std::lock_guard<seqlock> lock(this->_lock);
+                this->Store(value);
+            }
+
+
+
+        private:
+
+            Ty Load(void) const noexcept
+            {
+                word_type words[word_count];
+                for (std::size_t i = 0; i < word_count; ++i)
+                {
+                    words[i] = this->_words[i].load(std::memory_order_relaxed);
+                }
+
+                Ty result;
+                std::memcpy(&result, words, sizeof(Ty));
+                return result;
+            }
+
+            void Store(const Ty &value) noexcept
+            {
+                word_type words[word_count] = {};
+                std::memcpy(words, &value, sizeof(Ty));
+                for (std::size_t i = 0; i < word_count; ++i)
+                {
+                    this->_words[i].store(words[i], std::memory_order_relaxed);
+                }
+            }
+
+            seqlock _lock;
+            std::atomic<word_type> _words[word_count];
         };
     }
 }
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <memory>
 
@@ -566,8 +567,7 @@ namespace dhorn
             utf_string(void) :
                 _length(0),
                 _front(nullptr),
-                _back(nullptr),
-                _bounds(nullptr)
+                _heap{ nullptr, nullptr }
             {
             }
 
@@ -587,7 +587,7 @@ namespace dhorn
             utf_string(utf_string &&other) :
                 utf_string()
             {
-                this->swap(other);
+                this->MoveFrom(other);
             }
 
             template <typename CharType>
@@ -726,17 +726,17 @@ namespace dhorn
 
             iterator end(void) noexcept
             {
-                return iterator(this->_back);
+                return iterator(this->Back());
             }
 
             const_iterator end(void) const noexcept
             {
-                return const_iterator(this->_back);
+                return const_iterator(this->Back());
             }
 
             const_iterator cend(void) const noexcept
             {
-                return const_iterator(this->_back);
+                return const_iterator(this->Back());
             }
 
             reverse_iterator rend(void) noexcept
@@ -838,11 +838,21 @@ namespace dhorn
              */
             void swap(utf_string &other)
             {
-                using std::swap;
-                swap(this->_front, other._front);
-                swap(this->_back, other._back);
-                swap(this->_bounds, other._bounds);
-                swap(this->_length, other._length);
+                if (!this->IsSmall() && !other.IsSmall())
+                {
+                    using std::swap;
+                    swap(this->_front, other._front);
+                    swap(this->_heap, other._heap);
+                    swap(this->_length, other._length);
+                }
+                else
+                {
+                    // Pointers into an inline buffer can't be exchanged, so move the contents instead
+                    utf_string temp;
+                    temp.MoveFrom(other);
+                    other.MoveFrom(*this);
+                    this->MoveFrom(temp);
+                }
             }
 
 
@@ -851,6 +861,11 @@ namespace dhorn
 
             static const std::size_t max_char_size = sizeof(char32_t) / sizeof(value_type);
 
+            // Strings whose buffer (including the null character) fits in this many code units are stored inline and
+            // don't allocate. Large enough to hold 15 UTF-8, 7 UTF-16, or 3 UTF-32 code units. The inline buffer shares
+            // storage with the heap buffer's back/bounds pointers, so it doesn't make the string any bigger
+            static constexpr std::size_t small_capacity = (2 * sizeof(value_type *)) / sizeof(value_type);
+
             // Returns pair (length, buffer size)
             template <typename CharType>
             static std::pair<std::size_t, std::size_t> BufferSizeFromStringLiteral(const CharType *str)
@@ -882,20 +897,21 @@ namespace dhorn
 
             inline bool Inside(const CharT *str) const
             {
-                return (str >= this->_front) && (str < this->_bounds);
+                return (str >= this->_front) && (str < this->Bounds());
             }
 
             inline void FinishString()
             {
-                assert(this->_back < this->_bounds);
-                *this->_back = '\0';
+                assert(this->Back() < this->Bounds());
+                *this->Back() = '\0';
             }
 
             inline void Copy(const CharT *str, std::size_t length, std::size_t bufferSize)
             {
-                assert(this->_back + bufferSize < this->_bounds);
-                memcpy(this->_back, str, bufferSize * sizeof(value_type));
-                this->_back += bufferSize;
+                auto back = this->Back();
+                assert(back + bufferSize < this->Bounds());
+                memcpy(back, str, bufferSize * sizeof(value_type));
+                this->SetBack(back + bufferSize);
                 this->_length += length;
             }
 
@@ -1099,27 +1115,29 @@ namespace dhorn
 
             inline void Destroy(void)
             {
-                delete[] this->_front;
+                if (!this->IsSmall())
+                {
+                    delete[] this->_front;
+                }
 
                 this->_front = nullptr;
-                this->_back = nullptr;
-                this->_bounds = nullptr;
+                this->_heap = { nullptr, nullptr };
                 this->_length = 0;
             }
 
             inline void InternalPushBack(char32_t ch)
             {
                 // Determine if we need to resize
-                if ((this->_back + max_char_size) >= this->_bounds)
+                if ((this->Back() + max_char_size) >= this->Bounds())
                 {
                     this->Resize(this->Capacity() * 2);
                 }
 
                 // Increase length after the write in case an exception is thrown
                 // NOTE: Does not write the null character; that's the caller's responsibility
-                this->_back = Traits::write(ch, this->_back);
+                this->SetBack(Traits::write(ch, this->Back()));
                 ++this->_length;
-                assert(this->_back < this->_bounds);
+                assert(this->Back() < this->Bounds());
             }
 
             inline void Resize(std::size_t desiredCapacity)
@@ -1130,17 +1148,31 @@ namespace dhorn
                 assert(capacity >= (bufferSize + max_char_size + 1));
 
                 // Don't resize if we don't need to
-                if (capacity != currentCapacity)
+                if ((capacity != currentCapacity) && !this->_front && (capacity <= small_capacity))
+                {
+                    // Small enough to use the inline buffer. Since the buffer can't grow in place, use all of it
+                    this->_front = this->_buffer;
+                    this->SetBack(this->_front);
+                    *this->_front = '\0';
+                }
+                else if (capacity != currentCapacity)
                 {
                     // Don't copy the null character since this->_front is null on creation
                     std::unique_ptr<value_type[]> buffer(new value_type[capacity]);
-                    memcpy(buffer.get(), this->_front, bufferSize * sizeof(value_type));
+                    if (bufferSize)
+                    {
+                        memcpy(buffer.get(), this->_front, bufferSize * sizeof(value_type));
+                    }
                     buffer.get()[bufferSize] = '\0';
 
-                    delete[] this->_front;
+                    if (!this->IsSmall())
+                    {
+                        delete[] this->_front;
+                    }
+
+                    // NOTE: The inline buffer (if any) is overwritten here, but its contents have already been copied
                     this->_front = buffer.release();
-                    this->_back = this->_front + bufferSize;
-                    this->_bounds = this->_front + capacity;
+                    this->_heap = { this->_front + bufferSize, this->_front + capacity };
                 }
             }
 
@@ -1148,24 +1180,95 @@ namespace dhorn
             {
                 // Size (in units of value_type) of the string *NOT* inluding the null character. I.e. the size that we
                 // need to copy on resize
-                return (this->_back - this->_front);
+                return (this->Back() - this->_front);
             }
 
             inline std::size_t Capacity(void) const noexcept
             {
                 // Size of our internal buffer (includes the null character)
-                return (this->_bounds - this->_front);
+                return (this->Bounds() - this->_front);
             }
 
             inline bool OwnsIterator(const_iterator itr) const noexcept
             {
-                return (itr._ptr >= this->_front) && (itr._ptr <= this->_back);
+                return (itr._ptr >= this->_front) && (itr._ptr <= this->Back());
+            }
+
+            inline bool IsSmall(void) const noexcept
+            {
+                return this->_front == this->_buffer;
+            }
+
+            inline value_type *Back(void) const noexcept
+            {
+                // Inline buffers don't have room for a back pointer. Instead, the last code unit holds the number of
+                // unused code units. Once the buffer is full, that count is zero and doubles as the null character
+                if (this->IsSmall())
+                {
+                    auto unused = static_cast<std::size_t>(this->_buffer[small_capacity - 1]);
+                    return this->_front + (small_capacity - 1 - unused);
+                }
+
+                return this->_heap.back;
+            }
+
+            inline void SetBack(value_type *back) noexcept
+            {
+                if (this->IsSmall())
+                {
+                    auto unused = small_capacity - 1 - static_cast<std::size_t>(back - this->_front);
+                    this->_buffer[small_capacity - 1] = static_cast<value_type>(unused);
+                }
+                else
+                {
+                    this->_heap.back = back;
+                }
+            }
+
+            inline value_type *Bounds(void) const noexcept
+            {
+                return this->IsSmall() ? (this->_front + small_capacity) : this->_heap.bounds;
             }
 
+            void MoveFrom(utf_string &other) noexcept
+            {
+                // Takes the contents of other, leaving it empty. Assumes that this is uninitialized (i.e.
+                // this->_front == nullptr). Heap buffers change owner, but inline buffers need to be copied
+                assert(!this->_front);
+                if (other.IsSmall())
+                {
+                    // Includes the unused code unit count, so there's no need to call SetBack
+                    memcpy(this->_buffer, other._buffer, sizeof(this->_buffer));
+                    this->_front = this->_buffer;
+                }
+                else
+                {
+                    this->_front = other._front;
+                    this->_heap = other._heap;
+                }
+
+                this->_length = other._length;
+                other._front = nullptr;
+                other._heap = { nullptr, nullptr };
+                other._length = 0;
+            }
+
+            struct heap_buffer
+            {
+                value_type *back;       // Always points at the null character
+                value_type *bounds;     // Always points one past the last location we can write to
+            };
+
             std::size_t _length;
             value_type *_front;     // Always points at first character
-            value_type *_back;      // Always points at the null character
-            value_type *_bounds;    // Always points one past the last location we can write to
+
+            // Short strings use the inline buffer instead of a heap allocation (see small_capacity), in which case
+            // _front points at _buffer. Use Back()/Bounds() instead of accessing _heap directly
+            union
+            {
+                heap_buffer _heap;
+                value_type _buffer[small_capacity];
+            };
         };
 
 
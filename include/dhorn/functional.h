@@ -7,7 +7,10 @@
  */
 #pragma once
 
+#include <cassert>
+#include <functional>
 #include <memory>
+#include <type_traits>
 
 namespace dhorn
 {
@@ -32,4 +35,105 @@ namespace dhorn
             (*sharedFunc)(std::forward<decltype(args)>(args)...);
         };
     }
+
+
+
+    /*
+     * function_ref
+     *
+     * A non-owning reference to a callable object. Like std::function, it type erases the callable, but it never copies
+     * or allocates; it's just a pointer to the object (or the function pointer itself) plus a pointer to a function that
+     * knows how to invoke it, so it is cheap to pass by value. This makes it a good fit for function parameters that are
+     * only invoked during the call, since the function accepting it does not need to be a template. Since it does not
+     * own the callable, a function_ref must not outlive the object it was constructed from.
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * void for_each_item(function_ref<void(const item&)> func);
+     * ...
+     * for_each_item([&](const item& value) { ... });
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     */
+    template <typename Func>
+    class function_ref;
+
+    template <typename ReturnTy, typename... ArgsTy>
+    class function_ref<ReturnTy(ArgsTy...)>
+    {
+        union storage
+        {
+            void* object;
+            void (*function)();
+        };
+
+        template <typename Func>
+        static constexpr bool is_function_pointer =
+            std::is_pointer_v<Func> && std::is_function_v<std::remove_pointer_t<Func>>;
+
+        template <typename Func>
+        static ReturnTy invoke_target(Func&& func, ArgsTy&&... args)
+        {
+            if constexpr (std::is_void_v<ReturnTy>)
+            {
+                std::invoke(std::forward<Func>(func), std::forward<ArgsTy>(args)...);
+            }
+            else
+            {
+                return std::invoke(std::forward<Func>(func), std::forward<ArgsTy>(args)...);
+            }
+        }
+
+    public:
+        /*
+         * Constructor(s)/Destructor
+         */
+        template <
+            typename Func,
+            std::enable_if_t<std::conjunction_v<
+                std::negation<std::is_same<std::decay_t<Func>, function_ref>>,
+                std::is_invocable_r<ReturnTy, Func&, ArgsTy...>>, int> = 0>
+        function_ref(Func&& func) noexcept
+        {
+            using func_type = std::remove_reference_t<Func>;
+            if constexpr (std::is_function_v<func_type> || is_function_pointer<std::decay_t<Func>>)
+            {
+                // Function pointers are stored by value so that references to temporaries (e.g. &foo) don't dangle
+                using pointer_type = std::decay_t<Func>;
+                pointer_type ptr = func;
+                assert(ptr);
+
+                this->_storage.function = reinterpret_cast<void (*)()>(ptr);
+                this->_invoke = [](storage data, ArgsTy&&... args) -> ReturnTy
+                {
+                    return invoke_target(reinterpret_cast<pointer_type>(data.function), std::forward<ArgsTy>(args)...);
+                };
+            }
+            else
+            {
+                this->_storage.object = const_cast<void*>(static_cast<const void*>(std::addressof(func)));
+                this->_invoke = [](storage data, ArgsTy&&... args) -> ReturnTy
+                {
+                    return invoke_target(*static_cast<func_type*>(data.object), std::forward<ArgsTy>(args)...);
+                };
+            }
+        }
+
+        function_ref(const function_ref&) noexcept = default;
+        function_ref& operator=(const function_ref&) noexcept = default;
+
+
+
+        /*
+         * Operators
+         */
+        ReturnTy operator()(ArgsTy... args) const
+        {
+            return this->_invoke(this->_storage, std::forward<ArgsTy>(args)...);
+        }
+
+
+
+    private:
+
+        storage _storage;
+        ReturnTy (*_invoke)(storage, ArgsTy&&...);
+    };
 }
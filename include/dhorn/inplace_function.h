@@ -6,21 +6,102 @@
  * Intended to function like std::experimental::inplace_function. That is, it's more-or-less functionally equivalent to
  * std::function only it *never* allocates memory, failing to compile if the size of the underlying function object is
  * larger than the space designated within the inplace_function object.
+ *
+ * The inplace_unique_function type is the move-only counterpart to inplace_function. It has the same fixed size
+ * storage, but does not require that the function object it holds be copyable (e.g. lambdas that capture a
+ * std::unique_ptr or a std::promise), and in turn cannot be copied itself. An inplace_function can be converted to an
+ * inplace_unique_function (of equal or larger size), but not the other way around. Both are aliases for
+ * basic_inplace_function.
+ *
+ * Function objects that are trivially copyable (e.g. function pointers and lambdas that only capture pointers or other
+ * trivial values) are copied and moved with a plain memcpy and are never explicitly destroyed. The function used to
+ * invoke the function object is stored directly within the inplace_function, so calls only cost a single indirect call.
+ *
+ * How function objects that are too large to fit inline get handled is controlled by basic_inplace_function's storage
+ * policy. The default, inplace_storage_policy, fails to compile. The hybrid_function and hybrid_unique_function aliases
+ * instead use heap_fallback_storage_policy, which stores the function object in heap allocated memory, keeping only a
+ * pointer to it inline. Small function objects are still stored inline, and the is_allocated function reports which of
+ * the two is the case. Custom storage policies (e.g. for allocating out of a pool) should look like:
+ *
+ *      struct my_storage_policy
+ *      {
+ *          static constexpr bool allows_allocation = true;
+ *          static void* allocate(std::size_t size, std::size_t alignment);
+ *          static void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept;
+ *      };
  */
 #pragma once
 
 #include <cassert>
+#include <cstring>
 #include <functional>
+#include <new>
+#include <typeinfo>
 
 #include "scope_guard.h"
 
 namespace dhorn
 {
     /*
-     * inplace_function Declaration
+     * Storage Policies
+     */
+    struct inplace_storage_policy
+    {
+        static constexpr bool allows_allocation = false;
+    };
+
+    struct heap_fallback_storage_policy
+    {
+        static constexpr bool allows_allocation = true;
+
+        static void* allocate(std::size_t size, std::size_t alignment)
+        {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            {
+                return ::operator new(size, std::align_val_t(alignment));
+            }
+
+            return ::operator new(size);
+        }
+
+        static void deallocate(void* ptr, [[maybe_unused]] std::size_t size, std::size_t alignment) noexcept
+        {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            {
+                ::operator delete(ptr, std::align_val_t(alignment));
+            }
+            else
+            {
+                ::operator delete(ptr);
+            }
+        }
+    };
+
+
+
+    /*
+     * basic_inplace_function Declaration
      */
+    template <typename Func, std::size_t Size, bool Copyable, typename StoragePolicy = inplace_storage_policy>
+    class basic_inplace_function;
+
     template <typename Func, std::size_t Size = (8 * sizeof(void*))>
-    class inplace_function;
+    using inplace_function = basic_inplace_function<Func, Size, true>;
+
+    template <typename Func, std::size_t Size = (8 * sizeof(void*))>
+    using inplace_unique_function = basic_inplace_function<Func, Size, false>;
+
+    template <
+        typename Func,
+        std::size_t Size = (8 * sizeof(void*)),
+        typename StoragePolicy = heap_fallback_storage_policy>
+    using hybrid_function = basic_inplace_function<Func, Size, true, StoragePolicy>;
+
+    template <
+        typename Func,
+        std::size_t Size = (8 * sizeof(void*)),
+        typename StoragePolicy = heap_fallback_storage_policy>
+    using hybrid_unique_function = basic_inplace_function<Func, Size, false, StoragePolicy>;
 
 
 
@@ -34,8 +115,8 @@ namespace dhorn
         {
         };
 
-        template <typename Func, std::size_t Size>
-        struct is_inplace_function<inplace_function<Func, Size>> : std::true_type
+        template <typename Func, std::size_t Size, bool Copyable, typename StoragePolicy>
+        struct is_inplace_function<basic_inplace_function<Func, Size, Copyable, StoragePolicy>> : std::true_type
         {
         };
 
@@ -47,10 +128,20 @@ namespace dhorn
         template <typename InplaceFunction, typename Func>
         struct is_inplace_function_constructible;
 
-        template <typename ReturnTy, typename... ArgsTy, std::size_t Size, typename Func>
-        struct is_inplace_function_constructible<inplace_function<ReturnTy(ArgsTy...), Size>, Func> : std::conjunction<
-            std::negation<is_inplace_function<Func>>,
-            std::is_invocable_r<ReturnTy, Func, ArgsTy...>>
+        template <
+            typename ReturnTy,
+            typename... ArgsTy,
+            std::size_t Size,
+            bool Copyable,
+            typename StoragePolicy,
+            typename Func>
+        struct is_inplace_function_constructible<
+            basic_inplace_function<ReturnTy(ArgsTy...), Size, Copyable, StoragePolicy>,
+            Func> :
+            std::conjunction<
+                std::negation<is_inplace_function<Func>>,
+                std::is_invocable_r<ReturnTy, Func, ArgsTy...>,
+                std::disjunction<std::bool_constant<!Copyable>, std::is_copy_constructible<Func>>>
         {
         };
 
@@ -84,75 +175,247 @@ namespace dhorn
 
 
         /*
-         * function_base
+         * invoke_arg_t
          *
-         * The base invokable type used by inplace_function
+         * The type used to pass arguments through to the function object. Scalars are passed by value so that they can
+         * stay in registers; everything else is passed by reference
          */
+        template <typename Ty>
+        using invoke_arg_t = std::conditional_t<std::is_scalar_v<Ty>, Ty, Ty&&>;
+
+        template <typename ReturnTy, typename... ArgsTy>
+        using invoke_function_t = ReturnTy (*)(void* data, invoke_arg_t<ArgsTy>... args);
+
         template <typename ReturnTy, typename... ArgsTy>
-        struct function_base
+        ReturnTy null_invoke(void*, invoke_arg_t<ArgsTy>...)
         {
-            virtual ~function_base() {}
+            throw std::bad_function_call();
+        }
+
 
-            virtual function_base* copy(void*) = 0;
-            virtual function_base* move(void*) = 0;
-            virtual ReturnTy invoke(ArgsTy&&...) = 0;
-            virtual const std::type_info& target_type() noexcept = 0;
-            virtual void* target(const std::type_info& type) noexcept = 0;
+
+        /*
+         * function_ops
+         *
+         * A manually constructed v-table for the function object held by a basic_inplace_function. The function object
+         * is either constructed directly within the inline buffer, or in memory obtained from the storage policy, in
+         * which case only a pointer to it is stored in the inline buffer. The move function leaves the source buffer in
+         * a state that no longer needs to be destroyed. Function objects that are trivially copyable and trivially
+         * destructible are marked as such, in which case they are never destroyed and are copied/moved by a memcpy of
+         * only the first size bytes of the buffer. That is, only the bytes that the function object occupies, which is
+         * none at all for empty types such as capture-less lambdas. The invoke function is not part of the table since
+         * basic_inplace_function stores it inline, avoiding an extra indirection on every call
+         */
+        template <typename ReturnTy, typename... ArgsTy>
+        struct function_ops
+        {
+            void (*copy)(void* dest, const void* source);
+            void (*move)(void* dest, void* source);
+            void (*destroy)(void* data) noexcept;
+            const std::type_info& (*target_type)() noexcept;
+            void* (*target)(void* data) noexcept;
+            std::size_t size;
+            bool trivial;
+            bool allocated;
         };
-    }
 
 
 
-    /*
-     * inplace_function
-     */
-    template <typename ReturnTy, typename... ArgsTy, std::size_t Size>
-    class inplace_function<ReturnTy(ArgsTy...), Size>
-    {
-        template <typename, std::size_t>
-        friend class inplace_function;
+        /*
+         * inline_function_ops
+         */
+        template <typename FuncTy, bool Copyable, typename ReturnTy, typename... ArgsTy>
+        struct inline_function_ops
+        {
+            static FuncTy* get(void* data) noexcept
+            {
+                return std::launder(static_cast<FuncTy*>(data));
+            }
 
-        using function_base = details::function_base<ReturnTy, ArgsTy...>;
+            static const FuncTy* get(const void* data) noexcept
+            {
+                return std::launder(static_cast<const FuncTy*>(data));
+            }
 
-        template <typename FuncTy>
-        struct function_impl : function_base
+            static ReturnTy invoke(void* data, invoke_arg_t<ArgsTy>... args)
+            {
+                return std::invoke(*get(data), std::forward<ArgsTy>(args)...);
+            }
+
+            static void copy(void* dest, const void* source)
+            {
+                ::new (dest) FuncTy(*get(source));
+            }
+
+            static void move(void* dest, void* source)
+            {
+                auto func = get(source);
+                ::new (dest) FuncTy(std::move(*func));
+                func->~FuncTy();
+            }
+
+            static void destroy(void* data) noexcept
+            {
+                get(data)->~FuncTy();
+            }
+
+            static const std::type_info& target_type() noexcept
+            {
+                return typeid(FuncTy);
+            }
+
+            static void* target(void* data) noexcept
+            {
+                return get(data);
+            }
+
+            static constexpr auto copy_function() noexcept -> void (*)(void*, const void*)
+            {
+                // NOTE: Function objects held by move-only functions aren't required to be copyable
+                if constexpr (Copyable)
+                {
+                    return &copy;
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+
+            static constexpr function_ops<ReturnTy, ArgsTy...> value =
+            {
+                copy_function(),
+                &move,
+                &destroy,
+                &target_type,
+                &target,
+                std::is_empty_v<FuncTy> ? 0 : sizeof(FuncTy),
+                std::is_trivially_copyable_v<FuncTy> && std::is_trivially_destructible_v<FuncTy>,
+                false
+            };
+        };
+
+
+
+        /*
+         * allocated_function_ops
+         */
+        template <typename FuncTy, bool Copyable, typename StoragePolicy, typename ReturnTy, typename... ArgsTy>
+        struct allocated_function_ops
         {
+            static FuncTy* get(const void* data) noexcept
+            {
+                return *std::launder(static_cast<FuncTy* const*>(data));
+            }
+
             template <typename Func>
-            function_impl(Func&& func) :
-                func(std::forward<Func>(func))
+            static void construct(void* dest, Func&& func)
             {
+                auto ptr = StoragePolicy::allocate(sizeof(FuncTy), alignof(FuncTy));
+                auto deallocate = make_scope_guard([&]()
+                {
+                    StoragePolicy::deallocate(ptr, sizeof(FuncTy), alignof(FuncTy));
+                });
+
+                ::new (dest) FuncTy*(::new (ptr) FuncTy(std::forward<Func>(func)));
+                deallocate.cancel();
             }
 
-            virtual function_base* copy(void* addr) override
+            static ReturnTy invoke(void* data, invoke_arg_t<ArgsTy>... args)
             {
-                return ::new (addr) function_impl(func);
+                return std::invoke(*get(data), std::forward<ArgsTy>(args)...);
             }
 
-            virtual function_base* move(void* addr) override
+            static void copy(void* dest, const void* source)
             {
-                return ::new (addr) function_impl(std::move(func));
+                construct(dest, *get(source));
             }
 
-            virtual ReturnTy invoke(ArgsTy&&... args) override
+            static void move(void* dest, void* source)
             {
-                return std::invoke(this->func, std::forward<ArgsTy>(args)...);
+                // Only ownership of the allocation moves
+                ::new (dest) FuncTy*(get(source));
             }
 
-            virtual const std::type_info& target_type() noexcept override
+            static void destroy(void* data) noexcept
+            {
+                auto func = get(data);
+                func->~FuncTy();
+                StoragePolicy::deallocate(func, sizeof(FuncTy), alignof(FuncTy));
+            }
+
+            static const std::type_info& target_type() noexcept
             {
                 return typeid(FuncTy);
             }
 
-            virtual void* target(const std::type_info& type) noexcept override
+            static void* target(void* data) noexcept
+            {
+                return get(data);
+            }
+
+            static constexpr auto copy_function() noexcept -> void (*)(void*, const void*)
             {
-                return (typeid(func) == type) ? &func : nullptr;
+                if constexpr (Copyable)
+                {
+                    return &copy;
+                }
+                else
+                {
+                    return nullptr;
+                }
             }
 
-            FuncTy func;
+            static constexpr function_ops<ReturnTy, ArgsTy...> value =
+            {
+                copy_function(),
+                &move,
+                &destroy,
+                &target_type,
+                &target,
+                sizeof(FuncTy*),
+                false,
+                true
+            };
         };
+    }
+
 
-        // Need space for v-table
-        static constexpr std::size_t buffer_size = Size + sizeof(void*);
+
+    /*
+     * basic_inplace_function
+     */
+    template <typename ReturnTy, typename... ArgsTy, std::size_t Size, bool Copyable, typename StoragePolicy>
+    class basic_inplace_function<ReturnTy(ArgsTy...), Size, Copyable, StoragePolicy>
+    {
+        template <typename, std::size_t, bool, typename>
+        friend class basic_inplace_function;
+
+        using function_ops = details::function_ops<ReturnTy, ArgsTy...>;
+        using invoke_function = details::invoke_function_t<ReturnTy, ArgsTy...>;
+        static constexpr invoke_function null_invoke = &details::null_invoke<ReturnTy, ArgsTy...>;
+
+        template <typename FuncTy>
+        using inline_function_ops = details::inline_function_ops<FuncTy, Copyable, ReturnTy, ArgsTy...>;
+
+        template <typename FuncTy>
+        using allocated_function_ops =
+            details::allocated_function_ops<FuncTy, Copyable, StoragePolicy, ReturnTy, ArgsTy...>;
+
+        template <typename FuncTy>
+        static constexpr bool fits_inline =
+            (sizeof(FuncTy) <= Size) && (alignof(FuncTy) <= alignof(std::max_align_t));
+
+        // Can convert from an equal or smaller function, so long as we don't go from move-only to copyable. Functions
+        // that may have allocated can only be converted to ones that deallocate the same way
+        template <std::size_t OtherSize, bool OtherCopyable, typename OtherStoragePolicy>
+        static constexpr bool is_convertible_from = (OtherSize <= Size) && (OtherCopyable || !Copyable) &&
+            (std::is_same_v<OtherStoragePolicy, StoragePolicy> || !OtherStoragePolicy::allows_allocation);
+
+        // When not copyable, the copy constructor/assignment operator take this type instead (and therefore are never
+        // used) so that the implicitly declared ones get deleted
+        struct not_copyable {};
+        using copy_type = std::conditional_t<Copyable, basic_inplace_function, not_copyable>;
 
     public:
         /*
@@ -166,43 +429,54 @@ namespace dhorn
         /*
          * Constructor(s)/Destructor
          */
-        inplace_function() noexcept = default;
+        basic_inplace_function() noexcept = default;
 
-        inplace_function(std::nullptr_t) noexcept
+        basic_inplace_function(std::nullptr_t) noexcept
         {
         }
 
-        inplace_function(const inplace_function& other)
+        basic_inplace_function(const copy_type& other)
         {
             copy(other);
         }
 
-        template <std::size_t SmallerSize, std::enable_if_t<(SmallerSize <= Size), int> = 0>
-        inplace_function(const inplace_function<ReturnTy(ArgsTy...), SmallerSize>& other)
+        template <
+            std::size_t OtherSize,
+            bool OtherCopyable,
+            typename OtherStoragePolicy,
+            std::enable_if_t<
+                OtherCopyable && is_convertible_from<OtherSize, OtherCopyable, OtherStoragePolicy>, int> = 0>
+        basic_inplace_function(
+            const basic_inplace_function<ReturnTy(ArgsTy...), OtherSize, OtherCopyable, OtherStoragePolicy>& other)
         {
             copy(other);
         }
 
-        inplace_function(inplace_function&& other)
+        basic_inplace_function(basic_inplace_function&& other)
         {
             move(std::move(other));
         }
 
-        template <std::size_t SmallerSize, std::enable_if_t<(SmallerSize <= Size), int> = 0>
-        inplace_function(inplace_function<ReturnTy(ArgsTy...), SmallerSize>&& other)
+        template <
+            std::size_t OtherSize,
+            bool OtherCopyable,
+            typename OtherStoragePolicy,
+            std::enable_if_t<is_convertible_from<OtherSize, OtherCopyable, OtherStoragePolicy>, int> = 0>
+        basic_inplace_function(
+            basic_inplace_function<ReturnTy(ArgsTy...), OtherSize, OtherCopyable, OtherStoragePolicy>&& other)
         {
             move(std::move(other));
         }
 
         template <
             typename Func,
-            std::enable_if_t<details::is_inplace_function_constructible_v<inplace_function, Func>, int> = 0>
-        inplace_function(Func func)
+            std::enable_if_t<details::is_inplace_function_constructible_v<basic_inplace_function, Func>, int> = 0>
+        basic_inplace_function(Func func)
         {
             set(std::move(func));
         }
 
-        ~inplace_function()
+        ~basic_inplace_function()
         {
             reset();
         }
@@ -212,13 +486,13 @@ namespace dhorn
         /*
          * Operators
          */
-        inplace_function& operator=(std::nullptr_t)
+        basic_inplace_function& operator=(std::nullptr_t)
         {
             reset();
             return *this;
         }
 
-        inplace_function& operator=(const inplace_function& other)
+        basic_inplace_function& operator=(const copy_type& other)
         {
             if (this != &other)
             {
@@ -229,7 +503,7 @@ namespace dhorn
             return *this;
         }
 
-        inplace_function& operator=(inplace_function&& other)
+        basic_inplace_function& operator=(basic_inplace_function&& other)
         {
             reset();
             move(std::move(other));
@@ -238,8 +512,9 @@ namespace dhorn
 
         template <
             typename Func,
-            std::enable_if_t<details::is_inplace_function_constructible_v<inplace_function, std::decay_t<Func>>, int> = 0>
-        inplace_function& operator=(Func&& func)
+            std::enable_if_t<
+                details::is_inplace_function_constructible_v<basic_inplace_function, std::decay_t<Func>>, int> = 0>
+        basic_inplace_function& operator=(Func&& func)
         {
             reset();
             set(std::forward<Func>(func));
@@ -248,37 +523,33 @@ namespace dhorn
 
         ReturnTy operator()(ArgsTy... args)
         {
-            if (!this->_func)
-            {
-                throw std::bad_function_call();
-            }
-
-            return this->_func->invoke(std::forward<ArgsTy>(args)...);
+            // NOTE: Null functions use null_invoke, which throws std::bad_function_call
+            return this->_invoke(this->_data, std::forward<ArgsTy>(args)...);
         }
 
         explicit operator bool() const noexcept
         {
-            return this->_func != nullptr;
+            return this->_ops != nullptr;
         }
 
-        friend bool operator==(const inplace_function& func, std::nullptr_t) noexcept
+        friend bool operator==(const basic_inplace_function& func, std::nullptr_t) noexcept
         {
-            return func._func == nullptr;
+            return func._ops == nullptr;
         }
 
-        friend bool operator==(std::nullptr_t, const inplace_function& func) noexcept
+        friend bool operator==(std::nullptr_t, const basic_inplace_function& func) noexcept
         {
-            return func._func == nullptr;
+            return func._ops == nullptr;
         }
 
-        friend bool operator!=(const inplace_function& func, std::nullptr_t) noexcept
+        friend bool operator!=(const basic_inplace_function& func, std::nullptr_t) noexcept
         {
-            return func._func != nullptr;
+            return func._ops != nullptr;
         }
 
-        friend bool operator!=(std::nullptr_t, const inplace_function& func) noexcept
+        friend bool operator!=(std::nullptr_t, const basic_inplace_function& func) noexcept
         {
-            return func._func != nullptr;
+            return func._ops != nullptr;
         }
 
 
@@ -286,43 +557,11 @@ namespace dhorn
         /*
          * Modifiers
          */
-        void swap(inplace_function& other)
+        void swap(basic_inplace_function& other)
         {
-            // TODO: Is it more efficient to manually control references?
-#if 1
-            inplace_function temp(std::move(other));
+            basic_inplace_function temp(std::move(other));
             other = std::move(*this);
             *this = std::move(temp);
-#else
-            if (other._func)
-            {
-                if (this->_func)
-                {
-                    std::uint8_t tempStorage[Size];
-                    auto temp = this->_func->move(tempStorage);
-                    auto destroy_temp = make_scope_guard([&]()
-                    {
-                        temp->~function_base();
-                    });
-                    destroy();
-
-                    this->_func = other._func->move(this->_data);
-                    other.destroy();
-
-                    other._func = temp->move(other._data);
-                }
-                else
-                {
-                    this->_func = other._func->move(this->_data);
-                    other.destroy();
-                }
-            }
-            else if (this->_func)
-            {
-                other._func = this->_func->move(other._data);
-                destroy();
-            }
-#endif
         }
 
 
@@ -332,9 +571,9 @@ namespace dhorn
          */
         const std::type_info& target_type()
         {
-            if (this->_func)
+            if (this->_ops)
             {
-                return this->_func->target_type();
+                return this->_ops->target_type();
             }
 
             return typeid(void);
@@ -343,9 +582,9 @@ namespace dhorn
         template <typename Func>
         Func* target() noexcept
         {
-            if (this->_func)
+            if (this->_ops && (this->_ops->target_type() == typeid(Func)))
             {
-                return reinterpret_cast<Func*>(this->_func->target(typeid(Func)));
+                return static_cast<Func*>(this->_ops->target(this->_data));
             }
 
             return nullptr;
@@ -354,12 +593,12 @@ namespace dhorn
         template <typename Func>
         const Func* target() const noexcept
         {
-            if (this->_func)
-            {
-                return reinterpret_cast<const Func*>(this->_func->target(typeid(Func)));
-            }
+            return const_cast<basic_inplace_function*>(this)->template target<Func>();
+        }
 
-            return nullptr;
+        bool is_allocated() const noexcept
+        {
+            return this->_ops && this->_ops->allocated;
         }
 
 
@@ -369,88 +608,114 @@ namespace dhorn
         template <typename Func>
         void set(Func&& func)
         {
-            assert(!this->_func);
+            assert(!this->_ops);
             if (!details::is_function_null(func))
             {
-                using impl_type = function_impl<std::decay_t<Func>>;
-                static_assert(sizeof(std::decay_t<Func>) <= Size, "Function object too large for inlpace_function." \
-                    " Either reduce the object's size or use a larger sized inplace_function");
-                static_assert((sizeof(std::decay_t<Func>) <= Size) == (sizeof(impl_type) <= buffer_size),
-                    "Assumption about v-table size incorrect");
+                using func_type = std::decay_t<Func>;
+                if constexpr (StoragePolicy::allows_allocation && !fits_inline<func_type>)
+                {
+                    static_assert(sizeof(func_type*) <= Size, "Not enough space for a pointer to the function object");
 
-                this->_func = ::new (this->_data) impl_type(std::forward<Func>(func));
+                    using ops_type = allocated_function_ops<func_type>;
+                    ops_type::construct(this->_data, std::forward<Func>(func));
+                    this->_ops = &ops_type::value;
+                    this->_invoke = &ops_type::invoke;
+                }
+                else
+                {
+                    static_assert(sizeof(func_type) <= Size, "Function object too large for inlpace_function." \
+                        " Either reduce the object's size or use a larger sized inplace_function");
+                    static_assert(alignof(func_type) <= alignof(std::max_align_t),
+                        "Function object is over-aligned for inplace_function");
+
+                    using ops_type = inline_function_ops<func_type>;
+                    ::new (this->_data) func_type(std::forward<Func>(func));
+                    this->_ops = &ops_type::value;
+                    this->_invoke = &ops_type::invoke;
+                }
             }
         }
 
         void destroy()
         {
-            assert(this->_func);
+            assert(this->_ops);
 
             // If an exception gets thrown, let it propagate, but leave us in a state that says we cleaned it all up
-            auto func = this->_func;
-            this->_func = nullptr;
-            func->~function_base();
+            auto ops = this->_ops;
+            this->_ops = nullptr;
+            this->_invoke = null_invoke;
+            if (!ops->trivial)
+            {
+                ops->destroy(this->_data);
+            }
         }
 
         void reset()
         {
-            if (this->_func)
+            if (this->_ops)
             {
                 destroy();
             }
         }
 
-        void copy(const inplace_function& other)
+        void copy(const not_copyable&)
         {
-            assert(!this->_func);
-            if (other._func)
-            {
-                this->_func = other._func->copy(this->_data);
-            }
+            // Never called; only here so that the copy constructor/assignment operator compile
         }
 
-        template <std::size_t SmallerSize>
-        void copy(const inplace_function<ReturnTy(ArgsTy...), SmallerSize>& other)
+        template <std::size_t OtherSize, typename OtherStoragePolicy>
+        void copy(const basic_inplace_function<ReturnTy(ArgsTy...), OtherSize, true, OtherStoragePolicy>& other)
         {
-            assert(!this->_func);
-            if (other._func)
+            assert(!this->_ops);
+            if (other._ops)
             {
-                this->_func = other._func->copy(this->_data);
+                if (other._ops->trivial)
+                {
+                    std::memcpy(this->_data, other._data, other._ops->size);
+                }
+                else
+                {
+                    other._ops->copy(this->_data, other._data);
+                }
+
+                this->_ops = other._ops;
+                this->_invoke = other._invoke;
             }
         }
 
-        void move(inplace_function&& other)
+        template <std::size_t OtherSize, bool OtherCopyable, typename OtherStoragePolicy>
+        void move(basic_inplace_function<ReturnTy(ArgsTy...), OtherSize, OtherCopyable, OtherStoragePolicy>&& other)
         {
-            assert(!this->_func);
-            if (other._func)
+            assert(!this->_ops);
+            if (other._ops)
             {
-                this->_func = other._func->move(this->_data);
-
                 // If an exception gets thrown, it would have been in the move constructor. In that case, assume that no
-                // state has changed. If it succeeded, we don't know if the underlying function is in a usable state, so
-                // reset the moved-from function
-                other.reset();
-            }
-        }
+                // state has changed. If it succeeded, the function object has been destroyed (or its ownership has been
+                // transferred to us), so the moved-from function becomes null
+                if (other._ops->trivial)
+                {
+                    std::memcpy(this->_data, other._data, other._ops->size);
+                }
+                else
+                {
+                    other._ops->move(this->_data, other._data);
+                }
 
-        template <std::size_t SmallerSize>
-        void move(inplace_function<ReturnTy(ArgsTy...), SmallerSize>&& other)
-        {
-            assert(!this->_func);
-            if (other._func)
-            {
-                this->_func = other._func->move(this->_data);
-                other.reset();
+                this->_ops = other._ops;
+                this->_invoke = other._invoke;
+                other._ops = nullptr;
+                other._invoke = null_invoke;
             }
         }
 
 
 
-        function_base* _func = nullptr;
+        invoke_function _invoke = null_invoke;
+        const function_ops* _ops = nullptr;
         union
         {
             std::max_align_t _;
-            std::uint8_t _data[buffer_size];
+            std::uint8_t _data[Size];
         };
     };
 
@@ -459,8 +724,10 @@ namespace dhorn
     /*
      * swap
      */
-    template <typename Func, std::size_t Size>
-    void swap(inplace_function<Func, Size>& lhs, inplace_function<Func, Size>& rhs)
+    template <typename Func, std::size_t Size, bool Copyable, typename StoragePolicy>
+    void swap(
+        basic_inplace_function<Func, Size, Copyable, StoragePolicy>& lhs,
+        basic_inplace_function<Func, Size, Copyable, StoragePolicy>& rhs)
     {
         lhs.swap(rhs);
     }
@@ -9,10 +9,19 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "cpu_features.h"
+
+#if DHORN_SSE2
+#include <immintrin.h>
+#endif
+
 namespace dhorn
 {
     /*
@@ -429,5 +438,308 @@ namespace dhorn
             basic_null_terminated_string<OtherCharT>(compareString));
     }
 
+#pragma endregion
+
+
+
+    /*
+     * Case Insensitive Comparison
+     *
+     * Versions of equals, compare, and starts_with that ignore differences in case of ASCII letters. All other
+     * characters must match exactly, so these are well suited for protocol keywords, header names, identifiers, etc.
+     * that are restricted to ASCII, even when the text itself is UTF-8. See dhorn/unicode/case_fold.h for comparisons
+     * that take non-ASCII characters into account. The overloads mirror those of starts_with. When both strings are
+     * contiguous byte strings (pointer ranges, std::basic_string, or std::basic_string_view), the comparison is
+     * vectorized. E.g.
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * iequals("Content-Length"sv, "content-length")    // true
+     * icompare("abc"sv, "ABD")                         // -1
+     * istarts_with("Bearer abc123"sv, "bearer ")       // true
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     */
+#pragma region Case Insensitive Comparison
+
+    namespace details
+    {
+        template <typename CharT>
+        constexpr CharT ascii_to_lower(CharT ch) noexcept
+        {
+            return ((ch >= 'A') && (ch <= 'Z')) ? static_cast<CharT>(ch + ('a' - 'A')) : ch;
+        }
+
+        template <typename CharT>
+        constexpr auto ascii_to_lower_unsigned(CharT ch) noexcept
+        {
+            // Ordering follows std::char_traits, which treats char as unsigned
+            if constexpr (std::is_integral_v<CharT> && std::is_signed_v<CharT>)
+            {
+                return static_cast<std::make_unsigned_t<CharT>>(ascii_to_lower(ch));
+            }
+            else
+            {
+                return ascii_to_lower(ch);
+            }
+        }
+
+        template <typename CharT>
+        constexpr bool is_byte_char =
+            std::is_same_v<CharT, char> || std::is_same_v<CharT, signed char> || std::is_same_v<CharT, unsigned char>;
+
+        template <typename Itr, typename CharT = std::remove_const_t<typename std::iterator_traits<Itr>::value_type>>
+        constexpr bool is_contiguous_byte_iterator = is_byte_char<CharT> && (
+            std::is_pointer_v<Itr> ||
+            std::is_same_v<Itr, typename std::basic_string<CharT>::iterator> ||
+            std::is_same_v<Itr, typename std::basic_string<CharT>::const_iterator> ||
+            std::is_same_v<Itr, typename std::basic_string_view<CharT>::const_iterator>);
+
+#if DHORN_SSE2
+        inline __m128i sse2_ascii_to_lower(__m128i value) noexcept
+        {
+            // Bytes 0x80 and above are negative, so they fail the first comparison
+            auto isUpper = _mm_and_si128(
+                _mm_cmpgt_epi8(value, _mm_set1_epi8('A' - 1)),
+                _mm_cmplt_epi8(value, _mm_set1_epi8('Z' + 1)));
+            return _mm_or_si128(value, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+        }
+#endif
+
+        inline std::size_t ascii_imismatch(const char* lhs, const char* rhs, std::size_t length) noexcept
+        {
+            // Returns the offset of the first position where the two strings differ, ignoring ASCII case
+            std::size_t pos = 0;
+
+#if DHORN_SSE2
+            for (; (length - pos) >= 16; pos += 16)
+            {
+                auto lhsBlock = sse2_ascii_to_lower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + pos)));
+                auto rhsBlock = sse2_ascii_to_lower(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + pos)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(lhsBlock, rhsBlock)) != 0xFFFF)
+                {
+                    // Let the scalar loop find the exact position
+                    break;
+                }
+            }
+#endif
+
+            for (; pos < length; ++pos)
+            {
+                if (ascii_to_lower(lhs[pos]) != ascii_to_lower(rhs[pos]))
+                {
+                    break;
+                }
+            }
+
+            return pos;
+        }
+
+        template <typename LhsItr, typename RhsItr>
+        inline std::pair<LhsItr, RhsItr> ascii_imismatch(LhsItr lhsBegin, LhsItr lhsEnd, RhsItr rhsBegin, RhsItr rhsEnd)
+        {
+            if constexpr (is_contiguous_byte_iterator<LhsItr> && is_contiguous_byte_iterator<RhsItr>)
+            {
+                auto length = static_cast<std::size_t>(std::min(lhsEnd - lhsBegin, rhsEnd - rhsBegin));
+                if (length == 0)
+                {
+                    return { lhsBegin, rhsBegin };
+                }
+
+                auto offset = ascii_imismatch(
+                    reinterpret_cast<const char*>(&*lhsBegin),
+                    reinterpret_cast<const char*>(&*rhsBegin),
+                    length);
+                return { lhsBegin + offset, rhsBegin + offset };
+            }
+            else
+            {
+                for (; (lhsBegin != lhsEnd) && (rhsBegin != rhsEnd); ++lhsBegin, ++rhsBegin)
+                {
+                    if (ascii_to_lower(*lhsBegin) != ascii_to_lower(*rhsBegin))
+                    {
+                        break;
+                    }
+                }
+
+                return { lhsBegin, rhsBegin };
+            }
+        }
+    }
+
+    template <typename LhsItr, typename RhsItr>
+    inline bool iequals(LhsItr lhsBegin, LhsItr lhsEnd, RhsItr rhsBegin, RhsItr rhsEnd)
+    {
+        using lhs_category = typename std::iterator_traits<LhsItr>::iterator_category;
+        using rhs_category = typename std::iterator_traits<RhsItr>::iterator_category;
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, lhs_category> &&
+            std::is_base_of_v<std::random_access_iterator_tag, rhs_category>)
+        {
+            if ((lhsEnd - lhsBegin) != (rhsEnd - rhsBegin))
+            {
+                return false;
+            }
+        }
+
+        auto [lhs, rhs] = details::ascii_imismatch(lhsBegin, lhsEnd, rhsBegin, rhsEnd);
+        return (lhs == lhsEnd) && (rhs == rhsEnd);
+    }
+
+    template <typename StringTy, typename CompareItr>
+    inline bool iequals(const StringTy& string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        using std::begin;
+        using std::end;
+        return iequals(begin(string), end(string), compareBegin, compareEnd);
+    }
+
+    template <typename StringTy, typename CompareStringTy>
+    inline bool iequals(const StringTy& string, const CompareStringTy& compareString)
+    {
+        using std::begin;
+        using std::end;
+        return iequals(begin(string), end(string), begin(compareString), end(compareString));
+    }
+
+    template <typename StringTy, typename CharT>
+    inline bool iequals(const StringTy& string, CharT* compareString)
+    {
+        return iequals(string, basic_null_terminated_string<CharT>(compareString));
+    }
+
+    template <typename CharT, typename CompareItr>
+    inline bool iequals(CharT* string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        return iequals(basic_null_terminated_string<CharT>(string), compareBegin, compareEnd);
+    }
+
+    template <typename CharT, typename StringTy>
+    inline bool iequals(CharT* string, const StringTy& compareString)
+    {
+        return iequals(basic_null_terminated_string<CharT>(string), compareString);
+    }
+
+    template <
+        typename CharT,
+        typename OtherCharT,
+        std::enable_if_t<std::is_same_v<std::remove_const_t<CharT>, std::remove_const_t<OtherCharT>>, int> = 0>
+    inline bool iequals(CharT* string, OtherCharT* compareString)
+    {
+        return iequals(
+            basic_null_terminated_string<CharT>(string),
+            basic_null_terminated_string<OtherCharT>(compareString));
+    }
+
+    template <typename LhsItr, typename RhsItr>
+    inline int icompare(LhsItr lhsBegin, LhsItr lhsEnd, RhsItr rhsBegin, RhsItr rhsEnd)
+    {
+        // Returns a negative value, zero, or a positive value, same as std::basic_string::compare, only the strings are
+        // compared as if all ASCII letters were lower case
+        auto [lhs, rhs] = details::ascii_imismatch(lhsBegin, lhsEnd, rhsBegin, rhsEnd);
+        if (lhs == lhsEnd)
+        {
+            return (rhs == rhsEnd) ? 0 : -1;
+        }
+        else if (rhs == rhsEnd)
+        {
+            return 1;
+        }
+
+        return (details::ascii_to_lower_unsigned(*lhs) < details::ascii_to_lower_unsigned(*rhs)) ? -1 : 1;
+    }
+
+    template <typename StringTy, typename CompareItr>
+    inline int icompare(const StringTy& string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        using std::begin;
+        using std::end;
+        return icompare(begin(string), end(string), compareBegin, compareEnd);
+    }
+
+    template <typename StringTy, typename CompareStringTy>
+    inline int icompare(const StringTy& string, const CompareStringTy& compareString)
+    {
+        using std::begin;
+        using std::end;
+        return icompare(begin(string), end(string), begin(compareString), end(compareString));
+    }
+
+    template <typename StringTy, typename CharT>
+    inline int icompare(const StringTy& string, CharT* compareString)
+    {
+        return icompare(string, basic_null_terminated_string<CharT>(compareString));
+    }
+
+    template <typename CharT, typename CompareItr>
+    inline int icompare(CharT* string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        return icompare(basic_null_terminated_string<CharT>(string), compareBegin, compareEnd);
+    }
+
+    template <typename CharT, typename StringTy>
+    inline int icompare(CharT* string, const StringTy& compareString)
+    {
+        return icompare(basic_null_terminated_string<CharT>(string), compareString);
+    }
+
+    template <
+        typename CharT,
+        typename OtherCharT,
+        std::enable_if_t<std::is_same_v<std::remove_const_t<CharT>, std::remove_const_t<OtherCharT>>, int> = 0>
+    inline int icompare(CharT* string, OtherCharT* compareString)
+    {
+        return icompare(
+            basic_null_terminated_string<CharT>(string),
+            basic_null_terminated_string<OtherCharT>(compareString));
+    }
+
+    template <typename RangeItr, typename CompareItr>
+    inline bool istarts_with(RangeItr rangeBegin, RangeItr rangeEnd, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        return details::ascii_imismatch(compareBegin, compareEnd, rangeBegin, rangeEnd).first == compareEnd;
+    }
+
+    template <typename StringTy, typename CompareItr>
+    inline bool istarts_with(const StringTy& string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        using std::begin;
+        using std::end;
+        return istarts_with(begin(string), end(string), compareBegin, compareEnd);
+    }
+
+    template <typename StringTy, typename CompareStringTy>
+    inline bool istarts_with(const StringTy& string, const CompareStringTy& compareString)
+    {
+        using std::begin;
+        using std::end;
+        return istarts_with(begin(string), end(string), begin(compareString), end(compareString));
+    }
+
+    template <typename StringTy, typename CharT>
+    inline bool istarts_with(const StringTy& string, CharT* compareString)
+    {
+        return istarts_with(string, basic_null_terminated_string<CharT>(compareString));
+    }
+
+    template <typename CharT, typename CompareItr>
+    inline bool istarts_with(CharT* string, CompareItr compareBegin, CompareItr compareEnd)
+    {
+        return istarts_with(basic_null_terminated_string<CharT>(string), compareBegin, compareEnd);
+    }
+
+    template <typename CharT, typename StringTy>
+    inline bool istarts_with(CharT* string, const StringTy& compareString)
+    {
+        return istarts_with(basic_null_terminated_string<CharT>(string), compareString);
+    }
+
+    template <
+        typename CharT,
+        typename OtherCharT,
+        std::enable_if_t<std::is_same_v<std::remove_const_t<CharT>, std::remove_const_t<OtherCharT>>, int> = 0>
+    inline bool istarts_with(CharT* string, OtherCharT* compareString)
+    {
+        return istarts_with(
+            basic_null_terminated_string<CharT>(string),
+            basic_null_terminated_string<OtherCharT>(compareString));
+    }
+
 #pragma endregion
 }
@@ -0,0 +1,928 @@
+/*
+ * Duncan Horn
+ *
+ * simd.h
+ *
+ * Bulk, vectorized, implementations of operations on encoded strings. Each operation has a scalar implementation that
+ * works on any architecture, and one or more kernels that use SSE2/AVX2 when available. The kernel that gets used is
+ * selected the first time that the operation is called based off of the features the processor supports. Operations
+ * that only need SSE2 use it unconditionally when the compiler targets it.
+ *
+ * Unless otherwise noted, UTF-16 and UTF-32 input and output is expected to be in the host's byte order.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../../cpu_features.h"
+
+#if DHORN_X86
+#include <immintrin.h>
+#endif
+
+namespace dhorn::unicode::details
+{
+#if DHORN_X86
+    inline int count_trailing_zeros(std::uint32_t value) noexcept
+    {
+        // NOTE: Value must be non-zero
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long result;
+        _BitScanForward(&result, value);
+        return static_cast<int>(result);
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+#endif
+
+#if DHORN_SSE2
+    inline bool sse2_all_less_than_u16(__m128i value, std::uint16_t limit) noexcept
+    {
+        // NOTE: Only works for limits that are powers of two
+        auto overflow = _mm_and_si128(value, _mm_set1_epi16(static_cast<short>(~(limit - 1))));
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(overflow, _mm_setzero_si128())) == 0xFFFF;
+    }
+
+    inline bool sse2_all_less_than_u32(__m128i value, std::uint32_t limit) noexcept
+    {
+        // NOTE: Only works for limits that are powers of two
+        auto overflow = _mm_and_si128(value, _mm_set1_epi32(static_cast<int>(~(limit - 1))));
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(overflow, _mm_setzero_si128())) == 0xFFFF;
+    }
+
+    inline bool sse2_any_surrogate_u16(__m128i value) noexcept
+    {
+        auto masked = _mm_and_si128(value, _mm_set1_epi16(static_cast<short>(0xF800)));
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_set1_epi16(static_cast<short>(0xD800)))) != 0;
+    }
+
+    inline bool sse2_any_surrogate_u32(__m128i value) noexcept
+    {
+        auto masked = _mm_and_si128(value, _mm_set1_epi32(0xFFFF'F800));
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(masked, _mm_set1_epi32(0xD800))) != 0;
+    }
+
+    inline __m128i sse2_pack_u32(__m128i low, __m128i high) noexcept
+    {
+        // SSE2 only has a signed saturating pack, so bias the values into the signed range and back
+        auto bias32 = _mm_set1_epi32(0x8000);
+        auto packed = _mm_packs_epi32(_mm_sub_epi32(low, bias32), _mm_sub_epi32(high, bias32));
+        return _mm_add_epi16(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+    }
+#endif
+
+
+
+    /*
+     * UTF-8 Validation
+     *
+     * Validation is strict, per RFC 3629. That is, in addition to code unit sequences that are malformed or truncated,
+     * overlong encodings, encoded surrogates, and code points above U+10FFFF are all considered invalid. Validation
+     * returns an iterator to the start of the first invalid code unit sequence, or end if the input is entirely valid.
+     */
+#pragma region UTF-8 Validation
+
+    struct utf8_lead_info
+    {
+        // The number of code units in the sequence, or zero if the lead byte can never start a valid sequence
+        int size;
+
+        // The range of values that are valid for the second byte in the sequence
+        unsigned char low;
+        unsigned char high;
+    };
+
+    inline constexpr utf8_lead_info utf8_lead(unsigned char lead) noexcept
+    {
+        // Valid sequences are:
+        //      00-7F
+        //      C2-DF   80-BF
+        //      E0      A0-BF   80-BF
+        //      E1-EC   80-BF   80-BF
+        //      ED      80-9F   80-BF
+        //      EE-EF   80-BF   80-BF
+        //      F0      90-BF   80-BF   80-BF
+        //      F1-F3   80-BF   80-BF   80-BF
+        //      F4      80-8F   80-BF   80-BF
+        if (lead < 0x80)
+        {
+            return { 1, 0x80, 0xBF };
+        }
+        else if (lead < 0xC2)
+        {
+            // Either a continuation byte or an overlong two byte sequence
+            return { 0, 0x80, 0xBF };
+        }
+        else if (lead < 0xE0)
+        {
+            return { 2, 0x80, 0xBF };
+        }
+        else if (lead < 0xF0)
+        {
+            return { 3, static_cast<unsigned char>((lead == 0xE0) ? 0xA0 : 0x80),
+                static_cast<unsigned char>((lead == 0xED) ? 0x9F : 0xBF) };
+        }
+        else if (lead < 0xF5)
+        {
+            return { 4, static_cast<unsigned char>((lead == 0xF0) ? 0x90 : 0x80),
+                static_cast<unsigned char>((lead == 0xF4) ? 0x8F : 0xBF) };
+        }
+
+        return { 0, 0x80, 0xBF };
+    }
+
+    template <typename ForwardItr>
+    inline constexpr ForwardItr utf8_validate_code_point(ForwardItr pos, ForwardItr end) noexcept
+    {
+        // Returns an iterator to the start of the next code point on success, or pos on failure
+        const auto lead = static_cast<unsigned char>(*pos);
+        auto next = pos;
+        ++next;
+        if (lead < 0x80)
+        {
+            return next;
+        }
+
+        auto [size, low, high] = utf8_lead(lead);
+        if ((size == 0) || (next == end))
+        {
+            return pos;
+        }
+
+        const auto second = static_cast<unsigned char>(*next);
+        if ((second < low) || (second > high))
+        {
+            return pos;
+        }
+
+        for (++next; --size > 1; ++next)
+        {
+            if ((next == end) || ((static_cast<unsigned char>(*next) & 0xC0) != 0x80))
+            {
+                return pos;
+            }
+        }
+
+        return next;
+    }
+
+    template <typename ForwardItr>
+    inline constexpr ForwardItr utf8_validate_scalar(ForwardItr pos, ForwardItr end) noexcept
+    {
+        while (pos != end)
+        {
+            if constexpr (std::is_pointer_v<ForwardItr>)
+            {
+                // Skip over ASCII text eight characters at a time
+                if ((end - pos) >= 8)
+                {
+                    std::uint64_t word;
+                    std::memcpy(&word, pos, sizeof(word));
+                    if ((word & 0x8080'8080'8080'8080) == 0)
+                    {
+                        pos += 8;
+                        continue;
+                    }
+                }
+            }
+
+            auto next = utf8_validate_code_point(pos, end);
+            if (next == pos)
+            {
+                break;
+            }
+
+            pos = next;
+        }
+
+        return pos;
+    }
+
+    inline const char* utf8_validate_resume(const char* begin, const char* pos, const char* end) noexcept
+    {
+        // Called when a vectorized kernel detects an error in the block starting at pos. Everything before pos is known
+        // to be valid, except possibly for a code point that started in the three code units preceding pos. Find the
+        // start of that code point and use the scalar implementation to determine the exact location of the error
+        auto start = ((pos - begin) > 3) ? (pos - 3) : begin;
+        while ((start < pos) && ((static_cast<unsigned char>(*start) & 0xC0) == 0x80))
+        {
+            ++start;
+        }
+
+        return utf8_validate_scalar(start, end);
+    }
+
+#if DHORN_X86
+
+    DHORN_TARGET_SSE2
+    inline const char* utf8_validate_sse2(const char* begin, const char* end) noexcept
+    {
+        // SSE2 does not have a byte shuffle, so only use it to skip over ASCII text 16 characters at a time and fall
+        // back to the scalar implementation for everything else
+        auto pos = begin;
+        while ((end - pos) >= 16)
+        {
+            auto mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)));
+            if (mask == 0)
+            {
+                pos += 16;
+                continue;
+            }
+
+            // Validate code points up until the next ASCII character, or until we've consumed the block
+            pos += count_trailing_zeros(static_cast<std::uint32_t>(mask));
+            auto stop = pos + 16;
+            do
+            {
+                auto next = utf8_validate_code_point(pos, end);
+                if (next == pos)
+                {
+                    return pos;
+                }
+
+                pos = next;
+            }
+            while ((pos < stop) && (pos != end) && (static_cast<unsigned char>(*pos) & 0x80));
+        }
+
+        return utf8_validate_scalar(pos, end);
+    }
+
+    /*
+     * The AVX2 kernel uses the lookup algorithm described by Keiser and Lemire in "Validating UTF-8 In Less Than One
+     * Instruction Per Byte". Nearly all errors can be detected by looking at the high nibble of a byte along with the
+     * high and low nibbles of the byte preceding it. Each of these three nibbles is used to index into a table of
+     * error flags, and the results are and-ed together, leaving behind only the errors that apply to all three. The
+     * only errors that cannot be detected this way are missing and extra continuation bytes in three and four byte
+     * sequences, which are handled by checking the bytes two and three positions back.
+     */
+    namespace utf8_error
+    {
+        constexpr std::uint8_t too_short = 1 << 0;      // 11______ 0_______ or 11______ 11______
+        constexpr std::uint8_t too_long = 1 << 1;       // 0_______ 10______
+        constexpr std::uint8_t overlong_3 = 1 << 2;     // 11100000 100_____
+        constexpr std::uint8_t too_large = 1 << 3;      // 11110100 1001____, 11110100 101_____, 11110101+ 1001____...
+        constexpr std::uint8_t surrogate = 1 << 4;      // 11101101 101_____
+        constexpr std::uint8_t overlong_2 = 1 << 5;     // 1100000_ 10______
+        constexpr std::uint8_t too_large_1000 = 1 << 6; // 11110101+ 1000____
+        constexpr std::uint8_t overlong_4 = 1 << 6;     // 11110000 1000____
+        constexpr std::uint8_t two_conts = 1 << 7;      // 10______ 10______
+        constexpr std::uint8_t carry = too_short | too_long | two_conts;
+    }
+
+    alignas(16) constexpr std::uint8_t utf8_byte_1_high_table[16] =
+    {
+        // 0_______ ________ (ASCII)
+        utf8_error::too_long, utf8_error::too_long, utf8_error::too_long, utf8_error::too_long,
+        utf8_error::too_long, utf8_error::too_long, utf8_error::too_long, utf8_error::too_long,
+        // 10______ ________ (continuation)
+        utf8_error::two_conts, utf8_error::two_conts, utf8_error::two_conts, utf8_error::two_conts,
+        // 1100____ ________ (two byte lead)
+        utf8_error::too_short | utf8_error::overlong_2,
+        // 1101____ ________ (two byte lead)
+        utf8_error::too_short,
+        // 1110____ ________ (three byte lead)
+        utf8_error::too_short | utf8_error::overlong_3 | utf8_error::surrogate,
+        // 1111____ ________ (four byte lead)
+        utf8_error::too_short | utf8_error::too_large | utf8_error::too_large_1000 | utf8_error::overlong_4,
+    };
+
+    alignas(16) constexpr std::uint8_t utf8_byte_1_low_table[16] =
+    {
+        // ____0000 ________
+        utf8_error::carry | utf8_error::overlong_3 | utf8_error::overlong_2 | utf8_error::overlong_4,
+        // ____0001 ________
+        utf8_error::carry | utf8_error::overlong_2,
+        // ____001_ ________
+        utf8_error::carry,
+        utf8_error::carry,
+        // ____0100 ________
+        utf8_error::carry | utf8_error::too_large,
+        // ____0101 ________ through ____1100 ________
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        // ____1101 ________
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000 | utf8_error::surrogate,
+        // ____111_ ________
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+        utf8_error::carry | utf8_error::too_large | utf8_error::too_large_1000,
+    };
+
+    alignas(16) constexpr std::uint8_t utf8_byte_2_high_table[16] =
+    {
+        // ________ 0_______ (ASCII)
+        utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short,
+        utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short,
+        // ________ 1000____
+        utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::overlong_3 |
+            utf8_error::too_large_1000 | utf8_error::overlong_4,
+        // ________ 1001____
+        utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::overlong_3 |
+            utf8_error::too_large,
+        // ________ 101_____
+        utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::surrogate |
+            utf8_error::too_large,
+        utf8_error::too_long | utf8_error::overlong_2 | utf8_error::two_conts | utf8_error::surrogate |
+            utf8_error::too_large,
+        // ________ 11______ (lead)
+        utf8_error::too_short, utf8_error::too_short, utf8_error::too_short, utf8_error::too_short,
+    };
+
+    // A block is incomplete if it ends with the start of a multi-byte sequence. Any byte that is larger than its
+    // corresponding value here indicates that's the case
+    alignas(32) constexpr std::uint8_t utf8_incomplete_max[32] =
+    {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+    };
+
+    template <int Count>
+    DHORN_TARGET_AVX2
+    inline __m256i avx2_prev(__m256i input, __m256i prevInput) noexcept
+    {
+        // Shifts the input "right" by Count bytes, shifting in the last Count bytes of the previous input
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prevInput, input, 0x21), 16 - Count);
+    }
+
+    DHORN_TARGET_AVX2
+    inline __m256i avx2_lookup(const std::uint8_t (&table)[16], __m256i indices) noexcept
+    {
+        auto lookup = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+        return _mm256_shuffle_epi8(lookup, indices);
+    }
+
+    DHORN_TARGET_AVX2
+    inline __m256i utf8_avx2_check_block(__m256i input, __m256i prevInput) noexcept
+    {
+        const auto lowNibbleMask = _mm256_set1_epi8(0x0F);
+        const auto prev1 = avx2_prev<1>(input, prevInput);
+
+        auto prev1High = _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibbleMask);
+        auto prev1Low = _mm256_and_si256(prev1, lowNibbleMask);
+        auto inputHigh = _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibbleMask);
+
+        auto byte1High = avx2_lookup(utf8_byte_1_high_table, prev1High);
+        auto byte1Low = avx2_lookup(utf8_byte_1_low_table, prev1Low);
+        auto byte2High = avx2_lookup(utf8_byte_2_high_table, inputHigh);
+        auto special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+        // Bytes that follow a three or four byte lead by two or three positions must be continuations. The two_conts
+        // flag from above is expected in exactly these positions, so xor-ing the two leaves behind the errors
+        auto isThirdByte = _mm256_subs_epu8(avx2_prev<2>(input, prevInput), _mm256_set1_epi8(0xE0 - 0x80));
+        auto isFourthByte = _mm256_subs_epu8(avx2_prev<3>(input, prevInput), _mm256_set1_epi8(0xF0 - 0x80));
+        auto mustBeContinuation = _mm256_and_si256(
+            _mm256_or_si256(isThirdByte, isFourthByte),
+            _mm256_set1_epi8(static_cast<char>(0x80)));
+
+        return _mm256_xor_si256(mustBeContinuation, special);
+    }
+
+    DHORN_TARGET_AVX2
+    inline const char* utf8_validate_avx2(const char* begin, const char* end) noexcept
+    {
+        const auto incompleteMax = _mm256_load_si256(reinterpret_cast<const __m256i*>(utf8_incomplete_max));
+        auto prevInput = _mm256_setzero_si256();
+        auto prevIncomplete = _mm256_setzero_si256();
+
+        auto pos = begin;
+        while ((end - pos) >= 32)
+        {
+            auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+
+            __m256i error;
+            if (_mm256_movemask_epi8(input) == 0)
+            {
+                // All ASCII, so the only possible error is a truncated sequence at the end of the previous block
+                error = prevIncomplete;
+            }
+            else
+            {
+                error = utf8_avx2_check_block(input, prevInput);
+                prevIncomplete = _mm256_subs_epu8(input, incompleteMax);
+            }
+
+            if (!_mm256_testz_si256(error, error))
+            {
+                return utf8_validate_resume(begin, pos, end);
+            }
+
+            prevInput = input;
+            pos += 32;
+        }
+
+        // Pad the remainder with zeros. Since there is always at least one, this also catches truncated sequences
+        alignas(32) char buffer[32] = {};
+        std::memcpy(buffer, pos, end - pos);
+        auto input = _mm256_load_si256(reinterpret_cast<const __m256i*>(buffer));
+        auto error = utf8_avx2_check_block(input, prevInput);
+        if (!_mm256_testz_si256(error, error))
+        {
+            return utf8_validate_resume(begin, pos, end);
+        }
+
+        return end;
+    }
+
+#endif
+
+    inline const char* utf8_validate(const char* begin, const char* end) noexcept
+    {
+#if DHORN_X86
+        using kernel_type = const char* (*)(const char*, const char*) noexcept;
+        static const kernel_type kernel = []() -> kernel_type
+        {
+            auto& features = cpu_features::get();
+            if (features.avx2)
+            {
+                return &utf8_validate_avx2;
+            }
+            else if (features.sse2)
+            {
+                return &utf8_validate_sse2;
+            }
+
+            return &utf8_validate_scalar<const char*>;
+        }();
+
+        return kernel(begin, end);
+#else
+        return utf8_validate_scalar(begin, end);
+#endif
+    }
+
+#pragma endregion
+
+
+
+    /*
+     * UTF-16/UTF-32 Validation
+     *
+     * Input must be in the host's byte order. Same as UTF-8 validation, the result is a pointer to the start of the
+     * first invalid code unit sequence, or end if the input is entirely valid. The only invalid UTF-16 sequences are
+     * unpaired surrogates. Valid UTF-32 is any code point less than U+110000 that is not a surrogate.
+     */
+#pragma region UTF-16/UTF-32 Validation
+
+    inline const char16_t* utf16_validate(const char16_t* begin, const char16_t* end) noexcept
+    {
+        while (begin != end)
+        {
+#if DHORN_SSE2
+            // Skip over blocks that don't contain any surrogates
+            if ((end - begin) >= 8)
+            {
+                if (!sse2_any_surrogate_u16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))))
+                {
+                    begin += 8;
+                    continue;
+                }
+            }
+#endif
+
+            if ((*begin & 0xF800) != 0xD800)
+            {
+                ++begin;
+                continue;
+            }
+
+            // Must be a high surrogate followed by a low surrogate
+            if ((*begin >= 0xDC00) || ((end - begin) < 2) || ((begin[1] & 0xFC00) != 0xDC00))
+            {
+                break;
+            }
+
+            begin += 2;
+        }
+
+        return begin;
+    }
+
+    inline const char32_t* utf32_validate(const char32_t* begin, const char32_t* end) noexcept
+    {
+#if DHORN_SSE2
+        // SSE2 only has signed comparisons, so bias the values so that an unsigned comparison can be done instead
+        const auto bias = _mm_set1_epi32(static_cast<int>(0x8000'0000));
+        const auto max = _mm_set1_epi32(static_cast<int>(0x8010'FFFF));
+        while ((end - begin) >= 4)
+        {
+            auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto tooLarge = _mm_cmpgt_epi32(_mm_xor_si128(input, bias), max);
+            if (_mm_movemask_epi8(tooLarge) || sse2_any_surrogate_u32(input))
+            {
+                break;
+            }
+
+            begin += 4;
+        }
+#endif
+
+        for (; begin != end; ++begin)
+        {
+            if ((*begin >= 0x11'0000) || ((*begin & 0xFFFF'F800) == 0xD800))
+            {
+                break;
+            }
+        }
+
+        return begin;
+    }
+
+#pragma endregion
+
+
+
+    /*
+     * Code Point Counting
+     *
+     * Counting assumes that the input is valid and does no validation of its own. A UTF-8 code point is counted for
+     * each byte that is not a continuation byte and a UTF-16 code point is counted for each code unit that is not a low
+     * surrogate. This gives the same result as walking the string one code point at a time so long as the input is
+     * valid. The null terminated versions first find the terminator and then count the range.
+     */
+#pragma region Code Point Counting
+
+    inline std::size_t count_code_points(const char* begin, const char* end) noexcept
+    {
+        std::size_t result = 0;
+
+#if DHORN_SSE2
+        // Continuation bytes are 0x80-0xBF, or -128 through -65 when treated as signed
+        const auto threshold = _mm_set1_epi8(-65);
+        const auto zero = _mm_setzero_si128();
+        while ((end - begin) >= 16)
+        {
+            // Each comparison gives either 0 or -1 per byte, so we can accumulate 255 blocks before risking overflow
+            auto blocks = (end - begin) / 16;
+            blocks = (blocks > 255) ? 255 : blocks;
+
+            auto counts = zero;
+            for (; blocks > 0; --blocks, begin += 16)
+            {
+                auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(input, threshold));
+            }
+
+            auto sums = _mm_sad_epu8(counts, zero);
+            result += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+        }
+#endif
+
+        for (; begin != end; ++begin)
+        {
+            result += ((static_cast<unsigned char>(*begin) & 0xC0) != 0x80) ? 1 : 0;
+        }
+
+        return result;
+    }
+
+    inline std::size_t count_code_points(const char16_t* begin, const char16_t* end, bool byteSwapped = false) noexcept
+    {
+        const std::uint16_t mask = byteSwapped ? 0x00FC : 0xFC00;
+        const std::uint16_t lowSurrogate = byteSwapped ? 0x00DC : 0xDC00;
+        std::size_t result = end - begin;
+
+#if DHORN_SSE2
+        const auto maskVector = _mm_set1_epi16(static_cast<short>(mask));
+        const auto lowSurrogateVector = _mm_set1_epi16(static_cast<short>(lowSurrogate));
+        while ((end - begin) >= 8)
+        {
+            // Same as above, but with 16-bit counters
+            auto blocks = (end - begin) / 8;
+            blocks = (blocks > 0x7FFF) ? 0x7FFF : blocks;
+
+            auto counts = _mm_setzero_si128();
+            for (; blocks > 0; --blocks, begin += 8)
+            {
+                auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                counts = _mm_sub_epi16(counts, _mm_cmpeq_epi16(_mm_and_si128(input, maskVector), lowSurrogateVector));
+            }
+
+            auto sums = _mm_madd_epi16(counts, _mm_set1_epi16(1));
+            sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2)));
+            sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+            result -= _mm_cvtsi128_si32(sums);
+        }
+#endif
+
+        for (; begin != end; ++begin)
+        {
+            result -= ((*begin & mask) == lowSurrogate) ? 1 : 0;
+        }
+
+        return result;
+    }
+
+    template <typename CharTy>
+    inline std::pair<std::size_t, std::size_t> count_code_points(const CharTy* str, bool byteSwapped = false) noexcept
+    {
+        // Returns the number of code points along with the number of code units
+        const auto length = std::char_traits<CharTy>::length(str);
+        if constexpr (std::is_same_v<CharTy, char16_t>)
+        {
+            return { count_code_points(str, str + length, byteSwapped), length };
+        }
+        else
+        {
+            (void)byteSwapped;
+            return { count_code_points(str, str + length), length };
+        }
+    }
+
+#pragma endregion
+
+
+
+    /*
+     * Encoding Detection
+     */
+#pragma region Encoding Detection
+
+    inline void count_zero_bytes(const char* begin, const char* end, std::size_t (&counts)[4]) noexcept
+    {
+        // Counts the number of zero bytes at each offset modulo four, relative to begin. Used to tell apart UTF-16 and
+        // UTF-32 text (in either byte order), where the high order bytes of most code units are zero
+        for (auto& count : counts)
+        {
+            count = 0;
+        }
+
+        auto pos = begin;
+#if DHORN_SSE2
+        const auto zero = _mm_setzero_si128();
+        while ((end - pos) >= 16)
+        {
+            // Accumulate per-byte counts for at most 255 blocks, then sum the counts for each offset separately
+            auto blocks = (end - pos) / 16;
+            blocks = (blocks > 255) ? 255 : blocks;
+
+            auto byteCounts = zero;
+            for (; blocks > 0; --blocks, pos += 16)
+            {
+                auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+                byteCounts = _mm_sub_epi8(byteCounts, _mm_cmpeq_epi8(input, zero));
+            }
+
+            for (int i = 0; i < 4; ++i)
+            {
+                auto mask = _mm_set1_epi32(static_cast<int>(0xFFu << (i * 8)));
+                auto sums = _mm_sad_epu8(_mm_and_si128(byteCounts, mask), zero);
+                counts[i] += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums));
+            }
+        }
+#endif
+
+        for (; pos != end; ++pos)
+        {
+            counts[(pos - begin) & 3] += (*pos == 0) ? 1 : 0;
+        }
+    }
+
+#pragma endregion
+
+
+
+    /*
+     * Transcoding
+     *
+     * Each of the following converts as many whole blocks as it can from the start of the input, stopping at the first
+     * block that contains a character that it can't handle. The updated input and output positions are returned, and it
+     * is up to the caller to handle whatever remains.
+     */
+#pragma region Transcoding
+
+    inline const char* ascii_prefix(const char* begin, const char* end) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 16)
+        {
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))))
+            {
+                break;
+            }
+
+            begin += 16;
+        }
+#else
+        (void)end;
+#endif
+
+        return begin;
+    }
+
+    inline const char16_t* ascii_prefix(const char16_t* begin, const char16_t* end) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 8)
+        {
+            if (!sse2_all_less_than_u16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), 0x80))
+            {
+                break;
+            }
+
+            begin += 8;
+        }
+#else
+        (void)end;
+#endif
+
+        return begin;
+    }
+
+    inline const char32_t* ascii_prefix(const char32_t* begin, const char32_t* end) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 4)
+        {
+            if (!sse2_all_less_than_u32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), 0x80))
+            {
+                break;
+            }
+
+            begin += 4;
+        }
+#else
+        (void)end;
+#endif
+
+        return begin;
+    }
+
+    inline std::pair<const char*, char16_t*> widen_ascii(const char* begin, const char* end, char16_t* dest) noexcept
+    {
+#if DHORN_SSE2
+        const auto zero = _mm_setzero_si128();
+        while ((end - begin) >= 16)
+        {
+            auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            if (_mm_movemask_epi8(input))
+            {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi8(input, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 8), _mm_unpackhi_epi8(input, zero));
+            begin += 16;
+            dest += 16;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+    inline std::pair<const char*, char32_t*> widen_ascii(const char* begin, const char* end, char32_t* dest) noexcept
+    {
+#if DHORN_SSE2
+        const auto zero = _mm_setzero_si128();
+        while ((end - begin) >= 16)
+        {
+            auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            if (_mm_movemask_epi8(input))
+            {
+                break;
+            }
+
+            auto low = _mm_unpacklo_epi8(input, zero);
+            auto high = _mm_unpackhi_epi8(input, zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 12), _mm_unpackhi_epi16(high, zero));
+            begin += 16;
+            dest += 16;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+    inline std::pair<const char16_t*, char*> narrow_ascii(
+        const char16_t* begin,
+        const char16_t* end,
+        char* dest) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 16)
+        {
+            auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 8));
+            if (!sse2_all_less_than_u16(_mm_or_si128(low, high), 0x80))
+            {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_packus_epi16(low, high));
+            begin += 16;
+            dest += 16;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+    inline std::pair<const char32_t*, char*> narrow_ascii(
+        const char32_t* begin,
+        const char32_t* end,
+        char* dest) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 16)
+        {
+            auto input0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto input1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 4));
+            auto input2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 8));
+            auto input3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 12));
+            auto combined = _mm_or_si128(_mm_or_si128(input0, input1), _mm_or_si128(input2, input3));
+            if (!sse2_all_less_than_u32(combined, 0x80))
+            {
+                break;
+            }
+
+            // All values are less than 0x80, so signed saturation is not a concern
+            auto low = _mm_packs_epi32(input0, input1);
+            auto high = _mm_packs_epi32(input2, input3);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_packus_epi16(low, high));
+            begin += 16;
+            dest += 16;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+    inline std::pair<const char16_t*, char32_t*> widen_bmp(
+        const char16_t* begin,
+        const char16_t* end,
+        char32_t* dest) noexcept
+    {
+#if DHORN_SSE2
+        const auto zero = _mm_setzero_si128();
+        while ((end - begin) >= 8)
+        {
+            auto input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            if (sse2_any_surrogate_u16(input))
+            {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(input, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4), _mm_unpackhi_epi16(input, zero));
+            begin += 8;
+            dest += 8;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+    inline std::pair<const char32_t*, char16_t*> narrow_bmp(
+        const char32_t* begin,
+        const char32_t* end,
+        char16_t* dest) noexcept
+    {
+#if DHORN_SSE2
+        while ((end - begin) >= 8)
+        {
+            auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 4));
+            if (!sse2_all_less_than_u32(_mm_or_si128(low, high), 0x1'0000) ||
+                sse2_any_surrogate_u32(low) || sse2_any_surrogate_u32(high))
+            {
+                break;
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), sse2_pack_u32(low, high));
+            begin += 8;
+            dest += 8;
+        }
+#else
+        (void)end;
+#endif
+
+        return { begin, dest };
+    }
+
+#pragma endregion
+}
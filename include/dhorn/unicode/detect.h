@@ -0,0 +1,251 @@
+/*
+ * Duncan Horn
+ *
+ * detect.h
+ *
+ * Detection of the encoding of a buffer of bytes, e.g. from a file whose encoding is not known up front. If the buffer
+ * starts with a byte order mark, that determines the encoding. Otherwise, a prefix of the buffer is scanned and the
+ * encoding is guessed from the distribution of zero bytes (which are common in UTF-16 and UTF-32 text, but not in UTF-8
+ * text) and from whether or not the prefix is valid in the candidate encoding. E.g.
+ *
+ *      if (auto result = detect_encoding(data, data + size))
+ *      {
+ *          auto [encoding, offset] = *result;
+ *          if (encoding == encoding::utf_16le)
+ *          {
+ *              auto begin = reinterpret_cast<const char16_t*>(data + offset);
+ *              ...
+ *          }
+ *      }
+ *
+ * If the prefix isn't valid in any of the encodings (e.g. it's binary data or uses some legacy code page), the encoding
+ * is unknown and std::nullopt is returned.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+
+#include "transcode.h"
+
+namespace dhorn::unicode
+{
+    /*
+     * detected_encoding
+     */
+    struct detected_encoding
+    {
+        unicode::encoding encoding;
+
+        // The offset of the start of the payload, i.e. the size of the byte order mark, if any
+        std::size_t offset;
+    };
+
+
+
+    namespace details
+    {
+        template <encoding Encoding>
+        inline bool has_byte_order_mark(const char* begin, const char* end) noexcept
+        {
+            constexpr auto& bom = encoding_traits<Encoding>::byte_order_mark;
+            return (static_cast<std::size_t>(end - begin) >= std::size(bom)) &&
+                (std::memcmp(begin, bom, std::size(bom)) == 0);
+        }
+
+        template <encoding Encoding>
+        inline std::uint32_t read_code_unit(const char* pos) noexcept
+        {
+            // Reads a code unit from an unaligned byte buffer
+            constexpr bool bigEndian = (Encoding == encoding::utf_16be) || (Encoding == encoding::utf_32be);
+            constexpr int size = sizeof(code_unit_t<Encoding>);
+
+            std::uint32_t result = 0;
+            for (int i = 0; i < size; ++i)
+            {
+                auto byte = static_cast<std::uint32_t>(static_cast<unsigned char>(pos[bigEndian ? i : (size - 1 - i)]));
+                result = (result << 8) | byte;
+            }
+
+            return result;
+        }
+
+        template <encoding Encoding>
+        inline bool is_valid_prefix(const char* begin, const char* end) noexcept
+        {
+            // The prefix is valid if it only contains valid code points, except possibly for one that's been truncated
+            // by the end of the prefix
+            if constexpr (Encoding == encoding::utf_8)
+            {
+                auto pos = encoding_traits<encoding::utf_8>::validate(begin, end);
+                return (pos == end) || is_incomplete<encoding::utf_8>(pos, end);
+            }
+            else if constexpr (is_utf16_encoding<Encoding>)
+            {
+                for (auto pos = begin; (end - pos) >= 2; pos += 2)
+                {
+                    auto unit = read_code_unit<Encoding>(pos);
+                    if (is_low_surrogate(unit))
+                    {
+                        return false;
+                    }
+                    else if (is_high_surrogate(unit))
+                    {
+                        if ((end - pos) < 4)
+                        {
+                            return true;
+                        }
+
+                        pos += 2;
+                        if (!is_low_surrogate(read_code_unit<Encoding>(pos)))
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                return true;
+            }
+            else
+            {
+                for (auto pos = begin; (end - pos) >= 4; pos += 4)
+                {
+                    if (!is_valid_code_point(read_code_unit<Encoding>(pos)))
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+        }
+
+        inline std::size_t count_distinct_bytes(const char* begin, const char* end, std::size_t offset) noexcept
+        {
+            // Number of distinct values among the bytes at every other position, starting with begin[offset]
+            bool seen[256] = {};
+            std::size_t result = 0;
+            const auto length = static_cast<std::size_t>(end - begin);
+            for (auto i = offset; i < length; i += 2)
+            {
+                auto& entry = seen[static_cast<unsigned char>(begin[i])];
+                result += entry ? 0 : 1;
+                entry = true;
+            }
+
+            return result;
+        }
+    }
+
+
+
+    /*
+     * detect_encoding
+     *
+     * Only the first prefixLength bytes of the buffer are scanned when there's no byte order mark. Returns std::nullopt
+     * if the encoding can't be determined
+     */
+    inline std::optional<detected_encoding> detect_encoding(
+        const char* begin,
+        const char* end,
+        std::size_t prefixLength = 4096) noexcept
+    {
+        // NOTE: The UTF-32LE byte order mark starts with the UTF-16LE byte order mark, so it must be checked first
+        if (details::has_byte_order_mark<encoding::utf_32le>(begin, end))
+        {
+            return detected_encoding{ encoding::utf_32le, 4 };
+        }
+        else if (details::has_byte_order_mark<encoding::utf_32be>(begin, end))
+        {
+            return detected_encoding{ encoding::utf_32be, 4 };
+        }
+        else if (details::has_byte_order_mark<encoding::utf_8>(begin, end))
+        {
+            return detected_encoding{ encoding::utf_8, 3 };
+        }
+        else if (details::has_byte_order_mark<encoding::utf_16le>(begin, end))
+        {
+            return detected_encoding{ encoding::utf_16le, 2 };
+        }
+        else if (details::has_byte_order_mark<encoding::utf_16be>(begin, end))
+        {
+            return detected_encoding{ encoding::utf_16be, 2 };
+        }
+
+        auto prefixEnd = (static_cast<std::size_t>(end - begin) > prefixLength) ? (begin + prefixLength) : end;
+        std::size_t zeros[4];
+        details::count_zero_bytes(begin, prefixEnd, zeros);
+        const auto length = static_cast<std::size_t>(prefixEnd - begin);
+
+        // If the prefix is the whole buffer, its length must be a multiple of the code unit size. Otherwise, the prefix
+        // may have cut off the last code unit
+        const bool truncated = (prefixEnd != end);
+        const bool maybeUtf32 = (length >= 4) && (truncated || ((length % 4) == 0));
+        const bool maybeUtf16 = (length >= 2) && (truncated || ((length % 2) == 0));
+
+        // Valid UTF-32 always has a zero high order byte. For a reasonable sized prefix this is very unlikely to occur
+        // for any other encoding
+        const auto codeUnits32 = length / 4;
+        if (maybeUtf32 && (zeros[3] >= codeUnits32) && (zeros[0] < codeUnits32) &&
+            details::is_valid_prefix<encoding::utf_32le>(begin, prefixEnd))
+        {
+            return detected_encoding{ encoding::utf_32le, 0 };
+        }
+        else if (maybeUtf32 && (zeros[0] >= codeUnits32) && (zeros[3] < codeUnits32) &&
+            details::is_valid_prefix<encoding::utf_32be>(begin, prefixEnd))
+        {
+            return detected_encoding{ encoding::utf_32be, 0 };
+        }
+
+        // UTF-16 text that contains a reasonable amount of ASCII/Latin-1 characters will have lots of zero bytes, but
+        // only in every other position. Require that at least a quarter of the code units have a zero high byte
+        const auto oddZeros = zeros[1] + zeros[3];
+        const auto evenZeros = zeros[0] + zeros[2];
+        const auto threshold = std::max<std::size_t>(1, (length / 2 + 3) / 4);
+        const bool looksLittleEndian = (oddZeros > evenZeros) && (oddZeros >= threshold);
+        const bool looksBigEndian = (evenZeros > oddZeros) && (evenZeros >= threshold);
+        if (maybeUtf16 && looksLittleEndian && details::is_valid_prefix<encoding::utf_16le>(begin, prefixEnd))
+        {
+            return detected_encoding{ encoding::utf_16le, 0 };
+        }
+        else if (maybeUtf16 && looksBigEndian && details::is_valid_prefix<encoding::utf_16be>(begin, prefixEnd))
+        {
+            return detected_encoding{ encoding::utf_16be, 0 };
+        }
+
+        if (details::is_valid_prefix<encoding::utf_8>(begin, prefixEnd))
+        {
+            return detected_encoding{ encoding::utf_8, 0 };
+        }
+
+        // Text made up of characters outside of ASCII/Latin-1 (e.g. CJK) has few, if any, zero bytes in UTF-16, but is
+        // very unlikely to be valid UTF-8. Fall back to UTF-16 for either byte order that the zero bytes don't rule out
+        if (maybeUtf16)
+        {
+            const bool littleEndian = !looksBigEndian && details::is_valid_prefix<encoding::utf_16le>(begin, prefixEnd);
+            const bool bigEndian = !looksLittleEndian && details::is_valid_prefix<encoding::utf_16be>(begin, prefixEnd);
+            if (littleEndian && bigEndian)
+            {
+                // Characters from the same script share the same high byte, so there are fewer distinct values in the
+                // high byte positions than in the low byte positions. Ties go to little endian
+                const auto oddDistinct = details::count_distinct_bytes(begin, prefixEnd, 1);
+                const auto evenDistinct = details::count_distinct_bytes(begin, prefixEnd, 0);
+                return detected_encoding{ (evenDistinct < oddDistinct) ? encoding::utf_16be : encoding::utf_16le, 0 };
+            }
+            else if (littleEndian)
+            {
+                return detected_encoding{ encoding::utf_16le, 0 };
+            }
+            else if (bigEndian)
+            {
+                return detected_encoding{ encoding::utf_16be, 0 };
+            }
+        }
+
+        return std::nullopt;
+    }
+}
@@ -11,6 +11,12 @@
 #include <cstddef>
 #include <iterator>
 #include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "details/simd.h"
 
 namespace dhorn::unicode
 {
@@ -154,6 +160,11 @@ namespace dhorn::unicode
 
     namespace details
     {
+        // True if Itr is a pointer to contiguous code units, in which case the vectorized implementations can be used
+        template <typename Itr, typename CharTy>
+        constexpr bool is_code_unit_pointer =
+            std::is_pointer_v<Itr> && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Itr>>, CharTy>;
+
         template <typename Traits, typename Itr>
         inline constexpr string_length length(Itr str) noexcept
         {
@@ -194,6 +205,83 @@ namespace dhorn::unicode
 
             return result;
         }
+
+        template <typename Traits, typename InputItr>
+        inline constexpr InputItr next(InputItr pos, InputItr end) noexcept
+        {
+            // Same as Traits::next, but never advances past end
+            for (auto size = Traits::code_point_size(*pos); size && (pos != end); --size)
+            {
+                ++pos;
+            }
+
+            return pos;
+        }
+
+        template <typename Traits, typename InputItr>
+        inline constexpr std::pair<char32_t, InputItr> read(InputItr pos, InputItr end) noexcept
+        {
+            // Same as Traits::read, but gives back eof if the code point extends past end
+            auto itr = pos;
+            for (auto size = Traits::code_point_size(*pos); size; --size, ++itr)
+            {
+                if (itr == end)
+                {
+                    return { eof, pos };
+                }
+            }
+
+            return Traits::read(pos);
+        }
+
+        template <typename Traits, typename Itr>
+        inline constexpr string_length length(Itr begin, Itr end) noexcept
+        {
+            string_length result = {};
+            while (begin != end)
+            {
+                auto nextItr = begin;
+                if constexpr (Traits::is_checked)
+                {
+                    char32_t ch;
+                    std::tie(ch, nextItr) = details::read<Traits>(begin, end);
+                    if (ch == eof)
+                    {
+                        // Same as above; code_units gives the location of the error
+                        result.code_points = npos;
+                        break;
+                    }
+                }
+                else
+                {
+                    nextItr = details::next<Traits>(begin, end);
+                }
+
+                result.code_units += std::distance(begin, nextItr);
+                ++result.code_points;
+                begin = nextItr;
+            }
+
+            return result;
+        }
+
+        template <typename CheckedTraits, typename ForwardItr>
+        inline constexpr ForwardItr validate(ForwardItr begin, ForwardItr end) noexcept
+        {
+            static_assert(CheckedTraits::is_checked);
+            while (begin != end)
+            {
+                auto [ch, nextItr] = details::read<CheckedTraits>(begin, end);
+                if (ch == eof)
+                {
+                    break;
+                }
+
+                begin = nextItr;
+            }
+
+            return begin;
+        }
     }
 
 
@@ -261,6 +349,18 @@ namespace dhorn::unicode
             return pos;
         }
 
+        template <typename InputItr>
+        static constexpr InputItr next(InputItr pos, InputItr end) noexcept
+        {
+            return details::next<encoding_traits>(pos, end);
+        }
+
+        template <typename InputItr>
+        static constexpr std::pair<char32_t, InputItr> read(InputItr pos, InputItr end) noexcept
+        {
+            return details::read<encoding_traits>(pos, end);
+        }
+
         template <typename InputItr>
         static constexpr std::pair<char32_t, InputItr> read(InputItr pos) noexcept
         {
@@ -366,9 +466,46 @@ namespace dhorn::unicode
         }
 
         template <typename Itr>
-        static constexpr string_length length(Itr str) noexcept
+        static string_length length(Itr str) noexcept
+        {
+            if constexpr (!Validate && details::is_code_unit_pointer<Itr, value_type>)
+            {
+                auto [codePoints, codeUnits] = details::count_code_points(&*str);
+                return { codePoints, codeUnits };
+            }
+            else
+            {
+                return details::length<encoding_traits>(str);
+            }
+        }
+
+        template <typename Itr>
+        static string_length length(Itr begin, Itr end) noexcept
+        {
+            if constexpr (!Validate && details::is_code_unit_pointer<Itr, value_type>)
+            {
+                return { details::count_code_points(begin, end), static_cast<std::size_t>(end - begin) };
+            }
+            else
+            {
+                return details::length<encoding_traits>(begin, end);
+            }
+        }
+
+        // Returns an iterator to the start of the first invalid code unit sequence in the range, or end if the range is
+        // valid. Unlike read, validation is strict and also rejects overlong encodings (see RFC 3629). Contiguous
+        // ranges of char use vectorized implementations when available
+        template <typename ForwardItr>
+        static ForwardItr validate(ForwardItr begin, ForwardItr end) noexcept
         {
-            return details::length<encoding_traits>(str);
+            if constexpr (details::is_code_unit_pointer<ForwardItr, value_type>)
+            {
+                return begin + (details::utf8_validate(begin, end) - begin);
+            }
+            else
+            {
+                return details::utf8_validate_scalar(begin, end);
+            }
         }
     };
 
@@ -447,6 +584,18 @@ namespace dhorn::unicode
                 return pos;
             }
 
+            template <typename InputItr>
+            static constexpr InputItr next(InputItr pos, InputItr end) noexcept
+            {
+                return details::next<utf16_traits_impl>(pos, end);
+            }
+
+            template <typename InputItr>
+            static constexpr std::pair<char32_t, InputItr> read(InputItr pos, InputItr end) noexcept
+            {
+                return details::read<utf16_traits_impl>(pos, end);
+            }
+
             template <typename InputItr>
             static constexpr std::pair<char32_t, InputItr> read(InputItr pos) noexcept
             {
@@ -509,9 +658,46 @@ namespace dhorn::unicode
             }
 
             template <typename Itr>
-            static constexpr string_length length(Itr str) noexcept
+            static string_length length(Itr str) noexcept
             {
-                return details::length<utf16_traits_impl>(str);
+                if constexpr (!Validate && is_code_unit_pointer<Itr, value_type>)
+                {
+                    auto [codePoints, codeUnits] = count_code_points(&*str, Endianness != endian::native);
+                    return { codePoints, codeUnits };
+                }
+                else
+                {
+                    return details::length<utf16_traits_impl>(str);
+                }
+            }
+
+            template <typename Itr>
+            static string_length length(Itr begin, Itr end) noexcept
+            {
+                if constexpr (!Validate && is_code_unit_pointer<Itr, value_type>)
+                {
+                    const auto codeUnits = static_cast<std::size_t>(end - begin);
+                    return { count_code_points(begin, end, Endianness != endian::native), codeUnits };
+                }
+                else
+                {
+                    return details::length<utf16_traits_impl>(begin, end);
+                }
+            }
+
+            // Returns an iterator to the start of the first invalid code unit sequence in the range (i.e. an unpaired
+            // surrogate), or end if the range is valid
+            template <typename ForwardItr>
+            static ForwardItr validate(ForwardItr begin, ForwardItr end) noexcept
+            {
+                if constexpr ((Endianness == endian::native) && is_code_unit_pointer<ForwardItr, value_type>)
+                {
+                    return begin + (utf16_validate(begin, end) - begin);
+                }
+                else
+                {
+                    return details::validate<utf16_traits_impl<Endianness, true>>(begin, end);
+                }
             }
         };
     }
@@ -588,6 +774,19 @@ namespace dhorn::unicode
                 return ++pos;
             }
 
+            template <typename InputItr>
+            static constexpr InputItr next(InputItr pos, InputItr) noexcept
+            {
+                return ++pos;
+            }
+
+            template <typename InputItr>
+            static constexpr std::pair<char32_t, InputItr> read(InputItr pos, InputItr) noexcept
+            {
+                // NOTE: Code points are always a single code unit, so there's no way to read past the end
+                return read(pos);
+            }
+
             template <typename InputItr>
             static constexpr std::pair<char32_t, InputItr> read(InputItr pos) noexcept
             {
@@ -621,7 +820,45 @@ namespace dhorn::unicode
             template <typename Itr>
             static constexpr string_length length(Itr str) noexcept
             {
-                return details::length<utf32_traits_impl>(str);
+                if constexpr (!Validate && is_code_unit_pointer<Itr, value_type>)
+                {
+                    // Every code unit is a code point
+                    const auto codeUnits = std::char_traits<value_type>::length(&*str);
+                    return { codeUnits, codeUnits };
+                }
+                else
+                {
+                    return details::length<utf32_traits_impl>(str);
+                }
+            }
+
+            template <typename Itr>
+            static constexpr string_length length(Itr begin, Itr end) noexcept
+            {
+                if constexpr (!Validate)
+                {
+                    const auto codeUnits = static_cast<std::size_t>(std::distance(begin, end));
+                    return { codeUnits, codeUnits };
+                }
+                else
+                {
+                    return details::length<utf32_traits_impl>(begin, end);
+                }
+            }
+
+            // Returns an iterator to the first code unit in the range that is not a valid code point, or end if the
+            // range is valid
+            template <typename ForwardItr>
+            static ForwardItr validate(ForwardItr begin, ForwardItr end) noexcept
+            {
+                if constexpr ((Endianness == endian::native) && is_code_unit_pointer<ForwardItr, value_type>)
+                {
+                    return begin + (utf32_validate(begin, end) - begin);
+                }
+                else
+                {
+                    return details::validate<utf32_traits_impl<Endianness, true>>(begin, end);
+                }
             }
         };
     }
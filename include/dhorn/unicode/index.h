@@ -0,0 +1,262 @@
+/*
+ * Duncan Horn
+ *
+ * index.h
+ *
+ * A sparse index over a UTF-8 or UTF-16 string that allows looking up code points by their index without having to
+ * walk the string from the start. The index records the code unit offset of every K-th code point (where K is the
+ * stride), so finding the N-th code point is a lookup followed by a scan over at most K - 1 code points. E.g.
+ *
+ *      code_point_index index(str.data(), str.data() + str.size());
+ *      auto ch = index[1000];                  // Decodes the code point at index 1000
+ *      auto view = index.substr(1000, 10);     // Code units that make up code points [1000, 1010)
+ *      auto count = index.length();            // Number of code points in the string
+ *
+ * The index does not own the string, which must outlive it and not be modified while the index is in use. The string
+ * is assumed to be valid; use encoding_traits<Encoding>::validate beforehand if that isn't already known.
+ */
+#pragma once
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "encoding.h"
+
+namespace dhorn::unicode
+{
+    /*
+     * code_point_index
+     */
+#pragma region code_point_index
+
+    template <encoding Encoding = encoding::utf_8>
+    class code_point_index
+    {
+        using traits = encoding_traits<Encoding>;
+
+        static_assert((Encoding == encoding::utf_8) || (Encoding == encoding::utf_16le) ||
+            (Encoding == encoding::utf_16be),
+            "dhorn::unicode::code_point_index only supports UTF-8 and UTF-16; UTF-32 is already random access");
+
+    public:
+        /*
+         * Public Types
+         */
+        using value_type = typename traits::value_type;
+        using const_pointer = typename traits::const_pointer;
+        using size_type = std::size_t;
+        using string_view_type = std::basic_string_view<value_type>;
+
+        static constexpr size_type default_stride = 128;
+
+
+
+        /*
+         * Constructor(s)/Destructor
+         */
+        code_point_index() = default;
+
+        code_point_index(const_pointer begin, const_pointer end, size_type stride = default_stride) :
+            _begin(begin),
+            _end(end),
+            _stride((stride == 0) ? 1 : stride)
+        {
+            this->build();
+        }
+
+        template <typename Traits, typename Alloc>
+        explicit code_point_index(
+            const std::basic_string<value_type, Traits, Alloc>& str,
+            size_type stride = default_stride) :
+            code_point_index(str.data(), str.data() + str.size(), stride)
+        {
+        }
+
+        explicit code_point_index(string_view_type str, size_type stride = default_stride) :
+            code_point_index(str.data(), str.data() + str.size(), stride)
+        {
+        }
+
+
+
+        /*
+         * Accessors
+         */
+        const_pointer begin() const noexcept
+        {
+            return this->_begin;
+        }
+
+        const_pointer end() const noexcept
+        {
+            return this->_end;
+        }
+
+        size_type stride() const noexcept
+        {
+            return this->_stride;
+        }
+
+        size_type length() const noexcept
+        {
+            // Number of code points
+            return this->_length;
+        }
+
+        size_type size() const noexcept
+        {
+            // Number of code units
+            return static_cast<size_type>(this->_end - this->_begin);
+        }
+
+        bool empty() const noexcept
+        {
+            return this->_begin == this->_end;
+        }
+
+
+
+        /*
+         * Lookup
+         */
+        const_pointer find(size_type index) const noexcept
+        {
+            // Returns a pointer to the first code unit of the code point at the specified index, or end() if the index
+            // is past the end
+            if (index >= this->_length)
+            {
+                return this->_end;
+            }
+
+            auto pos = this->_begin + this->_checkpoints[index / this->_stride];
+            for (auto count = index % this->_stride; count > 0; --count)
+            {
+                pos = traits::next(pos);
+            }
+
+            return pos;
+        }
+
+        size_type offset(size_type index) const noexcept
+        {
+            // Code unit offset of the code point at the specified index
+            return static_cast<size_type>(this->find(index) - this->_begin);
+        }
+
+        char32_t operator[](size_type index) const noexcept
+        {
+            assert(index < this->_length);
+            return traits::read(this->find(index)).first;
+        }
+
+        char32_t at(size_type index) const
+        {
+            if (index >= this->_length)
+            {
+                throw std::out_of_range("code point index out of range");
+            }
+
+            return (*this)[index];
+        }
+
+        string_view_type substr(size_type pos = 0, size_type count = string_view_type::npos) const
+        {
+            // Same as std::basic_string::substr, only pos and count are in code points and not code units
+            if (pos > this->_length)
+            {
+                throw std::out_of_range("code point index out of range");
+            }
+
+            auto first = this->find(pos);
+            auto last = (count >= (this->_length - pos)) ? this->_end : this->find_from(first, pos, pos + count);
+            return string_view_type(first, static_cast<size_type>(last - first));
+        }
+
+
+
+    private:
+
+        const_pointer find_from(const_pointer pos, size_type posIndex, size_type index) const noexcept
+        {
+            // Start from whichever is closer: the current position or the checkpoint at or before index. Both come
+            // before the target code point
+            if ((index - posIndex) >= (index % this->_stride))
+            {
+                return this->find(index);
+            }
+
+            for (auto count = index - posIndex; count > 0; --count)
+            {
+                pos = traits::next(pos);
+            }
+
+            return pos;
+        }
+
+        void build()
+        {
+            // Rather than walking each code point, count them a block of code units at a time. Since every code point
+            // is at least one code unit, a block of (stride - counted) code units can't overshoot the next checkpoint
+            const auto codeUnits = this->size();
+            this->_checkpoints.reserve(codeUnits / this->_stride + 1);
+
+            auto pos = this->_begin;
+            size_type counted = 0;
+            if (pos != this->_end)
+            {
+                this->_checkpoints.push_back(0);
+            }
+
+            while (pos != this->_end)
+            {
+                auto blockSize = this->_stride - counted;
+                auto blockEnd = (static_cast<size_type>(this->_end - pos) > blockSize) ? (pos + blockSize) : this->_end;
+                counted += count(pos, blockEnd);
+                pos = blockEnd;
+
+                if (counted == this->_stride)
+                {
+                    // The block may have ended in the middle of the last code point
+                    while ((pos != this->_end) && !traits::is_initial_code_unit(*pos))
+                    {
+                        ++pos;
+                    }
+
+                    this->_length += counted;
+                    counted = 0;
+                    if (pos != this->_end)
+                    {
+                        this->_checkpoints.push_back(static_cast<size_type>(pos - this->_begin));
+                    }
+                }
+            }
+
+            this->_length += counted;
+        }
+
+        static size_type count(const_pointer begin, const_pointer end) noexcept
+        {
+            if constexpr (Encoding == encoding::utf_8)
+            {
+                return details::count_code_points(begin, end);
+            }
+            else
+            {
+                return details::count_code_points(begin, end, Encoding != encoding::utf_16);
+            }
+        }
+
+        const_pointer _begin = nullptr;
+        const_pointer _end = nullptr;
+        size_type _stride = default_stride;
+        size_type _length = 0;
+
+        // Code unit offset of every stride-th code point, starting with the first
+        std::vector<size_type> _checkpoints;
+    };
+
+#pragma endregion
+}
@@ -148,6 +148,140 @@ namespace dhorn::unicode
 
 
 
+    /*
+     * bounded_iterator
+     *
+     * Same as iterator, except that it is constructed with both the current position and the end of the range and will
+     * never read or advance past the end. This allows iterating over strings that are not null terminated (e.g. network
+     * and file buffers), even when the last code point has been truncated. Dereferencing such a truncated code point
+     * gives eof and incrementing it gives an iterator equal to end.
+     */
+#pragma region bounded_iterator
+
+    template <
+        typename Itr,
+        encoding Encoding = character_encoding_v<typename std::iterator_traits<Itr>::value_type>,
+        typename Traits = encoding_traits<Encoding>>
+    class bounded_iterator
+    {
+        using underlying_category = typename std::iterator_traits<Itr>::iterator_category;
+        static_assert(std::is_base_of_v<std::forward_iterator_tag, underlying_category>,
+            "dhorn::unicode::bounded_iterator must be used with iterators that satisfy at least ForwardIterator");
+
+    public:
+        /*
+         * Public Types
+         */
+        using value_type = char32_t;
+        using reference = char32_t;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::common_type_t<std::bidirectional_iterator_tag, underlying_category>;
+
+
+
+        /*
+         * Constructor(s)/Destructor
+         */
+        bounded_iterator() = default;
+
+        bounded_iterator(Itr itr, Itr end) :
+            _itr(itr),
+            _end(end)
+        {
+        }
+
+
+
+        /*
+         * Accessors
+         */
+        Itr base() const noexcept
+        {
+            return this->_itr;
+        }
+
+        Itr end() const noexcept
+        {
+            return this->_end;
+        }
+
+
+
+        /*
+         * Forward Iterator
+         */
+        bool operator==(const bounded_iterator& other) const
+        {
+            return !(*this != other);
+        }
+
+        bool operator!=(const bounded_iterator& other) const
+        {
+            // NOTE: Only the current position is compared so that iterators can be compared against end iterators
+            // constructed as bounded_iterator(end, end)
+            return this->_itr != other._itr;
+        }
+
+        reference operator*() const
+        {
+            return Traits::read(this->_itr, this->_end).first;
+        }
+
+        bounded_iterator& operator++()
+        {
+            this->_itr = Traits::next(this->_itr, this->_end);
+            return *this;
+        }
+
+        bounded_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+
+
+        /*
+         * Bidirectional Iterator
+         */
+        template <
+            typename Category = iterator_category,
+            std::enable_if_t<std::is_base_of_v<std::bidirectional_iterator_tag, Category>, int> = 0>
+        bounded_iterator& operator--()
+        {
+            do
+            {
+                --this->_itr;
+            }
+            while (!Traits::is_initial_code_unit(*this->_itr));
+
+            return *this;
+        }
+
+        template <
+            typename Category = iterator_category,
+            std::enable_if_t<std::is_base_of_v<std::bidirectional_iterator_tag, Category>, int> = 0>
+        bounded_iterator operator--(int)
+        {
+            auto copy = *this;
+            --(*this);
+            return copy;
+        }
+
+
+
+    private:
+
+        Itr _itr{};
+        Itr _end{};
+    };
+
+#pragma endregion
+
+
+
     /*
      * output_iterator
      */
@@ -0,0 +1,490 @@
+/*
+ * Duncan Horn
+ *
+ * transcode.h
+ *
+ * Bulk conversion between any two Unicode encodings. Unlike reading/writing one code point at a time through
+ * unicode::iterator and unicode::output_iterator, these functions operate on whole ranges of code units at once, using
+ * vectorized fast paths for runs of ASCII text (and for runs of BMP text between UTF-16 and UTF-32). E.g.
+ *
+ *      auto [pos, length] = transcoded_length<encoding::utf_8, encoding::utf_16>(begin, end);
+ *      if (pos != end) { // Invalid input at 'pos' }
+ *      auto buffer = std::make_unique<char16_t[]>(length);
+ *      transcode<encoding::utf_8, encoding::utf_16>(begin, end, buffer.get());
+ *
+ * Input is always validated (strictly, so that e.g. overlong UTF-8 encodings and unpaired surrogates are considered
+ * errors). When invalid input is encountered, transcoding stops and the returned input position points to the start of
+ * the invalid code unit sequence. Everything before that point will have been transcoded.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "encoding.h"
+
+namespace dhorn::unicode
+{
+    /*
+     * transcode_result/transcode_length_result
+     */
+    template <typename FromCharTy, typename ToCharTy>
+    struct transcode_result
+    {
+        // Where transcoding stopped; either the end of the input, or the start of the first invalid code unit sequence
+        const FromCharTy* input;
+
+        // One past the last code unit written
+        ToCharTy* output;
+    };
+
+    template <typename CharTy>
+    struct transcode_length_result
+    {
+        // Where the calculation stopped; either the end of the input, or the start of the first invalid code unit
+        // sequence
+        const CharTy* input;
+
+        // The number of code units needed to hold the transcoded input (up until 'input')
+        std::size_t length;
+    };
+
+
+
+    namespace details
+    {
+        template <encoding Encoding>
+        using code_unit_t = typename encoding_traits<Encoding>::value_type;
+
+        template <encoding Encoding>
+        constexpr bool is_native_encoding =
+            (Encoding == encoding::utf_8) || (Encoding == encoding::utf_16) || (Encoding == encoding::utf_32);
+
+        template <encoding Encoding>
+        constexpr bool is_utf16_encoding = (Encoding == encoding::utf_16le) || (Encoding == encoding::utf_16be);
+
+        // Number of input code units that get processed one code point at a time before trying the fast path again
+        constexpr std::ptrdiff_t transcode_scalar_run = 16;
+
+
+
+        /*
+         * decode
+         *
+         * Reads a single code point, making sure not to read past the end of the input. On failure, returns eof along
+         * with the input position
+         */
+        template <encoding Encoding>
+        inline constexpr std::pair<char32_t, const code_unit_t<Encoding>*> decode(
+            const code_unit_t<Encoding>* pos,
+            const code_unit_t<Encoding>* end) noexcept
+        {
+            using traits = encoding_traits<Encoding>;
+            if constexpr (Encoding == encoding::utf_8)
+            {
+                // NOTE: This is the same check as utf8_validate_code_point, but computes the value as it goes
+                const auto lead = static_cast<unsigned char>(*pos);
+                if (lead < 0x80)
+                {
+                    return { lead, pos + 1 };
+                }
+
+                const auto [size, low, high] = utf8_lead(lead);
+                if ((size == 0) || ((end - pos) < size))
+                {
+                    return { eof, pos };
+                }
+
+                const auto second = static_cast<unsigned char>(pos[1]);
+                if ((second < low) || (second > high))
+                {
+                    return { eof, pos };
+                }
+
+                char32_t value = ((lead & (0x7F >> size)) << 6) | (second & 0x3F);
+                for (int i = 2; i < size; ++i)
+                {
+                    const auto byte = static_cast<unsigned char>(pos[i]);
+                    if ((byte & 0xC0) != 0x80)
+                    {
+                        return { eof, pos };
+                    }
+
+                    value = (value << 6) | (byte & 0x3F);
+                }
+
+                return { value, pos + size };
+            }
+            else if constexpr (is_utf16_encoding<Encoding>)
+            {
+                char32_t value = traits::normalize(*pos);
+                if (!is_high_surrogate(value))
+                {
+                    if (is_low_surrogate(value))
+                    {
+                        return { eof, pos };
+                    }
+
+                    return { value, pos + 1 };
+                }
+
+                if ((end - pos) < 2)
+                {
+                    return { eof, pos };
+                }
+
+                char32_t low = traits::normalize(pos[1]);
+                if (!is_low_surrogate(low))
+                {
+                    return { eof, pos };
+                }
+
+                return { (((value & 0x03FF) << 10) | (low & 0x03FF)) + 0x01'0000, pos + 2 };
+            }
+            else
+            {
+                char32_t value = traits::normalize(*pos);
+                if (!is_valid_code_point(value))
+                {
+                    return { eof, pos };
+                }
+
+                return { value, pos + 1 };
+            }
+        }
+
+
+
+        /*
+         * is_incomplete
+         *
+         * Returns true if [pos, end) is the start of a valid code point that has been cut off by the end of the input,
+         * i.e. decode failed only because there wasn't enough input
+         */
+        template <encoding Encoding>
+        inline constexpr bool is_incomplete(const code_unit_t<Encoding>* pos, const code_unit_t<Encoding>* end) noexcept
+        {
+            const auto count = end - pos;
+            if constexpr (Encoding == encoding::utf_8)
+            {
+                if (count == 0)
+                {
+                    return false;
+                }
+
+                const auto [size, low, high] = utf8_lead(static_cast<unsigned char>(*pos));
+                if (count >= size)
+                {
+                    return false;
+                }
+
+                if (count >= 2)
+                {
+                    const auto second = static_cast<unsigned char>(pos[1]);
+                    if ((second < low) || (second > high))
+                    {
+                        return false;
+                    }
+                }
+
+                return (count < 3) || ((static_cast<unsigned char>(pos[2]) & 0xC0) == 0x80);
+            }
+            else if constexpr (is_utf16_encoding<Encoding>)
+            {
+                return (count == 1) && is_high_surrogate(encoding_traits<Encoding>::normalize(*pos));
+            }
+            else
+            {
+                // UTF-32 code points can't be split
+                return false;
+            }
+        }
+
+
+
+        /*
+         * transcode_fast
+         *
+         * Dispatches to the vectorized fast path for the given encodings, if one exists
+         */
+        template <encoding From, encoding To>
+        inline std::pair<const code_unit_t<From>*, code_unit_t<To>*> transcode_fast(
+            const code_unit_t<From>* begin,
+            [[maybe_unused]] const code_unit_t<From>* end,
+            code_unit_t<To>* dest) noexcept
+        {
+            constexpr bool native = is_native_encoding<From> && is_native_encoding<To>;
+            if constexpr (native && (From == encoding::utf_8))
+            {
+                return widen_ascii(begin, end, dest);
+            }
+            else if constexpr (native && (To == encoding::utf_8))
+            {
+                return narrow_ascii(begin, end, dest);
+            }
+            else if constexpr (native && (From == encoding::utf_16))
+            {
+                return widen_bmp(begin, end, dest);
+            }
+            else if constexpr (native && (From == encoding::utf_32))
+            {
+                return narrow_bmp(begin, end, dest);
+            }
+            else
+            {
+                return { begin, dest };
+            }
+        }
+    }
+
+
+
+    /*
+     * transcoded_length
+     *
+     * Calculates the number of code units needed to hold the result of transcoding the input. This is intended to be
+     * used as a pre-pass to size the output of transcode exactly
+     */
+    template <encoding From, encoding To>
+    inline transcode_length_result<details::code_unit_t<From>> transcoded_length(
+        const details::code_unit_t<From>* begin,
+        const details::code_unit_t<From>* end) noexcept
+    {
+        if constexpr (From == To)
+        {
+            auto pos = encoding_traits<From>::validate(begin, end);
+            return { pos, static_cast<std::size_t>(pos - begin) };
+        }
+        else
+        {
+            std::size_t length = 0;
+            while (begin != end)
+            {
+                if constexpr (details::is_native_encoding<From>)
+                {
+                    // ASCII characters are a single code unit in every encoding
+                    auto asciiEnd = details::ascii_prefix(begin, end);
+                    length += asciiEnd - begin;
+                    begin = asciiEnd;
+                }
+
+                auto stop = ((end - begin) > details::transcode_scalar_run) ?
+                    (begin + details::transcode_scalar_run) : end;
+                while (begin < stop)
+                {
+                    auto [ch, next] = details::decode<From>(begin, end);
+                    if (ch == eof)
+                    {
+                        return { begin, length };
+                    }
+
+                    length += encoding_traits<To>::code_point_size(ch);
+                    begin = next;
+                }
+            }
+
+            return { begin, length };
+        }
+    }
+
+
+
+    /*
+     * transcode
+     *
+     * Transcodes the input to the output buffer, which must be large enough to hold the result (see transcoded_length).
+     * The overload that takes a std::basic_string appends to it, sizing it exactly. In that case, the string is left
+     * unmodified if the input is invalid.
+     */
+    template <encoding From, encoding To>
+    inline transcode_result<details::code_unit_t<From>, details::code_unit_t<To>> transcode(
+        const details::code_unit_t<From>* begin,
+        const details::code_unit_t<From>* end,
+        details::code_unit_t<To>* dest) noexcept
+    {
+        if constexpr (From == To)
+        {
+            auto pos = encoding_traits<From>::validate(begin, end);
+            auto count = pos - begin;
+            std::memcpy(dest, begin, count * sizeof(*begin));
+            return { pos, dest + count };
+        }
+        else
+        {
+            while (begin != end)
+            {
+                auto [input, output] = details::transcode_fast<From, To>(begin, end, dest);
+                begin = input;
+                dest = output;
+
+                auto stop = ((end - begin) > details::transcode_scalar_run) ?
+                    (begin + details::transcode_scalar_run) : end;
+                while (begin < stop)
+                {
+                    auto [ch, next] = details::decode<From>(begin, end);
+                    if (ch == eof)
+                    {
+                        return { begin, dest };
+                    }
+
+                    dest = encoding_traits<To>::write(dest, ch);
+                    begin = next;
+                }
+            }
+
+            return { begin, dest };
+        }
+    }
+
+    template <encoding From, encoding To, typename Traits, typename Alloc>
+    inline transcode_result<details::code_unit_t<From>, details::code_unit_t<To>> transcode(
+        const details::code_unit_t<From>* begin,
+        const details::code_unit_t<From>* end,
+        std::basic_string<details::code_unit_t<To>, Traits, Alloc>& dest)
+    {
+        auto [pos, length] = transcoded_length<From, To>(begin, end);
+        if (pos != end)
+        {
+            return { pos, dest.data() + dest.size() };
+        }
+
+        auto offset = dest.size();
+        dest.resize(offset + length);
+
+        auto result = transcode<From, To>(begin, end, dest.data() + offset);
+        assert(result.output == (dest.data() + dest.size()));
+        return result;
+    }
+
+
+
+    /*
+     * streaming_transcoder
+     *
+     * Transcodes input that arrives in chunks (e.g. from a socket), where the boundaries between chunks are arbitrary
+     * and may split code points. Any code units at the end of a chunk that make up an incomplete code point are held
+     * onto and prepended to the next chunk. The interior of each chunk goes through the same bulk path as transcode.
+     * E.g.
+     *
+     *      streaming_transcoder<encoding::utf_8, encoding::utf_16> transcoder;
+     *      while (auto size = socket.receive(buffer))
+     *      {
+     *          auto result = transcoder.feed(buffer, buffer + size, output);
+     *          if (result.input != buffer + size) { // Invalid input }
+     *      }
+     *      if (!transcoder.finish()) { // Input ended in the middle of a code point }
+     *
+     * The output buffer must be able to hold at least max_output_length(chunkSize) code units. On invalid input, feed
+     * stops and returns the position of the start of the invalid sequence (or the start of the chunk if the invalid
+     * sequence began in a previous chunk), after which any held code units are discarded.
+     */
+    template <encoding From, encoding To>
+    class streaming_transcoder
+    {
+    public:
+        /*
+         * Public Types
+         */
+        using input_type = details::code_unit_t<From>;
+        using output_type = details::code_unit_t<To>;
+        using result_type = transcode_result<input_type, output_type>;
+
+
+
+        /*
+         * Transcoding
+         */
+        static constexpr std::size_t max_output_length(std::size_t inputLength) noexcept
+        {
+            // Account for the code units being held from the previous chunk, and then the most code units that a single
+            // input code unit can expand to
+            constexpr std::size_t fromSize = encoding_traits<From>::max_code_point_size;
+            constexpr std::size_t toSize = encoding_traits<To>::max_code_point_size;
+            constexpr std::size_t ratio = (fromSize == 4) ? 1 : (fromSize == 2) ? ((toSize == 4) ? 3 : 1) : toSize;
+            return (inputLength + fromSize - 1) * ratio;
+        }
+
+        result_type feed(const input_type* begin, const input_type* end, output_type* dest) noexcept
+        {
+            if (this->_partialLength)
+            {
+                // Finish the code point that was split across chunks. Either it completes, it's still incomplete (i.e.
+                // this chunk was very small), or it's invalid
+                auto length = this->_partialLength;
+                for (auto pos = begin; (length < std::size(this->_partial)) && (pos != end); ++length)
+                {
+                    this->_partial[length] = *pos++;
+                }
+
+                auto [ch, next] = details::decode<From>(this->_partial, this->_partial + length);
+                if (ch == eof)
+                {
+                    if (details::is_incomplete<From>(this->_partial, this->_partial + length))
+                    {
+                        this->_partialLength = length;
+                        return { end, dest };
+                    }
+
+                    this->_partialLength = 0;
+                    return { begin, dest };
+                }
+
+                dest = encoding_traits<To>::write(dest, ch);
+                begin += (next - this->_partial) - this->_partialLength;
+                this->_partialLength = 0;
+            }
+
+            auto result = transcode<From, To>(begin, end, dest);
+            if ((result.input != end) && details::is_incomplete<From>(result.input, end))
+            {
+                this->_partialLength = end - result.input;
+                std::memcpy(this->_partial, result.input, this->_partialLength * sizeof(input_type));
+                result.input = end;
+            }
+
+            return result;
+        }
+
+        template <typename Traits, typename Alloc>
+        result_type feed(
+            const input_type* begin,
+            const input_type* end,
+            std::basic_string<output_type, Traits, Alloc>& dest)
+        {
+            // Appends to the string
+            auto offset = dest.size();
+            dest.resize(offset + max_output_length(end - begin));
+
+            auto result = this->feed(begin, end, dest.data() + offset);
+            dest.resize(result.output - dest.data());
+            return { result.input, dest.data() + dest.size() };
+        }
+
+        bool finish() noexcept
+        {
+            // Returns false if the input ended in the middle of a code point. Either way, the transcoder is reset and
+            // can be used for a new stream
+            auto complete = (this->_partialLength == 0);
+            this->_partialLength = 0;
+            return complete;
+        }
+
+        bool has_partial_code_point() const noexcept
+        {
+            return this->_partialLength != 0;
+        }
+
+
+
+    private:
+
+        input_type _partial[encoding_traits<From>::max_code_point_size] = {};
+        std::size_t _partialLength = 0;
+    };
+
+    // Decoding is just transcoding to native UTF-32
+    template <encoding From>
+    using streaming_decoder = streaming_transcoder<From, encoding::utf_32>;
+}
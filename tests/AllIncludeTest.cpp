@@ -12,6 +12,7 @@
 #include <dhorn/compressed_base.h>
 #include <dhorn/compressed_pair.h>
 #include <dhorn/console.h>
+#include <dhorn/cpu_features.h>
 #include <dhorn/crtp_base.h>
 #include <dhorn/debug.h>
 #include <dhorn/functional.h>
@@ -30,8 +31,12 @@
 #include <dhorn/com/hresult_error.h>
 
 // Unicode Includes
+#include <dhorn/unicode/case_fold.h>
+#include <dhorn/unicode/detect.h>
 #include <dhorn/unicode/encoding.h>
+#include <dhorn/unicode/index.h>
 #include <dhorn/unicode/iterator.h>
+#include <dhorn/unicode/transcode.h>
 
 // Windows Includes
 #include <dhorn/windows/file_time_clock.h>
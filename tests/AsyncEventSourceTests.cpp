@@ -0,0 +1,332 @@
+/*
+ * Duncan Horn
+ *
+ * AsyncEventSourceTests.cpp
+ *
+ * Tests for the dhorn async_event_source class
+ */
+
+#include <atomic>
+#include <chrono>
+#include <dhorn/experimental/async_event_source.h>
+#include <dhorn/thread_pool.h>
+#include <future>
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using source_type = dhorn::experimental::async_event_source<void(int)>;
+
+// Adds a subscriber that blocks on the first event until the returned promise is set and records the values of all
+// events that it receives
+static std::promise<void> AddBlockingSubscriber(
+    source_type &source,
+    std::vector<int> &values,
+    dhorn::experimental::async_event_policy policy,
+    std::size_t maxPending = std::numeric_limits<std::size_t>::max())
+{
+    std::promise<void> gate;
+    auto future = gate.get_future().share();
+    source.add([&values, future](int value)
+    {
+        future.wait();
+        values.push_back(value);
+    }, policy, maxPending);
+
+    return gate;
+}
+
+TEST(AsyncEventSourceTests, InvokeAllTest)
+{
+    dhorn::thread_pool pool;
+    std::atomic_int x{ 0 };
+
+    {
+        source_type source(pool);
+        source.add([&](int value) { x += value; });
+        source.add([&](int value) { x += 2 * value; });
+        ASSERT_EQ(static_cast<std::size_t>(2), source.size());
+
+        source.invoke_all_for_completion(1).get();
+        ASSERT_EQ(3, x.load());
+
+        source.invoke_all(2);
+        source.invoke_all_for_completion(3).get();
+        ASSERT_EQ(18, x.load());
+    }
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, OrderingTest)
+{
+    const int testCount = 1000;
+    dhorn::thread_pool pool;
+    std::vector<int> values;
+
+    {
+        source_type source(pool);
+        source.add([&](int value) { values.push_back(value); });
+
+        std::future<void> future;
+        for (int i = 0; i < testCount; ++i)
+        {
+            future = source.invoke_all_for_completion(i);
+        }
+
+        future.get();
+    }
+
+    ASSERT_EQ(static_cast<std::size_t>(testCount), values.size());
+    for (int i = 0; i < testCount; ++i)
+    {
+        ASSERT_EQ(i, values[i]);
+    }
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, BoundedQueuePolicyTest)
+{
+    dhorn::thread_pool pool;
+    std::vector<int> values;
+
+    {
+        source_type source(pool);
+        auto gate = AddBlockingSubscriber(source, values, dhorn::experimental::async_event_policy::bounded_queue, 2);
+
+        // The first event may or may not be picked up before the rest arrive, but either way, only the last
+        // two events should remain after it
+        auto first = source.invoke_all_for_completion(1);
+        std::vector<std::future<void>> futures;
+        for (int i = 2; i <= 5; ++i)
+        {
+            futures.push_back(source.invoke_all_for_completion(i));
+        }
+
+        // Events 2 and 3 were discarded, so they should be complete
+        futures[0].get();
+        futures[1].get();
+
+        gate.set_value();
+        futures.back().get();
+    }
+
+    ASSERT_TRUE(values.size() >= 2);
+    ASSERT_EQ(4, values[values.size() - 2]);
+    ASSERT_EQ(5, values.back());
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, LatestWinsPolicyTest)
+{
+    dhorn::thread_pool pool;
+    std::vector<int> values;
+
+    {
+        source_type source(pool);
+        auto gate = AddBlockingSubscriber(source, values, dhorn::experimental::async_event_policy::latest_wins);
+
+        std::future<void> future;
+        for (int i = 1; i <= 5; ++i)
+        {
+            future = source.invoke_all_for_completion(i);
+        }
+
+        gate.set_value();
+        future.get();
+    }
+
+    // At most one event (the first) can be in flight, so we should have seen at most two events
+    ASSERT_TRUE((values.size() == 1) || (values.size() == 2));
+    ASSERT_EQ(5, values.back());
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, DropPolicyTest)
+{
+    dhorn::thread_pool pool;
+    std::vector<int> values;
+
+    {
+        source_type source(pool);
+        auto gate = AddBlockingSubscriber(source, values, dhorn::experimental::async_event_policy::drop);
+
+        auto first = source.invoke_all_for_completion(1);
+        for (int i = 2; i <= 5; ++i)
+        {
+            // The subscriber is still busy, so these should get dropped (and therefore complete) right away
+            source.invoke_all_for_completion(i).get();
+        }
+
+        gate.set_value();
+        first.get();
+    }
+
+    ASSERT_EQ(static_cast<std::size_t>(1), values.size());
+    ASSERT_EQ(1, values[0]);
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, ExceptionTest)
+{
+    dhorn::thread_pool pool;
+    std::atomic_int x{ 0 };
+
+    {
+        source_type source(pool);
+        source.add([](int) { throw std::runtime_error("Expected"); });
+        source.add([&](int value) { x += value; });
+
+        ASSERT_THROW(source.invoke_all_for_completion(42).get(), std::runtime_error);
+
+        // The other subscriber should still have been invoked
+        ASSERT_EQ(42, x.load());
+    }
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, RemoveTest)
+{
+    dhorn::thread_pool pool;
+    std::vector<int> values;
+
+    {
+        source_type source(pool);
+        std::promise<void> gate;
+        auto gateFuture = gate.get_future().share();
+        auto cookie = source.add([&, gateFuture](int value)
+        {
+            gateFuture.wait();
+            values.push_back(value);
+        });
+
+        auto first = source.invoke_all_for_completion(1);
+        auto second = source.invoke_all_for_completion(2);
+
+        // Removing discards anything that hasn't been delivered yet
+        source.remove(cookie);
+        ASSERT_TRUE(source.empty());
+
+        ASSERT_THROW(source.remove(cookie), std::out_of_range);
+
+        gate.set_value();
+        first.get();
+        second.get();
+    }
+
+    ASSERT_TRUE(values.size() <= 1);
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, ConstReferenceArgsTest)
+{
+    dhorn::thread_pool pool;
+    std::string result;
+
+    {
+        // Subscribers get a const reference to the copy held by the event
+        dhorn::experimental::async_event_source<void(const std::string &, int)> source(pool);
+        source.add([&](const std::string &str, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                result += str;
+            }
+        });
+
+        std::string str = "foo";
+        auto future = source.invoke_all_for_completion(str, 2);
+        str = "bar";
+        future.get();
+    }
+
+    ASSERT_EQ("foofoo", result);
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, ZeroMaxPendingTest)
+{
+    dhorn::thread_pool pool;
+
+    {
+        // A subscriber that can never have any events waiting would silently drop everything
+        source_type source(pool);
+        for (auto policy : {
+            dhorn::experimental::async_event_policy::bounded_queue,
+            dhorn::experimental::async_event_policy::latest_wins,
+            dhorn::experimental::async_event_policy::drop })
+        {
+            ASSERT_THROW(source.add([](int) {}, policy, 0), std::invalid_argument);
+        }
+
+        ASSERT_TRUE(source.empty());
+    }
+
+    pool.join();
+}
+
+TEST(AsyncEventSourceTests, SubmitFailureTest)
+{
+    dhorn::thread_pool pool;
+    std::atomic_int x{ 0 };
+    std::vector<int> values;
+
+    source_type source(pool);
+    std::promise<void> idle;
+    source.add([&](int value)
+    {
+        x += value;
+        if (value == 1)
+        {
+            idle.set_value();
+        }
+    });
+    auto gate = AddBlockingSubscriber(source, values, dhorn::experimental::async_event_policy::bounded_queue);
+
+    // Once the first subscriber is idle, it needs the thread pool to deliver any more events, whereas the second is
+    // still blocked on the first event, so later events are delivered by the task that's already running
+    auto first = source.invoke_all_for_completion(1);
+    idle.get_future().get();
+
+    // The first subscriber's task still has to notice that there's nothing left for it to do before it goes idle
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Running tasks are allowed to complete after detaching, but submitting any new ones will fail
+    pool.detach();
+    auto second = source.invoke_all_for_completion(2);
+    auto third = source.invoke_all_for_completion(3);
+
+    gate.set_value();
+    first.get();
+    ASSERT_THROW(second.get(), std::invalid_argument);
+    ASSERT_THROW(third.get(), std::invalid_argument);
+
+    // The first subscriber could never get the later events, but the failure must not have kept them from the second
+    ASSERT_EQ(1, x.load());
+    ASSERT_EQ((std::vector<int>{ 1, 2, 3 }), values);
+}
+
+TEST(AsyncEventSourceTests, ShutDownThreadPoolTest)
+{
+    dhorn::thread_pool pool;
+    pool.join();
+
+    source_type source(pool);
+    source.add([](int) {});
+    source.add([](int) {});
+
+    // Raising the event itself shouldn't throw; the failure gets reported through the future instead
+    source.invoke_all(1);
+    auto future = source.invoke_all_for_completion(2);
+    ASSERT_THROW(future.get(), std::invalid_argument);
+}
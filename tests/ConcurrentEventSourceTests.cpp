@@ -0,0 +1,285 @@
+/*
+ * Duncan Horn
+ *
+ * ConcurrentEventSourceTests.cpp
+ *
+ * Tests for the dhorn concurrent_event_source class
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <dhorn/experimental/event_source.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentEventSourceTests, SingleEventTest)
+{
+    int x = 0;
+    dhorn::experimental::concurrent_event_source<void(void)> source;
+
+    auto cookie = source.add([&]() { ++x; });
+    ASSERT_NE(dhorn::experimental::invalid_event_cookie, cookie);
+    ASSERT_EQ(static_cast<std::size_t>(1), source.size());
+
+    source.invoke_all();
+    ASSERT_EQ(1, x);
+}
+
+TEST(ConcurrentEventSourceTests, RemoveTest)
+{
+    int x = 0;
+    dhorn::experimental::concurrent_event_source<void(void)> source;
+
+    auto cookie = source.add([&]() { ++x; });
+    auto cookie2 = source.add([&]() { x += 2; });
+    source.remove(cookie);
+    ASSERT_EQ(static_cast<std::size_t>(1), source.size());
+
+    // Should throw if we try and remove again
+    ASSERT_THROW(source.remove(cookie), std::out_of_range);
+
+    source.invoke_all();
+    ASSERT_EQ(2, x);
+
+    source.remove(cookie2);
+    ASSERT_TRUE(source.empty());
+}
+
+TEST(ConcurrentEventSourceTests, MultipleEventInvokeTest)
+{
+    int x = 0;
+    dhorn::experimental::concurrent_event_source<int(void)> source;
+
+    source.add([&]() -> int { ++x; return x; });
+    source.add([&]() -> int { x += 2; return x; });
+
+    source.invoke_one([&](int val) { ASSERT_EQ(1, val); }); // Invokes first added
+    ASSERT_EQ(1, x);
+
+    source.invoke_all([&](int val) { ASSERT_EQ(x, val); });
+    ASSERT_EQ(4, x);
+}
+
+TEST(ConcurrentEventSourceTests, ReclamationTest)
+{
+    dhorn::experimental::concurrent_event_source<void(void)> source;
+    auto ptr = std::make_shared<int>(42);
+
+    auto cookie = source.add([ptr]() {});
+    ASSERT_TRUE(ptr.use_count() == 2);
+
+    // With no readers around, the old snapshot should get cleaned up right away
+    source.remove(cookie);
+    ASSERT_TRUE(ptr.use_count() == 1);
+}
+
+TEST(ConcurrentEventSourceTests, ModifyFromCallbackTest)
+{
+    int x = 0;
+    dhorn::experimental::concurrent_event_source<void(void)> source;
+    auto ptr = std::make_shared<int>(42);
+
+    dhorn::experimental::event_cookie cookie = source.add([&, ptr]()
+    {
+        // Removing ourselves while we are still executing should be safe
+        source.remove(cookie);
+        ASSERT_TRUE(ptr.use_count() >= 2);
+
+        source.add([&]() { x += 2; });
+        ++x;
+    });
+
+    // Changes aren't visible until the next invocation
+    source.invoke_all();
+    ASSERT_EQ(1, x);
+    ASSERT_EQ(static_cast<std::size_t>(1), source.size());
+
+    source.invoke_all();
+    ASSERT_EQ(3, x);
+}
+
+TEST(ConcurrentEventSourceTests, ConcurrentInvokeAndModifyTest)
+{
+    const int readerCount = 8;
+    const int invokeCount = 2000;
+    const int modifyCount = 500;
+    dhorn::experimental::concurrent_event_source<void(int)> source;
+    std::atomic_int permanentCount{ 0 };
+    std::atomic_int transientCount{ 0 };
+
+    source.add([&](int value)
+    {
+        ASSERT_EQ(42, value);
+        ++permanentCount;
+    });
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < readerCount; ++i)
+    {
+        readers.emplace_back([&]()
+        {
+            for (int j = 0; j < invokeCount; ++j)
+            {
+                source.invoke_all(42);
+            }
+        });
+    }
+
+    auto ptr = std::make_shared<int>(0);
+    for (int i = 0; i < modifyCount; ++i)
+    {
+        auto cookie = source.add([&, ptr](int value)
+        {
+            ASSERT_EQ(42, value);
+            ++transientCount;
+        });
+        source.remove(cookie);
+    }
+
+    for (auto &thread : readers)
+    {
+        thread.join();
+    }
+
+    // Every invocation should have seen the permanent callback
+    ASSERT_EQ(readerCount * invokeCount, permanentCount.load());
+    ASSERT_EQ(static_cast<std::size_t>(1), source.size());
+
+    // No readers are left, so the next modification should reclaim everything
+    source.remove(source.add([](int) {}));
+    ASSERT_TRUE(ptr.use_count() == 1);
+}
+
+// Callbacks capture a value that poisons itself on destruction, so invoking a callback whose snapshot has already been
+// reclaimed sees the wrong magic number. Running under AddressSanitizer turns that into a use-after-free report
+struct tracked_capture
+{
+    static constexpr std::uint32_t alive_magic = 0xA11FEu;
+    static constexpr std::uint32_t dead_magic = 0xDEADu;
+    static inline std::atomic_size_t instance_count{ 0 };
+
+    explicit tracked_capture(std::size_t id) :
+        id(id)
+    {
+        ++instance_count;
+    }
+
+    tracked_capture(const tracked_capture &other) :
+        id(other.id)
+    {
+        ++instance_count;
+    }
+
+    ~tracked_capture()
+    {
+        this->magic.store(dead_magic);
+        --instance_count;
+    }
+
+    std::atomic_uint32_t magic{ alive_magic };
+    std::size_t id;
+};
+
+TEST(ConcurrentEventSourceTests, AddRemoveDuringInvokeStressTest)
+{
+    static const std::size_t num_writers = 4;
+    static const std::size_t num_readers = 8;
+    static const std::size_t num_iterations = 1000;
+    static const std::size_t permanent_count = 4;
+
+    {
+        dhorn::experimental::concurrent_event_source<void(std::size_t)> source;
+        std::atomic_size_t runningWriters{ num_writers };
+        std::atomic_size_t failures{ 0 };
+        std::atomic_size_t permanentInvokeCount{ 0 };
+        std::vector<std::thread> threads;
+
+        auto makeCallback = [&](std::size_t id, bool permanent)
+        {
+            return [&, permanent, capture = tracked_capture(id)](std::size_t value)
+            {
+                if ((capture.magic.load() != tracked_capture::alive_magic) || (value != 42))
+                {
+                    ++failures;
+                }
+                else if (permanent)
+                {
+                    ++permanentInvokeCount;
+                }
+            };
+        };
+
+        for (std::size_t i = 0; i < permanent_count; ++i)
+        {
+            source.add(makeCallback(i, true));
+        }
+
+        for (std::size_t i = 0; i < num_writers; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                std::vector<dhorn::experimental::event_cookie> cookies;
+                for (std::size_t j = 0; j < num_iterations; ++j)
+                {
+                    cookies.push_back(source.add(makeCallback(i * num_iterations + j, false)));
+
+                    // Keep a handful of callbacks around, removing them from both ends so that removals hit the
+                    // front, back, and middle of the published array
+                    if (cookies.size() > 4)
+                    {
+                        auto itr = (j % 2) ? cookies.begin() : cookies.end() - 1;
+                        source.remove(*itr);
+                        cookies.erase(itr);
+                    }
+                }
+
+                for (auto cookie : cookies)
+                {
+                    source.remove(cookie);
+                }
+
+                --runningWriters;
+            });
+        }
+
+        std::atomic_size_t invokeCount{ 0 };
+        for (std::size_t i = 0; i < num_readers; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                for (std::size_t j = 0; runningWriters.load() > 0; ++j)
+                {
+                    if (((i + j) % 8) == 0)
+                    {
+                        source.invoke_one(42);
+                    }
+                    else
+                    {
+                        source.invoke_all(42);
+                        ++invokeCount;
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        ASSERT_EQ(0u, failures.load());
+        ASSERT_EQ(permanent_count, source.size());
+
+        // invoke_one always hits the first permanent callback; invoke_all hits all of them
+        ASSERT_LE(invokeCount.load() * permanent_count, permanentInvokeCount.load());
+
+        // With no readers left, the next modification should reclaim all of the old snapshots
+        source.remove(source.add([](std::size_t) {}));
+        ASSERT_EQ(permanent_count, tracked_capture::instance_count.load());
+    }
+
+    ASSERT_EQ(0u, tracked_capture::instance_count.load());
+}
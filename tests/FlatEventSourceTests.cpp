@@ -0,0 +1,121 @@
+/*
+ * Duncan Horn
+ *
+ * FlatEventSourceTests.cpp
+ *
+ * Tests for the dhorn flat_event_source class
+ */
+
+#include <dhorn/experimental/event_source.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+TEST(FlatEventSourceTests, SingleEventTest)
+{
+    int x = 0;
+    dhorn::experimental::flat_event_source<void(void)> source;
+
+    auto cookie = source.add([&]() { ++x; });
+    ASSERT_NE(dhorn::experimental::invalid_event_cookie, cookie);
+    ASSERT_EQ(static_cast<std::size_t>(1), source.size());
+
+    source.invoke_all();
+    ASSERT_EQ(1, x);
+}
+
+TEST(FlatEventSourceTests, RemoveTest)
+{
+    int x = 0;
+    dhorn::experimental::flat_event_source<void(void)> source;
+
+    auto cookie = source.add([&]() { ++x; });
+    source.remove(cookie);
+    ASSERT_EQ(static_cast<std::size_t>(0), source.size());
+
+    // Should throw if we try and remove again
+    ASSERT_THROW(source.remove(cookie), std::out_of_range);
+}
+
+TEST(FlatEventSourceTests, RemoveMiddleTest)
+{
+    int x = -1;
+    dhorn::experimental::flat_event_source<void(int)> source;
+
+    std::vector<dhorn::experimental::event_cookie> cookies;
+    for (int i = 0; i < 10; ++i)
+    {
+        cookies.push_back(source.add([&x, i](int val)
+        {
+            // Callbacks should be invoked in the order they were added
+            ASSERT_TRUE(x < i);
+            x = i + val;
+        }));
+    }
+
+    for (std::size_t i = 1; i < cookies.size(); i += 2)
+    {
+        source.remove(cookies[i]);
+    }
+    ASSERT_EQ(static_cast<std::size_t>(5), source.size());
+
+    // Removing cookies that don't exist (anymore or yet) should throw
+    for (auto cookie : { cookies[3], cookies.back() + 1 })
+    {
+        ASSERT_THROW(source.remove(cookie), std::out_of_range);
+    }
+
+    source.invoke_all(0);
+    ASSERT_EQ(8, x);
+
+    // New cookies should never collide with previously removed ones
+    auto cookie = source.add([](int) {});
+    ASSERT_TRUE(cookie > cookies.back());
+}
+
+TEST(FlatEventSourceTests, MultipleEventInvokeOneTest)
+{
+    int x = 0;
+    dhorn::experimental::flat_event_source<int(void)> source;
+
+    source.add([&]() -> int { ++x; return x; });
+    source.add([&]() -> int { x += 2; return x; });
+
+    source.invoke_one([&](int val) { ASSERT_EQ(1, val); }); // Invokes first added
+    ASSERT_EQ(1, x);
+}
+
+TEST(FlatEventSourceTests, MultipleEventInvokeAllTest)
+{
+    int x = 0;
+    dhorn::experimental::flat_event_source<int(void)> source;
+
+    auto cookie = source.add([&]() -> int { ++x; return x; });
+    source.add([&]() -> int { x += 2; return x; });
+
+    source.invoke_all([&](int val) { ASSERT_EQ(x, val); });
+    ASSERT_EQ(3, x);
+
+    source.remove(cookie);
+    source.invoke_all();
+    ASSERT_EQ(5, x);
+}
+
+TEST(FlatEventSourceTests, ManySubscribersTest)
+{
+    const int subscriberCount = 500;
+    int x = 0;
+    dhorn::experimental::flat_event_source<void(int, int)> source;
+    source.reserve(subscriberCount);
+
+    for (int i = 0; i < subscriberCount; ++i)
+    {
+        source.add([&](int a, int b)
+        {
+            x += a + b;
+        });
+    }
+
+    source.invoke_all(1, 2);
+    ASSERT_EQ(3 * subscriberCount, x);
+}
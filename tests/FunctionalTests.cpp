@@ -6,10 +6,12 @@
  * Tests for the functional.h header file
  */
 
+#include <cstring>
 #include <dhorn/functional.h>
 #include <dhorn/utility.h>
 #include <functional>
 #include <gtest/gtest.h>
+#include <memory>
 #include <string>
 
 #include "object_counter.h"
@@ -63,3 +65,82 @@ TEST_F(FunctionalTests, MakeLambdaSharedCopyableTest)
     // This is strictly a "does it compile" test
     std::function<void(void)> fn = lambda;
 }
+
+
+
+static int function_ref_add(int lhs, int rhs)
+{
+    return lhs + rhs;
+}
+
+static int function_ref_invoke(dhorn::function_ref<int(int, int)> func, int lhs, int rhs)
+{
+    return func(lhs, rhs);
+}
+
+TEST_F(FunctionalTests, FunctionRefSizeTest)
+{
+    ASSERT_EQ(2 * sizeof(void*), sizeof(dhorn::function_ref<void()>));
+    ASSERT_TRUE(std::is_trivially_copyable_v<dhorn::function_ref<void()>>);
+}
+
+TEST_F(FunctionalTests, FunctionRefLambdaTest)
+{
+    ASSERT_EQ(3, function_ref_invoke([](int lhs, int rhs) { return lhs + rhs; }, 1, 2));
+
+    int value = 0;
+    auto lambda = [&](int lhs, int rhs) { value = lhs * rhs; return value; };
+    dhorn::function_ref<int(int, int)> func = lambda;
+    ASSERT_EQ(6, func(2, 3));
+    ASSERT_EQ(6, value);
+}
+
+TEST_F(FunctionalTests, FunctionRefFunctionPointerTest)
+{
+    ASSERT_EQ(3, function_ref_invoke(function_ref_add, 1, 2));
+    ASSERT_EQ(3, function_ref_invoke(&function_ref_add, 1, 2));
+
+    dhorn::function_ref<std::size_t(const char*)> func = std::strlen;
+    ASSERT_EQ(3_sz, func("foo"));
+}
+
+TEST_F(FunctionalTests, FunctionRefReferenceSemanticsTest)
+{
+    // Mutating the referenced object should be visible through the function_ref, and no copies should be made
+    auto lambda = [obj = dhorn::tests::object_counter{}, count = 0]() mutable { return ++count; };
+    auto copyCount = dhorn::tests::object_counter::copy_count;
+    auto moveCount = dhorn::tests::object_counter::move_count;
+
+    dhorn::function_ref<int()> func = lambda;
+    auto funcCopy = func;
+    ASSERT_EQ(1, func());
+    ASSERT_EQ(2, funcCopy());
+    ASSERT_EQ(3, lambda());
+
+    ASSERT_EQ(copyCount, dhorn::tests::object_counter::copy_count);
+    ASSERT_EQ(moveCount, dhorn::tests::object_counter::move_count);
+}
+
+TEST_F(FunctionalTests, FunctionRefMemberFunctionTest)
+{
+    auto sizeFn = &std::string::size;
+    dhorn::function_ref<std::size_t(const std::string&)> func = sizeFn;
+    ASSERT_EQ(3_sz, func("foo"s));
+}
+
+TEST_F(FunctionalTests, FunctionRefDiscardResultTest)
+{
+    int value = 0;
+    auto lambda = [&]() { return ++value; };
+
+    dhorn::function_ref<void()> func = lambda;
+    func();
+    ASSERT_EQ(1, value);
+}
+
+TEST_F(FunctionalTests, FunctionRefMoveOnlyArgumentTest)
+{
+    auto lambda = [](std::unique_ptr<int> ptr) { return *ptr; };
+    dhorn::function_ref<int(std::unique_ptr<int>)> func = lambda;
+    ASSERT_EQ(42, func(std::make_unique<int>(42)));
+}
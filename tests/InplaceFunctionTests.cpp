@@ -3,11 +3,14 @@
  *
  * InplaceFunctionTests.cpp
  *
- * Tests for the dhorn::experimental::inplace_function type
+ * Tests for the dhorn::inplace_function, dhorn::inplace_unique_function, and dhorn::hybrid_function types
  */
 
 #include <dhorn/inplace_function.h>
+#include <future>
 #include <gtest/gtest.h>
+#include <memory>
+#include <vector>
 
 #include "object_counter.h"
 
@@ -517,6 +520,33 @@ TEST_F(InplaceFunctionTests, TargetTest)
     ASSERT_EQ(-42, (*fn.target<other_lambda_type>())());
 }
 
+TEST_F(InplaceFunctionTests, TriviallyCopyableTest)
+{
+    auto lambda = [a = 1, b = 2, c = 3]() { return a + b + c; };
+    static_assert(std::is_trivially_copyable_v<decltype(lambda)>);
+
+    dhorn::inplace_function<int(), 32> fn(lambda);
+    dhorn::inplace_function<int(), 32> fn_copy(fn);
+    ASSERT_EQ(6, fn());
+    ASSERT_EQ(6, fn_copy());
+
+    dhorn::inplace_function<int(), 64> fn_move(std::move(fn_copy));
+    ASSERT_FALSE(static_cast<bool>(fn_copy));
+    ASSERT_EQ(6, fn_move());
+    ASSERT_TRUE(fn_move.target<decltype(lambda)>() != nullptr);
+
+    std::vector<dhorn::inplace_function<int(), 32>> funcs;
+    for (int i = 0; i < 100; ++i)
+    {
+        funcs.emplace_back([i]() { return i; });
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_EQ(i, funcs[i]());
+    }
+}
+
 TEST_F(InplaceFunctionTests, NullEqualityTest)
 {
     dhorn::inplace_function<void()> fn;
@@ -531,3 +561,322 @@ TEST_F(InplaceFunctionTests, NullEqualityTest)
     ASSERT_TRUE(fn != nullptr);
     ASSERT_TRUE(nullptr != fn);
 }
+
+
+
+struct InplaceUniqueFunctionTests : InplaceFunctionTests
+{
+};
+
+TEST_F(InplaceUniqueFunctionTests, TypeTraitsTest)
+{
+    auto moveOnlyLambda = [ptr = std::make_unique<int>(42)]() { return *ptr; };
+    using move_only_type = decltype(moveOnlyLambda);
+
+    ASSERT_FALSE(std::is_copy_constructible_v<dhorn::inplace_unique_function<int()>>);
+    ASSERT_FALSE(std::is_copy_assignable_v<dhorn::inplace_unique_function<int()>>);
+    ASSERT_TRUE(std::is_move_constructible_v<dhorn::inplace_unique_function<int()>>);
+    ASSERT_TRUE(std::is_move_assignable_v<dhorn::inplace_unique_function<int()>>);
+
+    ASSERT_TRUE((std::is_constructible_v<dhorn::inplace_unique_function<int()>, move_only_type>));
+    ASSERT_FALSE((std::is_constructible_v<dhorn::inplace_function<int()>, move_only_type>));
+
+    // Can go from copyable to move-only, but not the other way around
+    ASSERT_TRUE((std::is_constructible_v<dhorn::inplace_unique_function<int()>, dhorn::inplace_function<int()>>));
+    ASSERT_TRUE((std::is_constructible_v<
+        dhorn::inplace_unique_function<int()>,
+        const dhorn::inplace_function<int()>&>));
+    ASSERT_FALSE((std::is_constructible_v<dhorn::inplace_function<int()>, dhorn::inplace_unique_function<int()>>));
+}
+
+TEST_F(InplaceUniqueFunctionTests, MoveOnlyLambdaTest)
+{
+    dhorn::inplace_unique_function<int()> fn([ptr = std::make_unique<int>(42)]() { return *ptr; });
+    ASSERT_TRUE(static_cast<bool>(fn));
+    ASSERT_EQ(42, fn());
+
+    dhorn::inplace_unique_function<void()> nullFn;
+    ASSERT_FALSE(static_cast<bool>(nullFn));
+    ASSERT_THROW(nullFn(), std::bad_function_call);
+}
+
+TEST_F(InplaceUniqueFunctionTests, PromiseTest)
+{
+    std::promise<int> promise;
+    auto future = promise.get_future();
+
+    dhorn::inplace_unique_function<void(int)> fn([promise = std::move(promise)](int value) mutable
+    {
+        promise.set_value(value);
+    });
+
+    fn(42);
+    ASSERT_EQ(42, future.get());
+}
+
+TEST_F(InplaceUniqueFunctionTests, MoveTest)
+{
+    {
+        dhorn::inplace_unique_function<int()> fn([o = dhorn::tests::object_counter{}]() { return 42; });
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::instance_count);
+
+        dhorn::inplace_unique_function<int()> fn_move(std::move(fn));
+        ASSERT_FALSE(static_cast<bool>(fn));
+        ASSERT_EQ(42, fn_move());
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::instance_count);
+
+        dhorn::inplace_unique_function<int(), 128> fn_large(std::move(fn_move));
+        ASSERT_FALSE(static_cast<bool>(fn_move));
+        ASSERT_EQ(42, fn_large());
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::instance_count);
+
+        dhorn::inplace_unique_function<int(), 128> fn_assign;
+        fn_assign = std::move(fn_large);
+        ASSERT_FALSE(static_cast<bool>(fn_large));
+        ASSERT_EQ(42, fn_assign());
+
+        fn_assign = nullptr;
+        ASSERT_EQ(static_cast<std::size_t>(0), dhorn::tests::object_counter::instance_count);
+    }
+
+    ASSERT_EQ(static_cast<std::size_t>(0), dhorn::tests::object_counter::copy_count);
+    ASSERT_EQ(dhorn::tests::object_counter::constructed_count, dhorn::tests::object_counter::destructed_count);
+}
+
+TEST_F(InplaceUniqueFunctionTests, ConvertFromInplaceFunctionTest)
+{
+    {
+        dhorn::inplace_function<int()> fn([o = dhorn::tests::object_counter{}]() { return 42; });
+
+        dhorn::inplace_unique_function<int()> fn_copy(fn);
+        ASSERT_TRUE(static_cast<bool>(fn));
+        ASSERT_EQ(42, fn_copy());
+        ASSERT_EQ(static_cast<std::size_t>(2), dhorn::tests::object_counter::instance_count);
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::copy_count);
+
+        dhorn::inplace_unique_function<int()> fn_move(std::move(fn));
+        ASSERT_FALSE(static_cast<bool>(fn));
+        ASSERT_EQ(42, fn_move());
+        ASSERT_EQ(static_cast<std::size_t>(2), dhorn::tests::object_counter::instance_count);
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::copy_count);
+    }
+
+    ASSERT_EQ(dhorn::tests::object_counter::constructed_count, dhorn::tests::object_counter::destructed_count);
+}
+
+TEST_F(InplaceUniqueFunctionTests, SwapTest)
+{
+    dhorn::inplace_unique_function<int()> fn1([ptr = std::make_unique<int>(42)]() { return *ptr; });
+    dhorn::inplace_unique_function<int()> fn2([ptr = std::make_unique<int>(8)]() { return *ptr; });
+
+    swap(fn1, fn2);
+    ASSERT_EQ(8, fn1());
+    ASSERT_EQ(42, fn2());
+
+    fn2 = nullptr;
+    fn1.swap(fn2);
+    ASSERT_FALSE(static_cast<bool>(fn1));
+    ASSERT_EQ(8, fn2());
+}
+
+TEST_F(InplaceUniqueFunctionTests, TargetTest)
+{
+    auto lambda = [ptr = std::make_unique<int>(42)]() { return *ptr; };
+    using lambda_type = decltype(lambda);
+
+    dhorn::inplace_unique_function<int()> fn(std::move(lambda));
+    ASSERT_TRUE(typeid(lambda_type) == fn.target_type());
+    ASSERT_TRUE(fn.target<lambda_type>() != nullptr);
+    ASSERT_EQ(42, (*fn.target<lambda_type>())());
+}
+
+
+
+struct counting_storage_policy
+{
+    static constexpr bool allows_allocation = true;
+
+    static inline std::size_t allocation_count = 0;
+    static inline std::size_t deallocation_count = 0;
+
+    static void* allocate(std::size_t size, std::size_t alignment)
+    {
+        ++allocation_count;
+        return dhorn::heap_fallback_storage_policy::allocate(size, alignment);
+    }
+
+    static void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept
+    {
+        ++deallocation_count;
+        dhorn::heap_fallback_storage_policy::deallocate(ptr, size, alignment);
+    }
+};
+
+struct HybridFunctionTests : InplaceFunctionTests
+{
+    virtual void SetUp() override
+    {
+        InplaceFunctionTests::SetUp();
+        counting_storage_policy::allocation_count = 0;
+        counting_storage_policy::deallocation_count = 0;
+    }
+
+    virtual void TearDown() override
+    {
+        ASSERT_EQ(counting_storage_policy::allocation_count, counting_storage_policy::deallocation_count);
+        InplaceFunctionTests::TearDown();
+    }
+
+    template <typename Func, std::size_t Size = 32>
+    using counting_function = dhorn::hybrid_function<Func, Size, counting_storage_policy>;
+
+    template <typename Func, std::size_t Size = 32>
+    using counting_unique_function = dhorn::hybrid_unique_function<Func, Size, counting_storage_policy>;
+};
+
+TEST_F(HybridFunctionTests, SmallObjectTest)
+{
+    int value = 42;
+    counting_function<int()> fn([&]() { return value; });
+    ASSERT_FALSE(fn.is_allocated());
+    ASSERT_EQ(42, fn());
+    ASSERT_EQ(static_cast<std::size_t>(0), counting_storage_policy::allocation_count);
+
+    counting_function<int()> nullFn;
+    ASSERT_FALSE(nullFn.is_allocated());
+    ASSERT_THROW(nullFn(), std::bad_function_call);
+}
+
+TEST_F(HybridFunctionTests, LargeObjectTest)
+{
+    {
+        std::uint8_t data[64] = { 42 };
+        counting_function<int()> fn([data, o = dhorn::tests::object_counter{}]() { return data[0]; });
+        ASSERT_TRUE(fn.is_allocated());
+        ASSERT_EQ(42, fn());
+        ASSERT_EQ(static_cast<std::size_t>(1), counting_storage_policy::allocation_count);
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::instance_count);
+
+        fn = [&]() { return data[1]; };
+        ASSERT_FALSE(fn.is_allocated());
+        ASSERT_EQ(0, fn());
+        ASSERT_EQ(static_cast<std::size_t>(1), counting_storage_policy::deallocation_count);
+        ASSERT_EQ(static_cast<std::size_t>(0), dhorn::tests::object_counter::instance_count);
+    }
+
+    // The default heap storage policy should behave the same way
+    std::uint8_t data[64] = { 42 };
+    dhorn::hybrid_function<int(), 32> fn([data]() { return data[0]; });
+    ASSERT_TRUE(fn.is_allocated());
+    ASSERT_EQ(42, fn());
+}
+
+TEST_F(HybridFunctionTests, OverAlignedObjectTest)
+{
+    struct alignas(64) aligned_object
+    {
+        int value = 42;
+        int operator()() const { return value; }
+    };
+
+    counting_function<int(), 128> fn(aligned_object{});
+    ASSERT_TRUE(fn.is_allocated());
+    ASSERT_EQ(static_cast<std::uintptr_t>(0), reinterpret_cast<std::uintptr_t>(fn.target<aligned_object>()) % 64);
+    ASSERT_EQ(42, fn());
+}
+
+TEST_F(HybridFunctionTests, CopyTest)
+{
+    {
+        std::uint8_t data[64] = { 42 };
+        auto lambda = [data, o = dhorn::tests::object_counter{}]() { return data[0]; };
+        using lambda_type = decltype(lambda);
+
+        counting_function<int()> fn(std::move(lambda));
+        counting_function<int()> fn_copy(fn);
+        ASSERT_TRUE(fn_copy.is_allocated());
+        ASSERT_EQ(42, fn());
+        ASSERT_EQ(42, fn_copy());
+        ASSERT_EQ(static_cast<std::size_t>(2), counting_storage_policy::allocation_count);
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::copy_count);
+
+        // Each copy should own its own allocation
+        ASSERT_NE(fn.target<lambda_type>(), fn_copy.target<lambda_type>());
+    }
+
+    ASSERT_EQ(dhorn::tests::object_counter::constructed_count, dhorn::tests::object_counter::destructed_count);
+}
+
+TEST_F(HybridFunctionTests, MoveTest)
+{
+    {
+        std::uint8_t data[64] = { 42 };
+        counting_unique_function<int()> fn([data, ptr = std::make_unique<dhorn::tests::object_counter>()]()
+        {
+            return data[0];
+        });
+        ASSERT_TRUE(fn.is_allocated());
+
+        // Moving should only transfer ownership of the allocation
+        counting_unique_function<int()> fn_move(std::move(fn));
+        ASSERT_FALSE(static_cast<bool>(fn));
+        ASSERT_TRUE(fn_move.is_allocated());
+        ASSERT_EQ(42, fn_move());
+
+        counting_unique_function<int(), 64> fn_large;
+        fn_large = std::move(fn_move);
+        ASSERT_FALSE(static_cast<bool>(fn_move));
+        ASSERT_EQ(42, fn_large());
+
+        ASSERT_EQ(static_cast<std::size_t>(1), counting_storage_policy::allocation_count);
+        ASSERT_EQ(static_cast<std::size_t>(0), counting_storage_policy::deallocation_count);
+        ASSERT_EQ(static_cast<std::size_t>(1), dhorn::tests::object_counter::instance_count);
+    }
+
+    ASSERT_EQ(static_cast<std::size_t>(0), dhorn::tests::object_counter::copy_count);
+    ASSERT_EQ(static_cast<std::size_t>(0), dhorn::tests::object_counter::move_count);
+}
+
+TEST_F(HybridFunctionTests, SwapTest)
+{
+    std::uint8_t data[64] = { 42 };
+    counting_function<int()> fn1([data]() { return data[0]; });
+    counting_function<int()> fn2([]() { return 8; });
+
+    swap(fn1, fn2);
+    ASSERT_FALSE(fn1.is_allocated());
+    ASSERT_TRUE(fn2.is_allocated());
+    ASSERT_EQ(8, fn1());
+    ASSERT_EQ(42, fn2());
+    ASSERT_EQ(static_cast<std::size_t>(1), counting_storage_policy::allocation_count);
+}
+
+TEST_F(HybridFunctionTests, ConversionTest)
+{
+    // Can convert from functions that never allocate, but not to them or between different storage policies
+    ASSERT_TRUE((std::is_constructible_v<counting_function<int()>, dhorn::inplace_function<int(), 32>>));
+    ASSERT_FALSE((std::is_constructible_v<dhorn::inplace_function<int(), 32>, counting_function<int()>>));
+    ASSERT_FALSE((std::is_constructible_v<dhorn::hybrid_function<int(), 32>, counting_function<int()>>));
+
+    int value = 42;
+    dhorn::inplace_function<int(), 32> fn([&]() { return value; });
+    counting_function<int()> fn_copy(fn);
+    ASSERT_FALSE(fn_copy.is_allocated());
+    ASSERT_EQ(42, fn_copy());
+}
+
+TEST_F(HybridFunctionTests, ThrowingConstructorTest)
+{
+    struct throwing_object
+    {
+        std::uint8_t data[64] = {};
+
+        throwing_object() = default;
+        throwing_object(const throwing_object&) { throw std::runtime_error("Expected"); }
+
+        void operator()() const {}
+    };
+
+    ASSERT_THROW(counting_function<void()> fn(throwing_object{}), std::runtime_error);
+    ASSERT_EQ(static_cast<std::size_t>(1), counting_storage_policy::allocation_count);
+}
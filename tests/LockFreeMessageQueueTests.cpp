@@ -0,0 +1,238 @@
+/*
+ * Duncan Horn
+ *
+ * LockFreeMessageQueueTests.cpp
+ *
+ * Tests for lock_free_message_queue<void(void)>
+ */
+
+#include <atomic>
+#include <chrono>
+#include <dhorn/experimental/message_queue.h>
+#include <functional>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(LockFreeMessageQueueTests, CapacityTest)
+{
+    ASSERT_TRUE(dhorn::experimental::lock_free_message_queue<void(void)>(0).capacity() == 2);
+    ASSERT_TRUE(dhorn::experimental::lock_free_message_queue<void(void)>(8).capacity() == 8);
+    ASSERT_TRUE(dhorn::experimental::lock_free_message_queue<void(void)>(9).capacity() == 16);
+}
+
+TEST(LockFreeMessageQueueTests, SingleThreadTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::lock_free_message_queue<int(int, int)> msgQueue(testCount);
+    int x = 0;
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&](int a, int b) -> int
+        {
+            ++x;
+            return a + b;
+        });
+    }
+
+    ASSERT_TRUE(x == 0);
+    ASSERT_TRUE(msgQueue.size() == testCount);
+
+    int localCount = 0;
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()(i, 1) == (i + 1));
+        ASSERT_TRUE(x == ++localCount);
+    }
+
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+TEST(LockFreeMessageQueueTests, TryPushBackTest)
+{
+    dhorn::experimental::lock_free_message_queue<void(void)> msgQueue(4);
+    int x = 0;
+
+    for (std::size_t i = 0; i < msgQueue.capacity(); ++i)
+    {
+        ASSERT_TRUE(msgQueue.try_push_back([&]() { ++x; }));
+    }
+
+    // Queue is full
+    ASSERT_FALSE(msgQueue.try_push_back([&]() { ++x; }));
+
+    msgQueue.pop_front()();
+    ASSERT_TRUE(x == 1);
+    ASSERT_TRUE(msgQueue.try_push_back([&]() { ++x; }));
+}
+
+TEST(LockFreeMessageQueueTests, TryPopFrontTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::lock_free_message_queue<void(void)> msgQueue(testCount);
+    int x = 0;
+
+    std::function<void(void)> func;
+    ASSERT_FALSE(msgQueue.try_pop_front(func));
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&]()
+        {
+            ++x;
+        });
+    }
+
+    while (msgQueue.try_pop_front(func))
+    {
+        func();
+    }
+
+    ASSERT_TRUE(x == testCount);
+}
+
+TEST(LockFreeMessageQueueTests, BlockingPushBackTest)
+{
+    // Use a tiny queue so that the producer is forced to block on the consumer
+    const std::size_t testCount = 1000;
+    dhorn::experimental::lock_free_message_queue<void(void)> msgQueue(2);
+    int x = 0;
+
+    std::thread producer([&]()
+    {
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            msgQueue.push_back([&]()
+            {
+                ++x;
+            });
+        }
+    });
+
+    int localCount = 0;
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.pop_front()();
+        ASSERT_TRUE(x == ++localCount);
+    }
+
+    producer.join();
+}
+
+TEST(LockFreeMessageQueueTests, MultipleProducersMultipleConsumersTest)
+{
+    const std::size_t testCount = 1000;
+    const std::size_t producerCount = 20;
+    const std::size_t consumerCount = 20;
+    dhorn::experimental::lock_free_message_queue<void(void)> msgQueue(64);
+    std::atomic_int counts[producerCount] = {};
+    std::atomic_int x{};
+
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < producerCount; ++i)
+    {
+        producers.emplace_back([i, testCount, &msgQueue, &counts, &x]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
+            {
+                msgQueue.push_back([&counts, &x, i]()
+                {
+                    ++counts[i];
+                    ++x;
+                });
+            }
+        });
+    }
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        consumers.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
+            {
+                msgQueue.pop_front()();
+            }
+        });
+    }
+
+    for (auto &thread : consumers)
+    {
+        thread.join();
+    }
+
+    int index = 0;
+    for (auto &thread : producers)
+    {
+        thread.join();
+        ASSERT_TRUE(static_cast<std::size_t>(counts[index++]) == testCount);
+    }
+
+    ASSERT_TRUE(x == (testCount * producerCount));
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+
+TEST(LockFreeMessageQueueTests, FullQueueStressTest)
+{
+    // A ring that's much smaller than the number of producers keeps the queue at capacity, so producers exhaust their
+    // spins and park in push_back. Consumers occasionally sleep so that producers stay parked long enough for a lost
+    // wakeup to hang the test. Every message must be delivered exactly once
+    const std::size_t testCount = 5000;
+    const std::size_t producerCount = 8;
+    const std::size_t consumerCount = 8;
+    static_assert((testCount * producerCount) % consumerCount == 0, "Must be divisible");
+    dhorn::experimental::lock_free_message_queue<void(void)> msgQueue(4);
+
+    auto delivered = std::make_unique<std::atomic_int[]>(testCount * producerCount);
+    std::atomic_size_t duplicates{};
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < producerCount; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
+            {
+                auto index = i * testCount + j;
+                msgQueue.push_back([&, index]()
+                {
+                    if (delivered[index].fetch_add(1) != 0)
+                    {
+                        ++duplicates;
+                    }
+                });
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (std::size_t j = 0; j < testCount * producerCount / consumerCount; ++j)
+            {
+                msgQueue.pop_front()();
+                if (((i + j) % 1024) == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(0u, duplicates.load());
+    for (std::size_t i = 0; i < testCount * producerCount; ++i)
+    {
+        ASSERT_EQ(1, delivered[i].load());
+    }
+
+    ASSERT_TRUE(msgQueue.empty());
+}
@@ -5,229 +5,612 @@
  *
  * Tests for message_queue<void(void)>
  */
-#include "stdafx.h"
 
 #include <atomic>
+#include <chrono>
+#include <dhorn/experimental/message_queue.h>
+#include <functional>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
 #include <numeric>
 #include <thread>
 #include <vector>
 
-#include <dhorn/experimental/message_queue.h>
+TEST(MessageQueueTests, SingleThreadTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<int(int, int)> msgQueue;
+    int x = 0;
+
+    // Insert data
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&](int a, int b) -> int
+        {
+            ++x;
+            return a + b;
+        });
+    }
 
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+    ASSERT_TRUE(x == 0);
 
-namespace dhorn
+    // Remove data
+    int localCount = 0;
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()(i, 1) == (i + 1));
+        ASSERT_TRUE(x == ++localCount);
+    }
+}
+
+TEST(MessageQueueTests, SingleProducerSingleConsumerTest)
 {
-    namespace tests
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    int x = 0;
+
+    std::thread producer([&]()
     {
-        TEST_CLASS(MessageQueueTests)
+        for (std::size_t i = 0; i < testCount; ++i)
         {
-            TEST_METHOD(SingleThreadTest)
+            msgQueue.push_back([&]()
             {
-                const std::size_t testCount = 100;
-                dhorn::experimental::message_queue<int(int, int)> msgQueue;
-                int x = 0;
+                ++x;
+            });
+        }
+    });
 
-                // Insert data
-                for (std::size_t i = 0; i < testCount; ++i)
-                {
-                    msgQueue.push_back([&](int a, int b) -> int
-                    {
-                        ++x;
-                        return a + b;
-                    });
-                }
-
-                ASSERT_TRUE(x == 0);
-
-                // Remove data
-                int localCount = 0;
-                for (int i = 0; i < testCount; ++i)
-                {
-                    ASSERT_TRUE(msgQueue.pop_front()(i, 1) == (i + 1));
-                    ASSERT_TRUE(x == ++localCount);
-                }
-            }
+    // The test thread is the consumer
+    int localCount = 0;
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.pop_front()();
+        ASSERT_TRUE(x == ++localCount);
+    }
 
-            TEST_METHOD(SingleProducerSingleConsumerTest)
-            {
-                const std::size_t testCount = 100;
-                dhorn::experimental::message_queue<void(void)> msgQueue;
-                int x = 0;
+    producer.join();
+}
 
-                std::thread producer([&]()
+TEST(MessageQueueTests, MultipleProducersSingleConsumerTest)
+{
+    const std::size_t testCount = 1000;
+    const std::size_t producerCount = 20;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    int counts[producerCount] = {};
+
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < producerCount; ++i)
+    {
+        producers.emplace_back([i, testCount, &msgQueue, &counts]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
+            {
+                msgQueue.push_back([&counts, i]()
                 {
-                    for (std::size_t i = 0; i < testCount; ++i)
-                    {
-                        msgQueue.push_back([&]()
-                        {
-                            ++x;
-                        });
-                    }
+                    ++counts[i];
                 });
+            }
+        });
+    }
 
-                // The test thread is the consumer
-                int localCount = 0;
-                for (std::size_t i = 0; i < testCount; ++i)
-                {
-                    msgQueue.pop_front()();
-                    ASSERT_TRUE(x == ++localCount);
-                }
+    int localCount = 0;
+    for (std::size_t i = 0; i < testCount * producerCount; ++i)
+    {
+        msgQueue.pop_front()();
 
-                producer.join();
-            }
+        int count = std::accumulate(std::begin(counts), std::end(counts), 0);
+        ASSERT_TRUE(count == ++localCount);
+    }
 
-            TEST_METHOD(MultipleProducersSingleConsumerTest)
+    int index = 0;
+    for (auto &thread : producers)
+    {
+        thread.join();
+        ASSERT_TRUE(counts[index++] == testCount);
+    }
+}
+
+TEST(MessageQueueTests, SingleProducerMultipleConsumersTest)
+{
+    const std::size_t testCount = 5000;
+    const std::size_t consumerCount = 20;
+    static_assert(testCount % consumerCount == 0, "Must be divisible");
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    std::atomic_int x{};
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        consumers.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < testCount / consumerCount; ++j)
             {
-                const std::size_t testCount = 1000;
-                const std::size_t producerCount = 20;
-                dhorn::experimental::message_queue<void(void)> msgQueue;
-                int counts[producerCount] = {};
+                msgQueue.pop_front()();
+            }
+        });
+    }
 
-                std::vector<std::thread> producers;
-                for (std::size_t i = 0; i < producerCount; ++i)
-                {
-                    producers.emplace_back([i, testCount, &msgQueue, &counts]()
-                    {
-                        for (std::size_t j = 0; j < testCount; ++j)
-                        {
-                            msgQueue.push_back([&counts, i]()
-                            {
-                                ++counts[i];
-                            });
-                        }
-                    });
-                }
-
-                int localCount = 0;
-                for (std::size_t i = 0; i < testCount * producerCount; ++i)
-                {
-                    msgQueue.pop_front()();
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&]()
+        {
+            ++x;
+        });
+    }
 
-                    int count = std::accumulate(std::begin(counts), std::end(counts), 0);
-                    ASSERT_TRUE(count == ++localCount);
-                }
+    for (auto &thread : consumers)
+    {
+        thread.join();
+    }
+    ASSERT_TRUE(static_cast<std::size_t>(x) == testCount);
+}
 
-                int index = 0;
-                for (auto &thread : producers)
-                {
-                    thread.join();
-                    ASSERT_TRUE(counts[index++] == testCount);
-                }
-            }
+TEST(MessageQueueTests, MultipleProducersMultipleConsumersTest)
+{
+    const std::size_t testCount = 1000;
+    const std::size_t producerCount = 20;
+    const std::size_t consumerCount = 20;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    std::atomic_int counts[producerCount] = {};
+    std::atomic_int x{};
 
-            TEST_METHOD(SingleProducerMultipleConsumersTest)
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < producerCount; ++i)
+    {
+        producers.emplace_back([i, testCount, &msgQueue, &counts, &x]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
             {
-                const std::size_t testCount = 5000;
-                const std::size_t consumerCount = 20;
-                static_assert(testCount % consumerCount == 0, "Must be divisible");
-                dhorn::experimental::message_queue<void(void)> msgQueue;
-                std::atomic_int x{};
-
-                std::vector<std::thread> consumers;
-                for (int i = 0; i < consumerCount; ++i)
-                {
-                    consumers.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < testCount / consumerCount; ++j)
-                        {
-                            msgQueue.pop_front()();
-                        }
-                    });
-                }
-
-                for (std::size_t i = 0; i < testCount; ++i)
-                {
-                    msgQueue.push_back([&]()
-                    {
-                        ++x;
-                    });
-                }
-
-                for (auto &thread : consumers)
+                msgQueue.push_back([&counts, &x, i]()
                 {
-                    thread.join();
-                }
-                ASSERT_TRUE(static_cast<std::size_t>(x) == testCount);
+                    ++counts[i];
+                    ++x;
+                });
             }
+        });
+    }
 
-            TEST_METHOD(MultipleProducersMultipleConsumersTest)
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        consumers.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < testCount; ++j)
             {
-                const std::size_t testCount = 1000;
-                const std::size_t producerCount = 20;
-                const std::size_t consumerCount = 20;
-                dhorn::experimental::message_queue<void(void)> msgQueue;
-                std::atomic_int counts[producerCount] = {};
-                std::atomic_int x{};
-
-                std::vector<std::thread> producers;
-                for (std::size_t i = 0; i < producerCount; ++i)
-                {
-                    producers.emplace_back([i, testCount, &msgQueue, &counts, &x]()
-                    {
-                        for (std::size_t j = 0; j < testCount; ++j)
-                        {
-                            msgQueue.push_back([&counts, &x, i]()
-                            {
-                                ++counts[i];
-                                ++x;
-                            });
-                        }
-                    });
-                }
-
-                std::vector<std::thread> consumers;
-                for (int i = 0; i < consumerCount; ++i)
-                {
-                    consumers.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < testCount; ++j)
-                        {
-                            msgQueue.pop_front()();
-                        }
-                    });
-                }
-
-                for (auto &thread : consumers)
-                {
-                    thread.join();
-                }
+                msgQueue.pop_front()();
+            }
+        });
+    }
 
-                int index = 0;
-                for (auto &thread : producers)
-                {
-                    thread.join();
-                    ASSERT_TRUE(static_cast<std::size_t>(counts[index++]) == testCount);
-                }
+    for (auto &thread : consumers)
+    {
+        thread.join();
+    }
+
+    int index = 0;
+    for (auto &thread : producers)
+    {
+        thread.join();
+        ASSERT_TRUE(static_cast<std::size_t>(counts[index++]) == testCount);
+    }
+
+    ASSERT_TRUE(x == (testCount * producerCount));
+}
+
+TEST(MessageQueueTests, TryPopFrontTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    int x = 0;
+
+    // Insert data
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&]()
+        {
+            ++x;
+        });
+    }
+
+    ASSERT_TRUE(x == 0);
+
+    std::function<void(void)> func;
+    while (msgQueue.try_pop_front(func))
+    {
+        func();
+    }
+
+    ASSERT_TRUE(x == testCount);
+}
+
+TEST(MessageQueueTests, LargeQueueDestructionTest)
+{
+    // Destroying a queue with lots of pending messages should not overflow the stack
+    const std::size_t testCount = 500000;
+    auto msgQueue = std::make_unique<dhorn::experimental::message_queue<void(void)>>();
+    auto value = std::make_shared<int>(0);
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue->push_back([value]() {});
+    }
+
+    ASSERT_TRUE(static_cast<std::size_t>(value.use_count()) == testCount + 1);
+    msgQueue.reset();
+    ASSERT_TRUE(value.use_count() == 1);
+}
+
+TEST(MessageQueueTests, NodeReuseTest)
+{
+    // Nodes that get re-used should not hold onto the previous function's state
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    auto value = std::make_shared<int>(0);
+
+    for (std::size_t round = 0; round < 3; ++round)
+    {
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            msgQueue.push_back([value]() { ++*value; });
+        }
+
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            msgQueue.pop_front()();
+        }
+
+        ASSERT_TRUE(value.use_count() == 1);
+    }
+
+    ASSERT_TRUE(*value == 3 * testCount);
+}
+
+TEST(MessageQueueTests, FreeListCapTest)
+{
+    // Bursts that are larger than the free list cap free the extra nodes (instead of holding onto them for the life of
+    // the queue), but nodes that do get re-used must still behave like new ones
+    const std::size_t testCount = 4 * dhorn::experimental::details::message_queue_types<int(void)>::max_free_nodes + 1;
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+    auto value = std::make_shared<int>(0);
+
+    for (std::size_t round = 0; round < 3; ++round)
+    {
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            msgQueue.push_back([value, i]() { return static_cast<int>(i); });
+        }
+
+        ASSERT_EQ(testCount, msgQueue.size());
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            ASSERT_EQ(static_cast<int>(i), msgQueue.pop_front()());
+        }
+
+        ASSERT_TRUE(msgQueue.empty());
+        ASSERT_EQ(1, value.use_count());
+    }
+
+    // Destroying a queue that has both pending messages and a full free list shouldn't leak or overflow the stack
+    auto otherQueue = std::make_unique<dhorn::experimental::message_queue<int(void)>>();
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        otherQueue->push_back([value]() { return 0; });
+    }
+
+    for (std::size_t i = 0; i < testCount / 2; ++i)
+    {
+        otherQueue->pop_front();
+    }
 
-                ASSERT_TRUE(x == (testCount * producerCount));
+    otherQueue.reset();
+    ASSERT_EQ(1, value.use_count());
+}
+
+TEST(MessageQueueTests, PushBackRangeTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+
+    std::vector<std::function<int(void)>> funcs;
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        funcs.push_back([i]() { return i; });
+    }
+
+    msgQueue.push_back_range(funcs.begin(), funcs.begin());
+    ASSERT_TRUE(msgQueue.empty());
+
+    msgQueue.push_back([]() { return -1; });
+    msgQueue.push_back_range(funcs.begin(), funcs.end());
+    ASSERT_TRUE(msgQueue.size() == testCount + 1);
+
+    ASSERT_TRUE(msgQueue.pop_front()() == -1);
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()() == i);
+    }
+
+    // Second time around should re-use the nodes that were just freed
+    msgQueue.push_back_range(funcs.begin(), funcs.end());
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()() == i);
+    }
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+TEST(MessageQueueTests, DrainTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+
+    std::vector<std::function<int(void)>> funcs;
+    ASSERT_TRUE(msgQueue.drain(std::back_inserter(funcs)) == 0);
+    ASSERT_TRUE(funcs.empty());
+
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        msgQueue.push_back([i]() { return i; });
+    }
+
+    ASSERT_TRUE(msgQueue.drain(std::back_inserter(funcs)) == testCount);
+    ASSERT_TRUE(msgQueue.empty());
+    ASSERT_TRUE(funcs.size() == testCount);
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(funcs[i]() == i);
+    }
+
+    // The queue should still be usable afterwards
+    msgQueue.push_back([]() { return 42; });
+    ASSERT_TRUE(msgQueue.pop_front()() == 42);
+}
+
+TEST(MessageQueueTests, TryPopFrontNTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        msgQueue.push_back([i]() { return i; });
+    }
+
+    std::vector<std::function<int(void)>> funcs;
+    ASSERT_TRUE(msgQueue.try_pop_front_n(10, std::back_inserter(funcs)) == 10);
+    ASSERT_TRUE(msgQueue.size() == testCount - 10);
+    ASSERT_TRUE(msgQueue.try_pop_front_n(testCount, std::back_inserter(funcs)) == testCount - 10);
+    ASSERT_TRUE(msgQueue.empty());
+    ASSERT_TRUE(msgQueue.try_pop_front_n(testCount, std::back_inserter(funcs)) == 0);
+
+    ASSERT_TRUE(funcs.size() == testCount);
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(funcs[i]() == i);
+    }
+}
+
+TEST(MessageQueueTests, MultipleProducersBatchConsumerTest)
+{
+    const std::size_t testCount = 1000;
+    const std::size_t producerCount = 20;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    std::atomic_int x{};
+
+    std::vector<std::thread> producers;
+    for (std::size_t i = 0; i < producerCount; ++i)
+    {
+        producers.emplace_back([&]()
+        {
+            std::vector<std::function<void(void)>> funcs(10, [&]() { ++x; });
+            for (std::size_t j = 0; j < testCount; j += funcs.size())
+            {
+                msgQueue.push_back_range(funcs.begin(), funcs.end());
             }
+        });
+    }
+
+    std::size_t count = 0;
+    std::vector<std::function<void(void)>> funcs;
+    while (count < testCount * producerCount)
+    {
+        funcs.clear();
+        count += msgQueue.drain(std::back_inserter(funcs));
+        for (auto &func : funcs)
+        {
+            func();
+        }
+    }
+
+    for (auto &thread : producers)
+    {
+        thread.join();
+    }
+
+    ASSERT_TRUE(x == (testCount * producerCount));
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+TEST(MessageQueueTests, BatchFreeListCapTest)
+{
+    // Batches that are larger than the room left on the free list only keep what fits
+    const std::size_t testCount = 3 * dhorn::experimental::details::message_queue_types<int(void)>::max_free_nodes + 7;
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+    auto value = std::make_shared<int>(0);
+
+    std::vector<std::function<int(void)>> funcs;
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        funcs.push_back([value, i]() { return i; });
+    }
+
+    for (std::size_t round = 0; round < 3; ++round)
+    {
+        msgQueue.push_back_range(funcs.begin(), funcs.end());
+        ASSERT_EQ(testCount, msgQueue.size());
 
-            TEST_METHOD(TryPopFrontTest)
+        std::vector<std::function<int(void)>> results;
+        ASSERT_EQ(10u, msgQueue.try_pop_front_n(10, std::back_inserter(results)));
+        ASSERT_EQ(testCount - 10, msgQueue.drain(std::back_inserter(results)));
+        ASSERT_TRUE(msgQueue.empty());
+
+        ASSERT_EQ(testCount, results.size());
+        for (int i = 0; i < static_cast<int>(testCount); ++i)
+        {
+            ASSERT_EQ(i, results[i]());
+        }
+    }
+
+    funcs.clear();
+    ASSERT_EQ(1, value.use_count());
+}
+
+TEST(MessageQueueTests, PopFrontForTimeoutTest)
+{
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+
+    auto start = std::chrono::steady_clock::now();
+    auto func = msgQueue.pop_front_for(std::chrono::milliseconds(50));
+    ASSERT_FALSE(static_cast<bool>(func));
+    ASSERT_TRUE((std::chrono::steady_clock::now() - start) >= std::chrono::milliseconds(50));
+
+    msgQueue.push_back([]() { return 42; });
+    func = msgQueue.pop_front_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(static_cast<bool>(func));
+    ASSERT_TRUE(func() == 42);
+}
+
+TEST(MessageQueueTests, PopFrontUntilTest)
+{
+    dhorn::experimental::message_queue<int(void)> msgQueue;
+
+    std::thread producer([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        msgQueue.push_back([]() { return 42; });
+    });
+
+    // Generous timeout so that we don't have flakiness
+    auto func = msgQueue.pop_front_until(std::chrono::steady_clock::now() + std::chrono::seconds(30));
+    ASSERT_TRUE(static_cast<bool>(func));
+    ASSERT_TRUE(func() == 42);
+
+    producer.join();
+}
+
+TEST(MessageQueueTests, CloseWakesConsumersTest)
+{
+    const std::size_t consumerCount = 10;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    std::atomic_int emptyCount{};
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        consumers.emplace_back([&, i]()
+        {
+            // Mix of timed and untimed waits
+            auto func = (i % 2) ? msgQueue.pop_front() : msgQueue.pop_front_for(std::chrono::hours(1));
+            if (!func)
             {
-                const std::size_t testCount = 100;
-                dhorn::experimental::message_queue<void(void)> msgQueue;
-                int x = 0;
+                ++emptyCount;
+            }
+        });
+    }
 
-                // Insert data
-                for (std::size_t i = 0; i < testCount; ++i)
-                {
-                    msgQueue.push_back([&]()
-                    {
-                        ++x;
-                    });
-                }
+    ASSERT_FALSE(msgQueue.closed());
+    msgQueue.close();
+    ASSERT_TRUE(msgQueue.closed());
 
-                ASSERT_TRUE(x == 0);
+    for (auto &thread : consumers)
+    {
+        thread.join();
+    }
 
-                std::function<void(void)> func;
-                while (msgQueue.try_pop_front(func))
-                {
-                    func();
-                }
+    ASSERT_TRUE(emptyCount == consumerCount);
+}
 
-                ASSERT_TRUE(x == testCount);
+TEST(MessageQueueTests, CloseDrainsRemainingMessagesTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    int x = 0;
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&]() { ++x; });
+    }
+
+    msgQueue.close();
+    while (auto func = msgQueue.pop_front())
+    {
+        func();
+    }
+
+    ASSERT_TRUE(x == testCount);
+    ASSERT_FALSE(static_cast<bool>(msgQueue.pop_front_for(std::chrono::hours(1))));
+}
+
+TEST(MessageQueueTests, CloseWhileBlockedTest)
+{
+    // Unlike CloseWakesConsumersTest, make sure that the consumers are actually blocked by the time the queue is closed
+    const std::size_t consumerCount = 6;
+    dhorn::experimental::message_queue<void(void)> msgQueue;
+    std::atomic_size_t waitingCount{};
+    std::atomic_size_t emptyCount{};
+
+    std::vector<std::thread> consumers;
+    for (std::size_t i = 0; i < consumerCount; ++i)
+    {
+        consumers.emplace_back([&, i]()
+        {
+            ++waitingCount;
+            std::function<void(void)> func;
+            switch (i % 3)
+            {
+            case 0:
+                func = msgQueue.pop_front();
+                break;
+
+            case 1:
+                func = msgQueue.pop_front_for(std::chrono::hours(1));
+                break;
+
+            default:
+                func = msgQueue.pop_front_until(std::chrono::steady_clock::now() + std::chrono::hours(1));
+                break;
             }
-        };
+
+            if (!func)
+            {
+                ++emptyCount;
+            }
+        });
+    }
+
+    while (waitingCount != consumerCount)
+    {
+        std::this_thread::yield();
     }
+
+    // Give the consumers plenty of time to go from announcing themselves to blocking on the queue
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(0u, emptyCount.load());
+
+    auto start = std::chrono::steady_clock::now();
+    msgQueue.close();
+    for (auto &thread : consumers)
+    {
+        thread.join();
+    }
+
+    // The timed waits must have been woken by close and not by their timeout
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::minutes(1));
+    ASSERT_EQ(consumerCount, emptyCount.load());
+
+    // Pushing after close is still allowed, and those messages can still be popped
+    msgQueue.push_back([]() {});
+    ASSERT_TRUE(static_cast<bool>(msgQueue.pop_front()));
+    ASSERT_FALSE(static_cast<bool>(msgQueue.pop_front()));
 }
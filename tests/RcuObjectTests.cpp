@@ -0,0 +1,306 @@
+/*
+ * Duncan Horn
+ *
+ * RcuObjectTests.cpp
+ *
+ * Tests for rcu_object.h
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <dhorn/experimental/rcu_object.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dhorn::experimental;
+
+TEST(RcuObjectTests, DefaultConstructionTest)
+{
+    rcu_object<std::string> obj;
+    ASSERT_TRUE(obj.read()->empty());
+}
+
+TEST(RcuObjectTests, ValueConstructionTest)
+{
+    rcu_object<std::string> obj("foo");
+    ASSERT_EQ(std::string("foo"), *obj.read());
+}
+
+TEST(RcuObjectTests, PublishTest)
+{
+    rcu_object<std::string> obj("foo");
+
+    obj.publish("bar");
+    ASSERT_EQ(std::string("bar"), *obj.read());
+
+    obj.publish(std::make_unique<std::string>("baz"));
+    ASSERT_EQ(std::string("baz"), *obj.read());
+}
+
+TEST(RcuObjectTests, UpdateTest)
+{
+    rcu_object<std::map<std::string, int>> obj;
+
+    obj.update([](const std::map<std::string, int> &current)
+    {
+        auto result = current;
+        result["foo"] = 42;
+        return result;
+    });
+
+    obj.update([](const std::map<std::string, int> &current)
+    {
+        auto result = current;
+        result["bar"] = 8;
+        return result;
+    });
+
+    auto guard = obj.read();
+    ASSERT_EQ(static_cast<std::size_t>(2), guard->size());
+    ASSERT_EQ(42, guard->at("foo"));
+    ASSERT_EQ(8, guard->at("bar"));
+}
+
+TEST(RcuObjectTests, UpdateThrowTest)
+{
+    rcu_object<std::string> obj("foo");
+
+    ASSERT_THROW(obj.update([](const std::string &) -> std::string
+    {
+        throw std::runtime_error("Expected");
+    }), std::runtime_error);
+
+    // Value should be unchanged
+    ASSERT_EQ(std::string("foo"), *obj.read());
+}
+
+TEST(RcuObjectTests, GuardOutlivesPublishTest)
+{
+    auto ptr = std::make_shared<int>(42);
+    rcu_object<std::shared_ptr<int>> obj(ptr);
+
+    {
+        auto guard = obj.read();
+        obj.publish(std::shared_ptr<int>());
+        obj.publish(std::shared_ptr<int>());
+
+        // The value we are reading must still be alive
+        ASSERT_EQ(42, **guard);
+        ASSERT_EQ(2, ptr.use_count());
+        ASSERT_EQ(nullptr, *obj.read());
+
+        // Moving the guard shouldn't release it
+        auto other = std::move(guard);
+        obj.publish(std::shared_ptr<int>());
+        ASSERT_EQ(42, **other);
+    }
+
+    // Now that the guard is released, synchronize should reclaim the old value
+    obj.synchronize();
+    ASSERT_EQ(1, ptr.use_count());
+}
+
+TEST(RcuObjectTests, ReclaimWithoutReadersTest)
+{
+    auto ptr = std::make_shared<int>(42);
+    rcu_object<std::shared_ptr<int>> obj(ptr);
+
+    // With no readers around, the old value should get reclaimed right away
+    obj.publish(std::shared_ptr<int>());
+    ASSERT_EQ(1, ptr.use_count());
+}
+
+TEST(RcuObjectTests, ConcurrentReadWriteTest)
+{
+    struct data
+    {
+        std::size_t a = 0;
+        std::vector<std::size_t> values;
+    };
+
+    rcu_object<data> obj;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_writers = 2;
+    static const std::size_t num_readers = 8;
+    static const std::size_t num_iterations = 1000;
+
+    for (std::size_t i = 0; i < num_writers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                obj.update([](const data &current)
+                {
+                    data result;
+                    result.a = current.a + 1;
+                    result.values.assign(result.a % 64, result.a);
+                    return result;
+                });
+            }
+        });
+    }
+
+    for (std::size_t i = 0; i < num_readers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                // Readers should never observe a partially written value
+                auto guard = obj.read();
+                ASSERT_EQ(guard->a % 64, guard->values.size());
+                for (auto value : guard->values)
+                {
+                    ASSERT_EQ(guard->a, value);
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(num_writers * num_iterations, obj.read()->a);
+}
+
+// Values poison themselves on destruction, so a reader that gets handed (or holds on to) a value that's already been
+// freed sees the wrong magic number. Running under AddressSanitizer turns that into a use-after-free report
+struct tracked_value
+{
+    static constexpr std::uint32_t alive_magic = 0xA11FEu;
+    static constexpr std::uint32_t dead_magic = 0xDEADu;
+    static inline std::atomic_size_t instance_count{ 0 };
+
+    explicit tracked_value(std::size_t version) :
+        version(version)
+    {
+        this->payload.fill(version);
+        ++instance_count;
+    }
+
+    tracked_value(const tracked_value &other) :
+        version(other.version),
+        payload(other.payload)
+    {
+        ++instance_count;
+    }
+
+    ~tracked_value()
+    {
+        this->magic.store(dead_magic);
+        --instance_count;
+    }
+
+    std::atomic_uint32_t magic{ alive_magic };
+    std::size_t version;
+    std::array<std::size_t, 16> payload;
+};
+
+TEST(RcuObjectTests, ReaderWriterStressTest)
+{
+    static const std::size_t num_writers = 4;
+    static const std::size_t num_readers = 8;
+    static const std::size_t num_iterations = 2000;
+
+    {
+        rcu_object<tracked_value> obj(tracked_value(0));
+        std::atomic_size_t runningWriters{ num_writers };
+        std::atomic_size_t failures{ 0 };
+        std::vector<std::thread> threads;
+
+        auto check = [&](const tracked_value &value)
+        {
+            if (value.magic.load() != tracked_value::alive_magic)
+            {
+                ++failures;
+                return false;
+            }
+
+            for (auto entry : value.payload)
+            {
+                if (entry != value.version)
+                {
+                    ++failures;
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+        for (std::size_t i = 0; i < num_writers; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                for (std::size_t j = 0; j < num_iterations; ++j)
+                {
+                    if ((i + j) % 2)
+                    {
+                        obj.update([](const tracked_value &current)
+                        {
+                            return tracked_value(current.version + 1);
+                        });
+                    }
+                    else
+                    {
+                        // Publishing while holding a read guard must not free the value being read
+                        auto guard = obj.read();
+                        obj.publish(tracked_value(guard->version + num_iterations * num_writers));
+                        check(*guard);
+                    }
+                }
+
+                --runningWriters;
+            });
+        }
+
+        for (std::size_t i = 0; i < num_readers; ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                for (std::size_t j = 0; runningWriters.load() > 0; ++j)
+                {
+                    auto guard = obj.read();
+                    if (!check(*guard))
+                    {
+                        return;
+                    }
+
+                    // Occasionally hold on to the guard (and a nested one) while writers retire values around us
+                    if (((i + j) % 16) == 0)
+                    {
+                        auto nested = obj.read();
+                        std::this_thread::yield();
+                        if (!check(*guard) || !check(*nested))
+                        {
+                            return;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        ASSERT_EQ(0u, failures.load());
+
+        // Everything that's been replaced should be freed once there are no more readers
+        obj.synchronize();
+        ASSERT_EQ(1u, tracked_value::instance_count.load());
+    }
+
+    ASSERT_EQ(0u, tracked_value::instance_count.load());
+}
@@ -0,0 +1,211 @@
+/*
+ * Duncan Horn
+ *
+ * SpscMessageQueueTests.cpp
+ *
+ * Tests for spsc_message_queue<void(void)>
+ */
+
+#include <dhorn/experimental/message_queue.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+TEST(SpscMessageQueueTests, CapacityTest)
+{
+    ASSERT_TRUE(dhorn::experimental::spsc_message_queue<void(void)>(1).capacity() == 1);
+    ASSERT_TRUE(dhorn::experimental::spsc_message_queue<void(void)>(8).capacity() == 8);
+    ASSERT_TRUE(dhorn::experimental::spsc_message_queue<void(void)>(9).capacity() == 16);
+}
+
+TEST(SpscMessageQueueTests, SingleThreadTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::spsc_message_queue<int(int, int)> msgQueue(testCount);
+    int x = 0;
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&](int a, int b) -> int
+        {
+            ++x;
+            return a + b;
+        });
+    }
+
+    ASSERT_TRUE(x == 0);
+    ASSERT_TRUE(msgQueue.size() == testCount);
+
+    int localCount = 0;
+    for (int i = 0; i < static_cast<int>(testCount); ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()(i, 1) == (i + 1));
+        ASSERT_TRUE(x == ++localCount);
+    }
+
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+TEST(SpscMessageQueueTests, TryPushBackTest)
+{
+    dhorn::experimental::spsc_message_queue<void(void)> msgQueue(4);
+    int x = 0;
+
+    for (std::size_t i = 0; i < msgQueue.capacity(); ++i)
+    {
+        ASSERT_TRUE(msgQueue.try_push_back([&]() { ++x; }));
+    }
+
+    // Queue is full; the function should be left untouched
+    dhorn::experimental::spsc_message_queue<void(void)>::function_type func = [&]() { x += 10; };
+    ASSERT_FALSE(msgQueue.try_push_back(func));
+    ASSERT_TRUE(func != nullptr);
+
+    msgQueue.pop_front()();
+    ASSERT_TRUE(x == 1);
+    ASSERT_TRUE(msgQueue.try_push_back(func));
+
+    while (!msgQueue.empty())
+    {
+        msgQueue.pop_front()();
+    }
+
+    ASSERT_TRUE(x == 14);
+}
+
+TEST(SpscMessageQueueTests, TryPopFrontTest)
+{
+    const std::size_t testCount = 100;
+    dhorn::experimental::spsc_message_queue<void(void)> msgQueue(testCount);
+    int x = 0;
+
+    dhorn::experimental::spsc_message_queue<void(void)>::function_type func;
+    ASSERT_FALSE(msgQueue.try_pop_front(func));
+
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        msgQueue.push_back([&]()
+        {
+            ++x;
+        });
+    }
+
+    while (msgQueue.try_pop_front(func))
+    {
+        func();
+    }
+
+    ASSERT_TRUE(x == testCount);
+}
+
+TEST(SpscMessageQueueTests, PopReleasesFunctionTest)
+{
+    dhorn::experimental::spsc_message_queue<void(void)> msgQueue(4);
+    auto ptr = std::make_shared<int>(42);
+
+    msgQueue.push_back([ptr]() {});
+    ASSERT_TRUE(ptr.use_count() == 2);
+
+    {
+        auto func = msgQueue.pop_front();
+        ASSERT_TRUE(ptr.use_count() == 2);
+    }
+
+    // The slot in the ring buffer should no longer hold a reference
+    ASSERT_TRUE(ptr.use_count() == 1);
+}
+
+TEST(SpscMessageQueueTests, MoveOnlyFunctionTest)
+{
+    dhorn::experimental::spsc_message_queue<int(void)> msgQueue(4);
+
+    msgQueue.push_back([ptr = std::make_unique<int>(42)]() { return *ptr; });
+    ASSERT_TRUE(msgQueue.pop_front()() == 42);
+}
+
+TEST(SpscMessageQueueTests, ProducerConsumerTest)
+{
+    const int testCount = 100000;
+    dhorn::experimental::spsc_message_queue<int(void)> msgQueue(64);
+
+    std::thread producer([&]()
+    {
+        for (int i = 0; i < testCount; ++i)
+        {
+            msgQueue.push_back([i]() { return i; });
+        }
+    });
+
+    // Messages should come out in the order that they were pushed
+    for (int i = 0; i < testCount; ++i)
+    {
+        ASSERT_TRUE(msgQueue.pop_front()() == i);
+    }
+
+    producer.join();
+    ASSERT_TRUE(msgQueue.empty());
+}
+
+
+TEST(SpscMessageQueueTests, WrapAroundStressTest)
+{
+    // A tiny ring means that the head and tail wrap around the buffer many times, and that both threads constantly
+    // find the queue full/empty according to their cached copy of the other thread's index and have to refresh it.
+    // Each side occasionally pauses so that the other sees both a full and an empty queue
+    const std::size_t testCount = 200000;
+    dhorn::experimental::spsc_message_queue<std::size_t(void)> msgQueue(4);
+    ASSERT_GT(testCount / msgQueue.capacity(), 10000u);
+
+    std::thread producer([&]()
+    {
+        for (std::size_t i = 0; i < testCount; ++i)
+        {
+            auto ptr = std::make_shared<std::size_t>(i);
+            if ((i % 2) == 0)
+            {
+                msgQueue.push_back([ptr]() { return *ptr; });
+            }
+            else
+            {
+                dhorn::experimental::spsc_message_queue<std::size_t(void)>::function_type func =
+                    [ptr]() { return *ptr; };
+                while (!msgQueue.try_push_back(func))
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            if ((i % 4099) == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    dhorn::experimental::spsc_message_queue<std::size_t(void)>::function_type func;
+    for (std::size_t i = 0; i < testCount; ++i)
+    {
+        if ((i % 3) == 0)
+        {
+            func = msgQueue.pop_front();
+        }
+        else
+        {
+            while (!msgQueue.try_pop_front(func))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        // Messages must come out in order, and exactly once
+        ASSERT_EQ(i, func());
+        if ((i % 4111) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    ASSERT_TRUE(msgQueue.empty());
+    ASSERT_FALSE(msgQueue.try_pop_front(func));
+}
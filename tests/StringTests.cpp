@@ -231,6 +231,92 @@ TEST(StringTests, StartsWithStringLiteralTest)
     ASSERT_TRUE(dhorn::starts_with(constStr, str));
 }
 
+TEST(StringTests, IEqualsTest)
+{
+    std::string str = "Content-Length";
+    std::string_view lower = "content-length";
+    std::string upper = "CONTENT-LENGTH";
+
+    ASSERT_TRUE(dhorn::iequals(str, lower));
+    ASSERT_TRUE(dhorn::iequals(lower, upper));
+    ASSERT_TRUE(dhorn::iequals(str, "content-LENGTH"));
+    ASSERT_TRUE(dhorn::iequals("CONTENT-length", str));
+    ASSERT_TRUE(dhorn::iequals("content-length", "Content-Length"));
+    ASSERT_TRUE(dhorn::iequals(str.begin(), str.end(), upper.begin(), upper.end()));
+    ASSERT_TRUE(dhorn::iequals(dhorn::const_null_terminated_string("CONTENT-LENGTH"), lower));
+
+    ASSERT_FALSE(dhorn::iequals(str, "content-lengt"));
+    ASSERT_FALSE(dhorn::iequals(str, "content-lengthh"));
+    ASSERT_FALSE(dhorn::iequals(str, "content_length"));
+    ASSERT_FALSE(dhorn::iequals("content-length", "Content-Lengt"));
+
+    // Only ASCII letters are case insensitive
+    ASSERT_FALSE(dhorn::iequals(std::string("@[`{"), std::string("`{@[")));
+    ASSERT_FALSE(dhorn::iequals(std::string("\xC0"), std::string("\xE0")));
+
+    std::u16string u16str = u"Content-Length";
+    ASSERT_TRUE(dhorn::iequals(u16str, u"CONTENT-LENGTH"));
+    ASSERT_FALSE(dhorn::iequals(u16str, u"CONTENT-LENGTHS"));
+
+    ASSERT_TRUE(dhorn::iequals(std::string(), ""));
+    ASSERT_FALSE(dhorn::iequals(std::string(), "a"));
+}
+
+TEST(StringTests, ICompareTest)
+{
+    std::string str = "abcDEF";
+    ASSERT_EQ(0, dhorn::icompare(str, "ABCdef"));
+    ASSERT_GT(0, dhorn::icompare(str, "ABCdeg"));
+    ASSERT_LT(0, dhorn::icompare(str, "ABCdee"));
+    ASSERT_GT(0, dhorn::icompare(str, "ABCdefg"));
+    ASSERT_LT(0, dhorn::icompare(str, "ABCde"));
+    ASSERT_GT(0, dhorn::icompare("", str));
+    ASSERT_EQ(0, dhorn::icompare("", ""));
+
+    // Comparison is done as if letters were lower case, and treats char as unsigned
+    ASSERT_GT(0, dhorn::icompare("_", "A"));
+    ASSERT_LT(0, dhorn::icompare("\x80", "z"));
+}
+
+TEST(StringTests, IStartsWithTest)
+{
+    std::string str = "Bearer ABC123";
+    ASSERT_TRUE(dhorn::istarts_with(str, "bearer "));
+    ASSERT_TRUE(dhorn::istarts_with(str, std::string_view("BEARER abc")));
+    ASSERT_TRUE(dhorn::istarts_with(str, str));
+    ASSERT_TRUE(dhorn::istarts_with(str, ""));
+    ASSERT_TRUE(dhorn::istarts_with("BEARER abc123", str));
+    ASSERT_FALSE(dhorn::istarts_with(str, "basic "));
+    ASSERT_FALSE(dhorn::istarts_with(str, "bearer abc1234"));
+    ASSERT_FALSE(dhorn::istarts_with("bearer", "bearer "));
+}
+
+TEST(StringTests, ILongStringTest)
+{
+    // Long enough to go through the vectorized path, with a mismatch at every possible position
+    std::string lower;
+    for (int i = 0; i < 100; ++i)
+    {
+        lower.push_back(static_cast<char>('a' + (i % 26)));
+    }
+
+    std::string upper = lower;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](char ch) { return static_cast<char>(ch - 0x20); });
+    ASSERT_TRUE(dhorn::iequals(lower, upper));
+    ASSERT_EQ(0, dhorn::icompare(lower, upper));
+
+    for (std::size_t i = 0; i < upper.size(); ++i)
+    {
+        auto copy = upper;
+        copy[i] = '[';
+        ASSERT_FALSE(dhorn::iequals(lower, copy));
+        ASSERT_LT(0, dhorn::icompare(lower, copy));
+        ASSERT_GT(0, dhorn::icompare(copy, lower));
+        ASSERT_TRUE(dhorn::istarts_with(lower, copy.substr(0, i)));
+        ASSERT_FALSE(dhorn::istarts_with(lower, copy.substr(0, i + 1)));
+    }
+}
+
 TEST(NullTerminatedStringTests, AssignmentTest)
 {
     // NOTE: Strictly a "does it compile" test
@@ -5,517 +5,755 @@
  *
  * Tests for synchronized_object.h
  */
-#include "stdafx.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <dhorn/experimental/synchronized_object.h>
+#include <gtest/gtest.h>
+#include <shared_mutex>
 #include <thread>
 #include <vector>
 
-#include <dhorn/experimental/synchronized_object.h>
+class copy_count
+{
+public:
+    copy_count() :
+        _copies(0)
+    {
+    }
 
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+    copy_count(copy_count &other) :
+        _copies(++other._copies)
+    {
+    }
 
-namespace dhorn
+    copy_count &operator=(copy_count &other)
+    {
+        if (&other != this)
+        {
+            this->_copies = ++other._copies;
+        }
+
+        return *this;
+    }
+
+    std::size_t copies() const
+    {
+        return this->_copies;
+    }
+
+private:
+
+    std::size_t _copies;
+};
+
+template <typename Ty, std::size_t Size>
+class dynamically_allocated_array
 {
-    namespace tests
+public:
+    dynamically_allocated_array() :
+        _copying{}
+    {
+    }
+
+    dynamically_allocated_array(const dynamically_allocated_array &other) :
+        dynamically_allocated_array()
+    {
+        this->copy(other);
+    }
+
+    dynamically_allocated_array &operator=(const dynamically_allocated_array &other)
     {
-        class copy_count
+        if (&other != this)
         {
-        public:
-            copy_count() :
-                _copies(0)
-            {
-            }
+            this->copy(other);
+        }
 
-            copy_count(copy_count &other) :
-                _copies(++other._copies)
-            {
-            }
+        return *this;
+    }
 
-            copy_count &operator=(copy_count &other)
-            {
-                if (&other != this)
-                {
-                    this->_copies = ++other._copies;
-                }
+    Ty &operator[](std::size_t index)
+    {
+        return this->_vals[index];
+    }
 
-                return *this;
-            }
+    const Ty &operator[](std::size_t index) const
+    {
+        return this->_vals[index];
+    }
 
-            std::size_t copies() const
-            {
-                return this->_copies;
-            }
+    auto begin()
+    {
+        return std::begin(this->_vals);
+    }
+
+    auto end()
+    {
+        return std::end(this->_vals);
+    }
 
-        private:
+private:
 
-            std::size_t _copies;
-        };
+    void copy(const dynamically_allocated_array &)
+    {
+        // Keep track of the number of threads modifying the object at any given time. Therefore, if any value
+        // is not 1, we know that there is a race
+        ++this->_copying;
 
-        template <typename Ty, std::size_t Size>
-        class dynamically_allocated_array
+        for (auto &val : this->_vals)
         {
-        public:
-            dynamically_allocated_array() :
-                _copying{}
-            {
-            }
+            val = this->_copying.load();
+        }
 
-            dynamically_allocated_array(const dynamically_allocated_array &other) :
-                dynamically_allocated_array()
-            {
-                this->copy(other);
-            }
+        --this->_copying;
+    }
 
-            dynamically_allocated_array &operator=(const dynamically_allocated_array &other)
-            {
-                if (&other != this)
-                {
-                    this->copy(other);
-                }
+    Ty _vals[Size];
+    std::atomic_size_t _copying;
+};
 
-                return *this;
-            }
+TEST(SynchronizedObjectTests, BasicLockingTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::vector<std::thread> threads;
 
-            Ty &operator[](std::size_t index)
-            {
-                return this->_vals[index];
-            }
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
 
-            const Ty &operator[](std::size_t index) const
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                return this->_vals[index];
+                val.execute_with_lock([](std::size_t &value, const auto &)
+                {
+                    ++value;
+                });
             }
+        });
+    }
 
-            auto begin()
-            {
-                return std::begin(this->_vals);
-            }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
+}
+
+/*****
+TEST(SynchronizedObjectTests, BasicIncorrectLockingTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::vector<std::thread> threads;
 
-            auto end()
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                return std::end(this->_vals);
+                val.execute_without_lock([](std::size_t &value)
+                {
+                    ++value;
+                });
             }
+        });
+    }
 
-        private:
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-            void copy(const dynamically_allocated_array &)
-            {
-                // Keep track of the number of threads modifying the object at any given time. Therefore, if any value
-                // is not 1, we know that there is a race
-                ++this->_copying;
+    // The access to val was not thread safe; at least one should have screwed up. This technically can
+    // fail unexpectedly, but it's highly unlikely
+    ASSERT_NE(num_threads * num_iterations, val.copy_unlocked());
+}
+*****/
 
-                for (auto &val : this->_vals)
+TEST(SynchronizedObjectTests, BasicMonitorTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::condition_variable cond;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_threads = 12;
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&, index = i]()
+        {
+            val.execute_with_lock([&](std::size_t &value, std::unique_lock<std::mutex> &lock)
+            {
+                // Threads wait in the "reverse" order. I.e. "early" threads wait on "later" threads
+                cond.wait(lock, [&]() -> bool
                 {
-                    val = this->_copying.load();
-                }
+                    return (num_threads - index - 1) == value;
+                });
 
-                --this->_copying;
-            }
+                // Don't know which thread we'll wake up, so notify all
+                ++value;
+                cond.notify_all();
+            });
+        });
+    }
 
-            Ty _vals[Size];
-            std::atomic_size_t _copying;
-        };
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
+    ASSERT_EQ(num_threads, val.copy_unlocked());
+}
 
+TEST(SynchronizedObjectTests, RecursiveMutexTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t, std::recursive_mutex> val = 0;
+    val.execute_with_lock([&](auto &, auto &)
+    {
+        // Shouldn't deadlock
+        val.execute_with_lock([&](auto &value, auto &)
+        {
+            value = 42;
+        });
+    });
 
-        TEST_CLASS(SynchronizedObjectTests)
+    ASSERT_EQ(static_cast<std::size_t>(42), val.copy_unlocked());
+}
+
+TEST(SynchronizedObjectTests, CopyLockedLockedTest)
+{
+    dhorn::experimental::synchronized_object<copy_count> val;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 1000;
+    std::vector<std::size_t> check_vector(num_threads * num_iterations);
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
         {
-            TEST_METHOD(BasicLockingTest)
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::vector<std::thread> threads;
+                // The copy count of each copy should be unique when we lock
+                ++check_vector[val.copy_locked().copies() - 1];
+            }
+        });
+    }
 
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            val.execute_with_lock([](std::size_t &value, const auto &)
-                            {
-                                ++value;
-                            });
-                        }
-                    });
-                }
+    for (auto count : check_vector)
+    {
+        ASSERT_EQ(static_cast<std::size_t>(1), count);
+    }
+}
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+/*****
+TEST(SynchronizedObjectTests, CopyUnlockedLockedTest)
+{
+    dhorn::experimental::synchronized_object<copy_count> val;
+    std::vector<std::thread> threads;
 
-                ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
-            }
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
+    std::vector<std::size_t> check_vector(num_threads * num_iterations);
 
-            /*****
-            TEST_METHOD(BasicIncorrectLockingTest)
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::vector<std::thread> threads;
+                // The copy count of each copy should be unique when we lock
+                ++check_vector[val.copy_unlocked().copies() - 1];
+            }
+        });
+    }
 
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            val.execute_without_lock([](std::size_t &value)
-                            {
-                                ++value;
-                            });
-                        }
-                    });
-                }
+    bool pass = false;
+    for (auto count : check_vector)
+    {
+        // The access to val was not thread safe; at least one should have screwed up. This technically can
+        // fail unexpectedly, but it's highly unlikely
+        if (count != 1)
+        {
+            pass = true;
+            break;
+        }
+    }
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+    ASSERT_TRUE(pass);
+}
+*****/
 
-                // The access to val was not thread safe; at least one should have screwed up. This technically can
-                // fail unexpectedly, but it's highly unlikely
-                ASSERT_NE(num_threads * num_iterations, val.copy_unlocked());
-            }
-            *****/
+TEST(SynchronizedObjectTests, SetLockedTest)
+{
+    using array_type = dynamically_allocated_array<std::size_t, 1000>;
+    dhorn::experimental::synchronized_object<array_type> val;
+    std::vector<std::thread> threads;
+    std::vector<array_type> thread_vals;
 
-            TEST_METHOD(BasicMonitorTest)
-            {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::condition_variable cond;
-                std::vector<std::thread> threads;
+    static const std::size_t num_threads = 12;
 
-                static const std::size_t num_threads = 12;
+    // Fill each array with the thread's index
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        thread_vals.emplace_back();
+    }
 
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&, index = i]()
-                    {
-                        val.execute_with_lock([&](std::size_t &value, std::unique_lock<std::mutex> &lock)
-                        {
-                            // Threads wait in the "reverse" order. I.e. "early" threads wait on "later" threads
-                            cond.wait(lock, [&]() -> bool
-                            {
-                                return (num_threads - index - 1) == value;
-                            });
-
-                            // Don't know which thread we'll wake up, so notify all
-                            ++value;
-                            cond.notify_all();
-                        });
-                    });
-                }
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::size_t running = 0;
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&, index = i]()
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
 
-                for (auto &thread : threads)
+                // We need to wait for all threads to be running first to give the best shot at a race
+                // condition
+                ++running;
+                cond.wait(lock, [&]() -> bool
                 {
-                    thread.join();
-                }
-
-                ASSERT_EQ(num_threads, val.copy_unlocked());
+                    return (running == num_threads);
+                });
+                cond.notify_all();
             }
 
-            TEST_METHOD(RecursiveMutexTest)
+            val.set_locked(thread_vals[index]);
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    val.execute_without_lock([&](array_type &arr)
+    {
+        for (auto value : arr)
+        {
+            ASSERT_EQ(static_cast<std::size_t>(1), value);
+        }
+    });
+}
+
+TEST(SynchronizedObjectTests, SetUnlockedTest)
+{
+    using array_type = dynamically_allocated_array<std::size_t, 1000>;
+    dhorn::experimental::synchronized_object<array_type> val;
+    std::vector<std::thread> threads;
+    std::vector<array_type> thread_vals;
+
+    static const std::size_t num_threads = 12;
+
+    // Fill each array with the thread's index
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        thread_vals.emplace_back();
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::size_t running = 0;
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&, index = i]()
+        {
             {
-                dhorn::experimental::synchronized_object<std::size_t, std::recursive_mutex> val = 0;
-                val.execute_with_lock([&](auto &, auto &)
+                std::unique_lock<std::mutex> lock(mutex);
+
+                // We need to wait for all threads to be running first to give the best shot at a race
+                // condition
+                ++running;
+                cond.wait(lock, [&]() -> bool
                 {
-                    // Shouldn't deadlock
-                    val.execute_with_lock([&](auto &value, auto &)
-                    {
-                        value = 42;
-                    });
+                    return (running == num_threads);
                 });
-
-                ASSERT_EQ(static_cast<std::size_t>(42), val.copy_unlocked());
+                cond.notify_all();
             }
 
-            TEST_METHOD(CopyLockedLockedTest)
+            val.set_unlocked(thread_vals[index]);
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    bool pass = false;
+    val.execute_without_lock([&](array_type &arr)
+    {
+        for (auto value : arr)
+        {
+            // The access to val was not thread safe; at least one should have screwed up. This technically
+            // can fail unexpectedly, especially if the last thread is lagging behind significantly, but
+            // it's highly unlikely
+            if (value != 1)
             {
-                dhorn::experimental::synchronized_object<copy_count> val;
-                std::vector<std::thread> threads;
+                pass = true;
+                break;
+            }
+        }
+    });
 
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 1000;
-                std::vector<std::size_t> check_vector(num_threads * num_iterations);
+    ASSERT_TRUE(true);
+}
 
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            // The copy count of each copy should be unique when we lock
-                            ++check_vector[val.copy_locked().copies() - 1];
-                        }
-                    });
-                }
+TEST(SynchronizedObjectTests, LockNormalTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::vector<std::thread> threads;
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
 
-                for (auto count : check_vector)
-                {
-                    ASSERT_EQ(static_cast<std::size_t>(1), count);
-                }
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                auto lock = val.lock();
+                val.set_unlocked(val.copy_unlocked() + 1);
             }
+        });
+    }
 
-            /*****
-            TEST_METHOD(CopyUnlockedLockedTest)
-            {
-                dhorn::experimental::synchronized_object<copy_count> val;
-                std::vector<std::thread> threads;
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
-                std::vector<std::size_t> check_vector(num_threads * num_iterations);
+    ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
+}
 
-                for (std::size_t i = 0; i < num_threads; ++i)
+TEST(SynchronizedObjectTests, TryToLockTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
+    std::atomic_size_t failures{ 0 };
+    std::atomic_bool released{ false };
+
+    // Hold the lock while each thread makes its first attempt. Otherwise there's no guarantee of any contention, e.g.
+    // when running on a single core
+    auto heldLock = val.lock();
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
                 {
-                    threads.emplace_back([&]()
+                    auto lock = val.lock(std::try_to_lock);
+                    if (lock.owns_lock())
                     {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            // The copy count of each copy should be unique when we lock
-                            ++check_vector[val.copy_unlocked().copies() - 1];
-                        }
-                    });
+                        val.set_unlocked(val.copy_unlocked() + 1);
+                    }
+                    else
+                    {
+                        ++failures;
+                    }
                 }
 
-                for (auto &thread : threads)
+                while (!released.load())
                 {
-                    thread.join();
+                    std::this_thread::yield();
                 }
+            }
+        });
+    }
 
-                bool pass = false;
-                for (auto count : check_vector)
-                {
-                    // The access to val was not thread safe; at least one should have screwed up. This technically can
-                    // fail unexpectedly, but it's highly unlikely
-                    if (count != 1)
-                    {
-                        pass = true;
-                        break;
-                    }
-                }
+    while (failures.load() < num_threads)
+    {
+        std::this_thread::yield();
+    }
+    heldLock.unlock();
+    released = true;
 
-                ASSERT_TRUE(pass);
-            }
-            *****/
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    // At least one attempt to get the lock should have failed, but at least one should have succeeded
+    ASSERT_NE(static_cast<std::size_t>(0), val.copy_unlocked());
+    ASSERT_NE(num_threads * num_iterations, val.copy_unlocked());
+}
+
+TEST(SynchronizedObjectTests, DeferLockTest)
+{
+    dhorn::experimental::synchronized_object<std::size_t> val = 0;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_threads = 12;
+    static const std::size_t num_iterations = 10000;
 
-            TEST_METHOD(SetLockedTest)
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                using array_type = dynamically_allocated_array<std::size_t, 1000>;
-                dhorn::experimental::synchronized_object<array_type> val;
-                std::vector<std::thread> threads;
-                std::vector<array_type> thread_vals;
+                auto lock = val.lock(std::defer_lock);
+                lock.lock(); // Shouldn't deadlock
+                val.set_unlocked(val.copy_unlocked() + 1);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                static const std::size_t num_threads = 12;
+    ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
+}
 
-                // Fill each array with the thread's index
-                for (std::size_t i = 0; i < num_threads; ++i)
+TEST(SynchronizedObjectTests, SharedLockTest)
+{
+    dhorn::experimental::synchronized_object<std::vector<int>, std::shared_mutex> val;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_threads = 8;
+    static const std::size_t num_iterations = 1000;
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                if (i % 2)
                 {
-                    thread_vals.emplace_back();
+                    val.execute_with_lock([](std::vector<int> &vector, std::unique_lock<std::shared_mutex> &)
+                    {
+                        vector.push_back(static_cast<int>(vector.size()));
+                    });
                 }
-
-                std::mutex mutex;
-                std::condition_variable cond;
-                std::size_t running = 0;
-                for (std::size_t i = 0; i < num_threads; ++i)
+                else
                 {
-                    threads.emplace_back([&, index = i]()
+                    val.execute_with_shared_lock([](
+                        const std::vector<int> &vector,
+                        std::shared_lock<std::shared_mutex> &)
                     {
+                        for (std::size_t k = 0; k < vector.size(); ++k)
                         {
-                            std::unique_lock<std::mutex> lock(mutex);
-
-                            // We need to wait for all threads to be running first to give the best shot at a race
-                            // condition
-                            ++running;
-                            cond.wait(lock, [&]() -> bool
-                            {
-                                return (running == num_threads);
-                            });
-                            cond.notify_all();
+                            ASSERT_EQ(static_cast<int>(k), vector[k]);
                         }
-
-                        val.set_locked(thread_vals[index]);
                     });
                 }
+            }
+        });
+    }
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                val.execute_without_lock([&](array_type &arr)
-                {
-                    for (auto value : arr)
-                    {
-                        ASSERT_EQ(static_cast<std::size_t>(1), value);
-                    }
-                });
-            }
+    ASSERT_EQ((num_threads / 2) * num_iterations, val.copy_shared_locked().size());
+}
 
-            TEST_METHOD(SetUnlockedTest)
-            {
-                using array_type = dynamically_allocated_array<std::size_t, 1000>;
-                dhorn::experimental::synchronized_object<array_type> val;
-                std::vector<std::thread> threads;
-                std::vector<array_type> thread_vals;
+TEST(SynchronizedObjectTests, SeqlockTest)
+{
+    struct point
+    {
+        std::int64_t x;
+        std::int64_t y;
+        std::int32_t z;
+    };
 
-                static const std::size_t num_threads = 12;
+    dhorn::experimental::synchronized_object<point, dhorn::experimental::seqlock> val(point{ 1, 2, 3 });
 
-                // Fill each array with the thread's index
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    thread_vals.emplace_back();
-                }
+    auto value = val.copy_locked();
+    ASSERT_EQ(1, value.x);
+    ASSERT_EQ(2, value.y);
+    ASSERT_EQ(3, value.z);
 
-                std::mutex mutex;
-                std::condition_variable cond;
-                std::size_t running = 0;
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&, index = i]()
-                    {
-                        {
-                            std::unique_lock<std::mutex> lock(mutex);
-
-                            // We need to wait for all threads to be running first to give the best shot at a race
-                            // condition
-                            ++running;
-                            cond.wait(lock, [&]() -> bool
-                            {
-                                return (running == num_threads);
-                            });
-                            cond.notify_all();
-                        }
+    val.set_locked(point{ 4, 5, 6 });
+    val.execute_with_shared_lock([](const point &pt)
+    {
+        ASSERT_EQ(4, pt.x);
+        ASSERT_EQ(5, pt.y);
+        ASSERT_EQ(6, pt.z);
+    });
 
-                        val.set_unlocked(thread_vals[index]);
-                    });
-                }
+    val.execute_with_lock([](point &pt, std::lock_guard<dhorn::experimental::seqlock> &)
+    {
+        ++pt.x;
+    });
+    ASSERT_EQ(5, val.copy_shared_locked().x);
+
+    // Like the primary template, the lock type is customizable
+    val.execute_with_lock<std::unique_lock<dhorn::experimental::seqlock>>([](
+        point &pt,
+        std::unique_lock<dhorn::experimental::seqlock> &lock)
+    {
+        ASSERT_TRUE(lock.owns_lock());
+        ++pt.y;
+    });
+    ASSERT_EQ(6, val.copy_shared_locked().y);
+}
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+TEST(SynchronizedObjectTests, SeqlockConcurrentTest)
+{
+    struct triple
+    {
+        std::size_t a;
+        std::size_t b;
+        std::size_t c;
+    };
+
+    dhorn::experimental::synchronized_object<triple, dhorn::experimental::seqlock> val;
+    std::vector<std::thread> threads;
+
+    static const std::size_t num_writers = 4;
+    static const std::size_t num_readers = 8;
+    static const std::size_t num_iterations = 10000;
 
-                bool pass = false;
-                val.execute_without_lock([&](array_type &arr)
+    for (std::size_t i = 0; i < num_writers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                val.execute_with_lock([](triple &value, const auto &)
                 {
-                    for (auto value : arr)
-                    {
-                        // The access to val was not thread safe; at least one should have screwed up. This technically
-                        // can fail unexpectedly, especially if the last thread is lagging behind significantly, but
-                        // it's highly unlikely
-                        if (value != 1)
-                        {
-                            pass = true;
-                            break;
-                        }
-                    }
+                    ++value.a;
+                    value.b = value.a * 2;
+                    value.c = value.a * 3;
                 });
-
-                ASSERT_TRUE(true);
             }
+        });
+    }
 
-            TEST_METHOD(LockNormalTest)
+    for (std::size_t i = 0; i < num_readers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t j = 0; j < num_iterations; ++j)
             {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::vector<std::thread> threads;
+                // Readers should never observe a partially written value
+                auto value = val.copy_shared_locked();
+                ASSERT_EQ(value.a * 2, value.b);
+                ASSERT_EQ(value.a * 3, value.c);
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
 
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
+    ASSERT_EQ(num_writers * num_iterations, val.copy_locked().a);
+}
 
-                for (std::size_t i = 0; i < num_threads; ++i)
-                {
-                    threads.emplace_back([&]()
-                    {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            auto lock = val.lock();
-                            val.set_unlocked(val.copy_unlocked() + 1);
-                        }
-                    });
-                }
+TEST(SynchronizedObjectTests, SeqlockTornReadTest)
+{
+    // Large enough to span many words, so that a reader racing with a writer can easily see a mix of old and new
+    struct block
+    {
+        std::size_t values[128];
+    };
 
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
+    static const std::size_t num_writers = 4;
+    static const std::size_t num_readers = 8;
+    static const std::size_t num_iterations = 20000;
 
-                ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
-            }
+    dhorn::experimental::synchronized_object<block, dhorn::experimental::seqlock> val;
+    std::atomic_size_t runningReaders{ 0 };
+    std::atomic_size_t runningWriters{ num_writers };
+    std::atomic_size_t failures{ 0 };
+    std::atomic_size_t reads{ 0 };
+    std::vector<std::thread> threads;
 
-            TEST_METHOD(TryToLockTest)
+    for (std::size_t i = 0; i < num_writers; ++i)
+    {
+        threads.emplace_back([&, i]()
+        {
+            // Don't let the writers finish before the readers even get started
+            while (runningReaders.load() != num_readers)
             {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::vector<std::thread> threads;
-
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
+                std::this_thread::yield();
+            }
 
-                for (std::size_t i = 0; i < num_threads; ++i)
+            for (std::size_t j = 0; j < num_iterations; ++j)
+            {
+                if ((i + j) % 2)
                 {
-                    threads.emplace_back([&]()
+                    block value;
+                    std::fill(std::begin(value.values), std::end(value.values), i * num_iterations + j);
+                    val.set_locked(value);
+                }
+                else
+                {
+                    val.execute_with_lock([](block &value, const auto &)
                     {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
+                        for (auto &entry : value.values)
                         {
-                            auto lock = val.lock(std::try_to_lock);
-                            if (lock.owns_lock())
-                            {
-                                val.set_unlocked(val.copy_unlocked() + 1);
-                            }
+                            ++entry;
                         }
                     });
                 }
-
-                for (auto &thread : threads)
-                {
-                    thread.join();
-                }
-
-                // At least one attempt to get the lock should have failed, but at least one should have succeeded
-                ASSERT_NE(static_cast<std::size_t>(0), val.copy_unlocked());
-                ASSERT_NE(num_threads * num_iterations, val.copy_unlocked());
             }
 
-            TEST_METHOD(DeferLockTest)
-            {
-                dhorn::experimental::synchronized_object<std::size_t> val = 0;
-                std::vector<std::thread> threads;
-
-                static const std::size_t num_threads = 12;
-                static const std::size_t num_iterations = 10000;
+            --runningWriters;
+        });
+    }
 
-                for (std::size_t i = 0; i < num_threads; ++i)
+    for (std::size_t i = 0; i < num_readers; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            ++runningReaders;
+            while (runningWriters.load() > 0)
+            {
+                // Readers must only ever see values that some writer published in full
+                auto value = val.copy_shared_locked();
+                ++reads;
+                for (auto entry : value.values)
                 {
-                    threads.emplace_back([&]()
+                    if (entry != value.values[0])
                     {
-                        for (std::size_t j = 0; j < num_iterations; ++j)
-                        {
-                            auto lock = val.lock(std::defer_lock);
-                            lock.lock(); // Shouldn't deadlock
-                            val.set_unlocked(val.copy_unlocked() + 1);
-                        }
-                    });
-                }
-
-                for (auto &thread : threads)
-                {
-                    thread.join();
+                        ++failures;
+                        break;
+                    }
                 }
 
-                ASSERT_EQ(num_threads * num_iterations, val.copy_unlocked());
+                std::this_thread::yield();
             }
-        };
+        });
     }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(0u, failures.load());
+    ASSERT_NE(0u, reads.load());
 }
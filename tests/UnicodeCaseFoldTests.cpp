@@ -0,0 +1,142 @@
+/*
+ * Duncan Horn
+ *
+ * UnicodeCaseFoldTests.cpp
+ *
+ * Tests for the unicode/case_fold.h functions
+ */
+
+#include <dhorn/unicode/case_fold.h>
+#include <dhorn/unicode/iterator.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace dhorn::unicode;
+
+TEST(UnicodeCaseFoldTests, AsciiTest)
+{
+    for (char32_t ch = 0; ch < 0x80; ++ch)
+    {
+        auto expect = ((ch >= U'A') && (ch <= U'Z')) ? (ch - U'A' + U'a') : ch;
+        ASSERT_EQ(expect, case_fold(ch));
+    }
+}
+
+TEST(UnicodeCaseFoldTests, NonAsciiTest)
+{
+    std::pair<char32_t, char32_t> values[] =
+    {
+        { U'À', U'à' }, // LATIN CAPITAL LETTER A WITH GRAVE
+        { U'×', U'×' }, // MULTIPLICATION SIGN
+        { U'ß', U'ß' }, // LATIN SMALL LETTER SHARP S; only has a full case folding
+        { U'µ', U'μ' }, // MICRO SIGN
+        { U'Ā', U'ā' }, // LATIN CAPITAL LETTER A WITH MACRON
+        { U'ā', U'ā' }, // LATIN SMALL LETTER A WITH MACRON
+        { U'İ', U'İ' }, // LATIN CAPITAL LETTER I WITH DOT ABOVE; Turkic/full only
+        { U'Ĺ', U'ĺ' }, // LATIN CAPITAL LETTER L WITH ACUTE
+        { U'ſ', U's' }, // LATIN SMALL LETTER LONG S
+        { U'Α', U'α' }, // GREEK CAPITAL LETTER ALPHA
+        { U'Σ', U'σ' }, // GREEK CAPITAL LETTER SIGMA
+        { U'ς', U'σ' }, // GREEK SMALL LETTER FINAL SIGMA
+        { U'А', U'а' }, // CYRILLIC CAPITAL LETTER A
+        { U'Ё', U'ё' }, // CYRILLIC CAPITAL LETTER IO
+        { U'Ա', U'ա' }, // ARMENIAN CAPITAL LETTER AYB
+        { U'Ⴀ', U'ⴀ' }, // GEORGIAN CAPITAL LETTER AN
+        { U'ᏸ', U'Ᏸ' }, // CHEROKEE SMALL LETTER YE
+        { U'ẞ', U'ß' }, // LATIN CAPITAL LETTER SHARP S
+        { U'ᾈ', U'ᾀ' }, // GREEK CAPITAL LETTER ALPHA WITH PSILI AND PROSGEGRAMMENI
+        { U'K', U'k' }, // KELVIN SIGN
+        { U'Ⅰ', U'ⅰ' }, // ROMAN NUMERAL ONE
+        { U'Ⓐ', U'ⓐ' }, // CIRCLED LATIN CAPITAL LETTER A
+        { U'Ɪ', U'ɪ' }, // LATIN CAPITAL LETTER SMALL CAPITAL I
+        { U'ꭰ', U'Ꭰ' }, // CHEROKEE SMALL LETTER A
+        { U'Ａ', U'ａ' }, // FULLWIDTH LATIN CAPITAL LETTER A
+        { U'ａ', U'ａ' }, // FULLWIDTH LATIN SMALL LETTER A
+        { U'中', U'中' }, // CJK UNIFIED IDEOGRAPH-4E2D
+        { U'\U00010400', U'\U00010400' }, // DESERET CAPITAL LETTER LONG I; outside the BMP
+    };
+
+    for (auto [ch, expect] : values)
+    {
+        ASSERT_EQ(expect, case_fold(ch));
+    }
+}
+
+TEST(UnicodeCaseFoldTests, IdempotentTest)
+{
+    for (char32_t ch = 0; ch < 0x1'0000; ++ch)
+    {
+        auto folded = case_fold(ch);
+        ASSERT_EQ(folded, case_fold(folded));
+    }
+}
+
+TEST(UnicodeCaseFoldTests, CaseFoldRangeTest)
+{
+    std::u32string str = U"Hello Γειά МИР";
+    std::u32string result;
+    case_fold(str.begin(), str.end(), std::back_inserter(result));
+    ASSERT_EQ(U"hello γειά мир", result);
+}
+
+template <typename LhsStringTy, typename RhsStringTy>
+static int do_compare(const LhsStringTy& lhs, const RhsStringTy& rhs)
+{
+    return icompare(
+        iterator(lhs.data()), iterator(lhs.data() + lhs.size()),
+        iterator(rhs.data()), iterator(rhs.data() + rhs.size()));
+}
+
+template <typename LhsStringTy, typename RhsStringTy>
+static bool do_equals(const LhsStringTy& lhs, const RhsStringTy& rhs)
+{
+    return iequals(
+        iterator(lhs.data()), iterator(lhs.data() + lhs.size()),
+        iterator(rhs.data()), iterator(rhs.data() + rhs.size()));
+}
+
+template <typename LhsStringTy, typename RhsStringTy>
+static bool do_starts_with(const LhsStringTy& lhs, const RhsStringTy& rhs)
+{
+    return istarts_with(
+        iterator(lhs.data()), iterator(lhs.data() + lhs.size()),
+        iterator(rhs.data()), iterator(rhs.data() + rhs.size()));
+}
+
+TEST(UnicodeCaseFoldTests, EqualsTest)
+{
+    std::string upper = u8"ΓΕΙΆ ΣΟΥ KÓSME";
+    std::string lower = u8"γειά σου kósme";
+    std::u16string upper16 = u"ΓΕΙΆ ΣΟΥ KÓSME";
+
+    ASSERT_TRUE(do_equals(upper, lower));
+    ASSERT_TRUE(do_equals(lower, upper));
+    ASSERT_TRUE(do_equals(upper16, lower));
+    ASSERT_TRUE(do_equals(std::string(), std::string()));
+
+    ASSERT_FALSE(do_equals(upper, lower.substr(0, lower.size() - 1)));
+    ASSERT_FALSE(do_equals(upper.substr(0, upper.size() - 1), lower));
+    ASSERT_FALSE(do_equals(std::string(u8"ß"), std::string("ss")));
+}
+
+TEST(UnicodeCaseFoldTests, CompareTest)
+{
+    ASSERT_EQ(0, do_compare(std::string(u8"АБВ"), std::string(u8"абв")));
+    ASSERT_GT(0, do_compare(std::string(u8"АБ"), std::string(u8"абв")));
+    ASSERT_LT(0, do_compare(std::string(u8"АБВ"), std::string(u8"аб")));
+    ASSERT_GT(0, do_compare(std::string(u8"АБВ"), std::string(u8"абг")));
+    ASSERT_LT(0, do_compare(std::string(u8"АБГ"), std::string(u8"абв")));
+
+    // Comparison is done on the folded values, so '_' comes before 'Z', even though 'Z' < '_' < 'z'
+    ASSERT_GT(0, do_compare(std::string("_"), std::string("Z")));
+}
+
+TEST(UnicodeCaseFoldTests, StartsWithTest)
+{
+    std::u16string str = u"СЛОВО дня";
+    ASSERT_TRUE(do_starts_with(str, std::u16string(u"слово")));
+    ASSERT_TRUE(do_starts_with(str, std::string(u8"слово Д")));
+    ASSERT_TRUE(do_starts_with(str, std::u16string()));
+    ASSERT_FALSE(do_starts_with(str, std::u16string(u"слова")));
+    ASSERT_FALSE(do_starts_with(std::u16string(u"С"), str));
+}
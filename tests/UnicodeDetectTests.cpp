@@ -0,0 +1,212 @@
+/*
+ * Duncan Horn
+ *
+ * UnicodeDetectTests.cpp
+ *
+ * Tests for the unicode/detect.h functions
+ */
+
+#include <dhorn/unicode/detect.h>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+
+using namespace dhorn::unicode;
+
+template <encoding Encoding>
+static std::string encode_bytes(const std::u32string& str, bool includeByteOrderMark = false)
+{
+    using traits = encoding_traits<Encoding>;
+    using value_type = typename traits::value_type;
+
+    std::basic_string<value_type> codeUnits;
+    for (auto ch : str)
+    {
+        traits::write(std::back_inserter(codeUnits), ch);
+    }
+
+    std::string result;
+    if (includeByteOrderMark)
+    {
+        result.assign(std::begin(traits::byte_order_mark), std::end(traits::byte_order_mark));
+    }
+
+    result.append(reinterpret_cast<const char*>(codeUnits.data()), codeUnits.size() * sizeof(value_type));
+    return result;
+}
+
+static std::optional<detected_encoding> detect(const std::string& str, std::size_t prefixLength = 4096)
+{
+    return detect_encoding(str.data(), str.data() + str.size(), prefixLength);
+}
+
+static std::optional<encoding> encoding_of(const std::string& str, std::size_t prefixLength = 4096)
+{
+    if (auto result = detect(str, prefixLength))
+    {
+        return result->encoding;
+    }
+
+    return std::nullopt;
+}
+
+static const std::u32string english = U"The quick brown fox jumps over the lazy dog. ";
+static const std::u32string mixed = U"Grüße, 你好 \U0001F600! café naïve αβγ ";
+static const std::u32string cjk = U"日本語のテキスト。中文";
+
+template <encoding Encoding>
+static void DoRoundTripTest(const std::u32string& str)
+{
+    auto bytes = encode_bytes<Encoding>(str);
+    auto result = detect(bytes);
+    ASSERT_TRUE(result.has_value());
+    auto [encoding, offset] = *result;
+    ASSERT_EQ(Encoding, encoding);
+    ASSERT_EQ(0u, offset);
+
+    bytes = encode_bytes<Encoding>(str, true);
+    result = detect(bytes);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(Encoding, result->encoding);
+    ASSERT_EQ(std::size(encoding_traits<Encoding>::byte_order_mark), result->offset);
+}
+
+TEST(UnicodeDetectTests, ByteOrderMarkTest)
+{
+    DoRoundTripTest<encoding::utf_8>(U"");
+    DoRoundTripTest<encoding::utf_8>(english);
+
+    // With only a byte order mark, there's nothing else to go on
+    ASSERT_EQ(encoding::utf_16le, encoding_of(encode_bytes<encoding::utf_16le>(U"", true)));
+    ASSERT_EQ(encoding::utf_16be, encoding_of(encode_bytes<encoding::utf_16be>(U"", true)));
+    ASSERT_EQ(encoding::utf_32le, encoding_of(encode_bytes<encoding::utf_32le>(U"", true)));
+    ASSERT_EQ(encoding::utf_32be, encoding_of(encode_bytes<encoding::utf_32be>(U"", true)));
+
+    // The UTF-16LE byte order mark followed by a null character is indistinguishable from the UTF-32LE byte order mark
+    ASSERT_EQ(encoding::utf_16le, encoding_of(encode_bytes<encoding::utf_16le>(U"a", true)));
+    ASSERT_EQ(encoding::utf_32le, encoding_of(encode_bytes<encoding::utf_16le>(std::u32string(1, 0), true)));
+}
+
+TEST(UnicodeDetectTests, Utf8Test)
+{
+    DoRoundTripTest<encoding::utf_8>(english);
+    DoRoundTripTest<encoding::utf_8>(mixed);
+    DoRoundTripTest<encoding::utf_8>(cjk);
+}
+
+TEST(UnicodeDetectTests, Utf16Test)
+{
+    DoRoundTripTest<encoding::utf_16le>(english);
+    DoRoundTripTest<encoding::utf_16le>(mixed);
+    DoRoundTripTest<encoding::utf_16be>(english);
+    DoRoundTripTest<encoding::utf_16be>(mixed);
+}
+
+TEST(UnicodeDetectTests, Utf32Test)
+{
+    DoRoundTripTest<encoding::utf_32le>(english);
+    DoRoundTripTest<encoding::utf_32le>(mixed);
+    DoRoundTripTest<encoding::utf_32le>(cjk);
+    DoRoundTripTest<encoding::utf_32be>(english);
+    DoRoundTripTest<encoding::utf_32be>(mixed);
+    DoRoundTripTest<encoding::utf_32be>(cjk);
+}
+
+TEST(UnicodeDetectTests, LongInputTest)
+{
+    // Long enough to exercise the vectorized zero counting, with the prefix ending in the middle of a code point
+    std::u32string str;
+    while (str.size() < 5000)
+    {
+        str += mixed;
+    }
+
+    DoRoundTripTest<encoding::utf_8>(str);
+    DoRoundTripTest<encoding::utf_16le>(str);
+    DoRoundTripTest<encoding::utf_16be>(str);
+    DoRoundTripTest<encoding::utf_32le>(str);
+    DoRoundTripTest<encoding::utf_32be>(str);
+
+    for (std::size_t prefixLength = 1; prefixLength < 64; ++prefixLength)
+    {
+        ASSERT_EQ(encoding::utf_8, encoding_of(encode_bytes<encoding::utf_8>(str), prefixLength));
+        ASSERT_EQ(encoding::utf_16le, encoding_of(encode_bytes<encoding::utf_16le>(str), prefixLength + 1));
+        ASSERT_EQ(encoding::utf_16be, encoding_of(encode_bytes<encoding::utf_16be>(str), prefixLength + 1));
+        ASSERT_EQ(encoding::utf_32le, encoding_of(encode_bytes<encoding::utf_32le>(str), prefixLength + 3));
+        ASSERT_EQ(encoding::utf_32be, encoding_of(encode_bytes<encoding::utf_32be>(str), prefixLength + 3));
+    }
+}
+
+TEST(UnicodeDetectTests, CjkUtf16Test)
+{
+    // Without a byte order mark, there are no zero bytes to go on, but the text isn't valid UTF-8
+    DoRoundTripTest<encoding::utf_16le>(cjk);
+    DoRoundTripTest<encoding::utf_16be>(cjk);
+
+    std::u32string str;
+    while (str.size() < 5000)
+    {
+        str += cjk;
+    }
+
+    DoRoundTripTest<encoding::utf_16le>(str);
+    DoRoundTripTest<encoding::utf_16be>(str);
+    ASSERT_EQ(encoding::utf_16le, encoding_of(encode_bytes<encoding::utf_16le>(str), 101));
+    ASSERT_EQ(encoding::utf_16be, encoding_of(encode_bytes<encoding::utf_16be>(str), 101));
+}
+
+TEST(UnicodeDetectTests, ShortInputTest)
+{
+    ASSERT_EQ(encoding::utf_8, encoding_of(""));
+    ASSERT_EQ(encoding::utf_8, encoding_of("a"));
+    ASSERT_EQ(encoding::utf_8, encoding_of(std::string(1, '\0')));
+    ASSERT_EQ(encoding::utf_8, encoding_of("\xC3"));
+    ASSERT_FALSE(encoding_of("\xFF").has_value());
+    ASSERT_FALSE(encoding_of("\x80").has_value());
+
+    // Two bytes is enough for a UTF-16 code unit
+    ASSERT_EQ(encoding::utf_16le, encoding_of(std::string("a\0", 2)));
+    ASSERT_EQ(encoding::utf_16be, encoding_of(std::string("\0a", 2)));
+    ASSERT_EQ(encoding::utf_16le, encoding_of(encode_bytes<encoding::utf_16le>(U"日")));
+}
+
+TEST(UnicodeDetectTests, InvalidInputTest)
+{
+    // An odd number of bytes can't be UTF-16 and invalid UTF-8 isn't UTF-8
+    ASSERT_FALSE(encoding_of("\xFF\xFF\xFF").has_value());
+    ASSERT_FALSE(encoding_of("\xC0\xAF\x80").has_value());
+
+    // Unless the odd byte is the result of the prefix cutting off the last code unit
+    ASSERT_EQ(encoding::utf_16le, encoding_of("\xFF\xFF\xFF", 2));
+
+    // Unpaired surrogates in both byte orders
+    ASSERT_FALSE(encoding_of("\xDC\xDC\xDC\xDC").has_value());
+    ASSERT_FALSE(encoding_of("\xD8\xDC\xD8\xDC").has_value());
+}
+
+TEST(UnicodeDetectTests, FallbackTest)
+{
+    // Binary data with zero bytes in no particular pattern isn't valid in any of the encodings
+    std::string binary;
+    for (int i = 0; i < 1024; ++i)
+    {
+        binary.push_back(static_cast<char>((i * 7919) % 251));
+    }
+
+    ASSERT_FALSE(encoding_of(binary).has_value());
+
+    // Unpaired surrogates rule out UTF-16LE and the zero bytes rule out UTF-16BE
+    auto bytes = encode_bytes<encoding::utf_16le>(english);
+    bytes[1] = '\xDC';
+    ASSERT_FALSE(encoding_of(bytes).has_value());
+
+    // Values above U+10FFFF rule out UTF-32
+    bytes = encode_bytes<encoding::utf_32be>(english);
+    bytes[1] = '\x11';
+    ASSERT_NE(encoding::utf_32be, encoding_of(bytes));
+
+    // A lone null character isn't enough to call it UTF-16
+    bytes = encode_bytes<encoding::utf_8>(english);
+    bytes[5] = '\0';
+    ASSERT_EQ(encoding::utf_8, encoding_of(bytes));
+}
@@ -9,6 +9,11 @@
 #include <dhorn/unicode/encoding.h>
 #include <dhorn/utility.h>
 #include <gtest/gtest.h>
+#include <list>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
 
 using namespace dhorn::literals;
 
@@ -344,6 +349,221 @@ TEST_F(Utf8EncodingTraitsTests, LengthTest)
     DoLengthTest<checked_traits>("\xED\xBF\xBF", dhorn::unicode::npos);
 }
 
+template <typename Validate>
+void DoValidateTest(Validate&& validate)
+{
+    // Valid strings should validate in their entirety, regardless of how they line up with SIMD block boundaries
+    const std::string validSequences[] =
+    {
+        "a", u8"\u0080", u8"\u07FF", u8"\u0800", u8"\uD7FF", u8"\uE000", u8"\uFFFF", u8"\U00010000", u8"\U0010FFFF"
+    };
+
+    for (auto& seq : validSequences)
+    {
+        for (std::size_t prefix = 0; prefix < 70; ++prefix)
+        {
+            auto str = std::string(prefix, 'x') + seq + std::string(prefix % 7, 'y') + seq;
+            ASSERT_EQ(str.data() + str.size(), validate(str.data(), str.data() + str.size()));
+        }
+    }
+
+    // Invalid sequences should report the position of the start of the sequence
+    const std::string invalidSequences[] =
+    {
+        "\x80",                // Continuation without a lead
+        "\xBF",
+        "\xC0\x80",            // Overlong encodings
+        "\xC1\xBF",
+        "\xE0\x80\x80",
+        "\xE0\x9F\xBF",
+        "\xF0\x80\x80\x80",
+        "\xF0\x8F\xBF\xBF",
+        "\xED\xA0\x80",        // Surrogates
+        "\xED\xBF\xBF",
+        "\xF4\x90\x80\x80",    // Larger than U+10FFFF
+        "\xF5\x80\x80\x80",
+        "\xF8\x88\x80\x80\x80",
+        "\xFF",
+        "\xC2\x41",            // Missing continuation bytes
+        "\xE1\x80\x41",
+        "\xF1\x80\x80\x41",
+        "\xC2\xC2\x80",
+    };
+
+    for (auto& seq : invalidSequences)
+    {
+        for (std::size_t prefix = 0; prefix < 70; ++prefix)
+        {
+            auto str = std::string(prefix, 'x') + seq + std::string(70, 'z');
+            ASSERT_EQ(str.data() + prefix, validate(str.data(), str.data() + str.size())) << prefix;
+
+            str = std::string(prefix, 'x') + u8"\u00FF" + seq + u8"\U0010FFFF";
+            ASSERT_EQ(str.data() + prefix + 2, validate(str.data(), str.data() + str.size())) << prefix;
+        }
+    }
+
+    // Sequences truncated by the end of the input
+    const std::string truncatedSequences[] = { "\xC2", "\xE1", "\xE1\x80", "\xF1", "\xF1\x80", "\xF1\x80\x80" };
+    for (auto& seq : truncatedSequences)
+    {
+        for (std::size_t prefix = 0; prefix < 70; ++prefix)
+        {
+            auto str = std::string(prefix, 'x') + seq;
+            ASSERT_EQ(str.data() + prefix, validate(str.data(), str.data() + str.size())) << prefix;
+        }
+    }
+}
+
+template <typename Validate>
+void DoRandomValidateTest(Validate&& validate)
+{
+    // Compare against the scalar implementation using random strings built from a mix of valid and invalid sequences
+    const std::string pieces[] =
+    {
+        "a", "abcdefghijklmnopqrstuvwxyz", u8"\u00E9", u8"\u4E2D", u8"\U0001F600", u8"\U0010FFFF",
+        "\x80", "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE1\x80", "\xF1",
+    };
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> pieceDist(0, std::size(pieces) - 1);
+    std::uniform_int_distribution<std::size_t> lengthDist(0, 200);
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::string str;
+        auto length = lengthDist(rng);
+        while (str.size() < length)
+        {
+            // Bias heavily towards valid text so that errors show up at all offsets
+            auto index = pieceDist(rng);
+            str += pieces[((index >= 6) && (rng() % 8)) ? (index - 6) : index];
+        }
+
+        auto begin = str.data();
+        auto end = str.data() + str.size();
+        ASSERT_EQ(dhorn::unicode::details::utf8_validate_scalar(begin, end), validate(begin, end));
+    }
+}
+
+TEST_F(Utf8EncodingTraitsTests, ValidateTest)
+{
+    DoValidateTest([](const char* begin, const char* end) { return checked_traits::validate(begin, end); });
+    DoValidateTest([](const char* begin, const char* end)
+    {
+        return dhorn::unicode::details::utf8_validate_scalar(begin, end);
+    });
+
+    // Non-contiguous iterators should give the same result
+    std::string str = std::string("foo") + "\xE0\x80\x80" + "bar";
+    std::list<char> list(str.begin(), str.end());
+    auto itr = traits::validate(list.begin(), list.end());
+    ASSERT_EQ(3_sz, static_cast<std::size_t>(std::distance(list.begin(), itr)));
+
+    DoRandomValidateTest([](const char* begin, const char* end) { return checked_traits::validate(begin, end); });
+}
+
+#if DHORN_X86
+TEST_F(Utf8EncodingTraitsTests, ValidateKernelTest)
+{
+    // Test the vectorized kernels directly since validate will only ever use one of them
+    auto& features = dhorn::cpu_features::get();
+    if (features.sse2)
+    {
+        DoValidateTest(dhorn::unicode::details::utf8_validate_sse2);
+        DoRandomValidateTest(dhorn::unicode::details::utf8_validate_sse2);
+    }
+
+    if (features.avx2)
+    {
+        DoValidateTest(dhorn::unicode::details::utf8_validate_avx2);
+        DoRandomValidateTest(dhorn::unicode::details::utf8_validate_avx2);
+    }
+}
+#endif
+
+template <typename Traits, typename CheckedTraits, typename CharTy>
+void DoLongLengthTest(const std::basic_string<CharTy>& str)
+{
+    // The vectorized implementations are only used for unchecked traits, so compare against checked traits
+    auto expected = CheckedTraits::length(str.c_str());
+    ASSERT_NE(dhorn::unicode::npos, expected.code_points);
+
+    auto result = Traits::length(str.c_str());
+    ASSERT_EQ(expected.code_points, result.code_points);
+    ASSERT_EQ(expected.code_units, result.code_units);
+
+    // Range versions should give the same result
+    result = Traits::length(str.data(), str.data() + str.size());
+    ASSERT_EQ(expected.code_points, result.code_points);
+    ASSERT_EQ(expected.code_units, result.code_units);
+
+    result = CheckedTraits::length(str.data(), str.data() + str.size());
+    ASSERT_EQ(expected.code_points, result.code_points);
+    ASSERT_EQ(expected.code_units, result.code_units);
+}
+
+template <typename Traits, typename CheckedTraits>
+void DoRandomLengthTest()
+{
+    // Long enough that the vectorized implementations need to flush their counters at least once
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<char32_t> dist(0x01, 0x10'FFFF);
+    for (std::size_t length : { 0, 1, 7, 8, 15, 16, 17, 100, 5000, 300000 })
+    {
+        std::basic_string<typename Traits::value_type> str;
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            auto ch = ((rng() % 4) == 0) ? dist(rng) : static_cast<char32_t>(rng() % 0x80 + 1);
+            if (dhorn::unicode::is_valid_code_point(ch))
+            {
+                CheckedTraits::write(std::back_inserter(str), ch);
+            }
+        }
+
+        DoLongLengthTest<Traits, CheckedTraits>(str);
+    }
+}
+
+TEST_F(Utf8EncodingTraitsTests, LongLengthTest)
+{
+    DoRandomLengthTest<traits, checked_traits>();
+}
+
+template <typename Traits, typename CheckedTraits, typename Itr>
+void DoTruncatedRangeTest(Itr begin, Itr end, std::size_t validCodePoints, std::size_t validCodeUnits)
+{
+    // The range ends with a truncated code point. Unchecked traits count it as a code point, checked traits don't
+    auto result = Traits::length(begin, end);
+    ASSERT_EQ(validCodePoints + 1, result.code_points);
+    ASSERT_EQ(static_cast<std::size_t>(std::distance(begin, end)), result.code_units);
+
+    result = CheckedTraits::length(begin, end);
+    ASSERT_EQ(dhorn::unicode::npos, result.code_points);
+    ASSERT_EQ(validCodeUnits, result.code_units);
+
+    auto truncated = std::next(begin, validCodeUnits);
+    ASSERT_TRUE(truncated == CheckedTraits::validate(begin, end));
+
+    // Reading the truncated code point should fail without reading past the end, and advancing should stop at the end
+    auto [ch, pos] = Traits::read(truncated, end);
+    ASSERT_EQ(dhorn::unicode::eof, ch);
+    ASSERT_TRUE(pos == truncated);
+    ASSERT_TRUE(Traits::next(truncated, end) == end);
+
+    std::tie(ch, pos) = Traits::read(begin, end);
+    ASSERT_NE(dhorn::unicode::eof, ch);
+    ASSERT_TRUE(pos == Traits::next(begin, end));
+}
+
+TEST_F(Utf8EncodingTraitsTests, RangeTest)
+{
+    // NOTE: Not null terminated
+    const char str[] = { 'f', 'o', 'o', '\xE2', '\x82' };
+    DoTruncatedRangeTest<traits, checked_traits>(std::begin(str), std::end(str), 3, 3);
+
+    std::list<char> list(std::begin(str), std::end(str));
+    DoTruncatedRangeTest<traits, checked_traits>(list.begin(), list.end(), 3, 3);
+}
+
 struct Utf16EncodingTraitsTests : testing::Test
 {
     using traits = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_16>;
@@ -528,6 +748,63 @@ TEST_F(Utf16EncodingTraitsTests, LengthTest)
     DoLengthTest<checked_be_traits>(u"\x00D8\xFFDB", dhorn::unicode::npos);
 }
 
+TEST_F(Utf16EncodingTraitsTests, LongLengthTest)
+{
+    DoRandomLengthTest<le_traits, checked_le_traits>();
+    DoRandomLengthTest<be_traits, checked_be_traits>();
+}
+
+TEST_F(Utf16EncodingTraitsTests, RangeTest)
+{
+    const char16_t str[] = { u'f', u'\u00FF', u'\xD83D', u'\xDE00', u'\xD83D' };
+    DoTruncatedRangeTest<traits, checked_traits>(std::begin(str), std::end(str), 3, 4);
+
+    std::list<char16_t> list(std::begin(str), std::end(str));
+    DoTruncatedRangeTest<traits, checked_traits>(list.begin(), list.end(), 3, 4);
+}
+
+template <typename Traits, typename CharTy>
+void DoRandomRangeValidateTest(const std::vector<CharTy>& units)
+{
+    // Compare the vectorized implementation (used for pointers) against the generic one (used for everything else)
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> unitDist(0, units.size() - 1);
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::basic_string<CharTy> str;
+        auto length = rng() % 100;
+        while (str.size() < length)
+        {
+            // Mostly ASCII so that the errors show up at all offsets
+            str.push_back(((rng() % 16) == 0) ? units[unitDist(rng)] : static_cast<CharTy>(u'a' + rng() % 26));
+        }
+
+        std::list<CharTy> list(str.begin(), str.end());
+        auto expected = std::distance(list.begin(), Traits::validate(list.begin(), list.end()));
+        ASSERT_EQ(expected, Traits::validate(str.data(), str.data() + str.size()) - str.data());
+    }
+}
+
+TEST_F(Utf16EncodingTraitsTests, ValidateTest)
+{
+    const std::u16string invalidSequences[] = { u"\xDC00", u"\xDFFF", u"\xD800", u"\xD800\xD800", u"\xDBFF\x0041" };
+    for (auto& seq : invalidSequences)
+    {
+        for (std::size_t prefix = 0; prefix < 20; ++prefix)
+        {
+            auto str = std::u16string(prefix, u'x') + seq + std::u16string(20, u'z');
+            ASSERT_EQ(str.data() + prefix, traits::validate(str.data(), str.data() + str.size())) << prefix;
+            ASSERT_EQ(str.data() + prefix, checked_traits::validate(str.data(), str.data() + str.size())) << prefix;
+        }
+    }
+
+    std::u16string valid = u"foo\u00FF\U0001F600\U0010FFFF";
+    ASSERT_EQ(valid.data() + valid.size(), traits::validate(valid.data(), valid.data() + valid.size()));
+
+    DoRandomRangeValidateTest<le_traits, char16_t>({ 0x00FF, 0xD7FF, 0xD800, 0xDBFF, 0xDC00, 0xDFFF, 0xE000 });
+    DoRandomRangeValidateTest<be_traits, char16_t>({ 0xFF00, 0xFFD7, 0x00D8, 0xFFDB, 0x00DC, 0xFFDF, 0x00E0 });
+}
+
 struct Utf32EncodingTraitsTests : testing::Test
 {
     using traits = dhorn::unicode::encoding_traits<dhorn::unicode::encoding::utf_32>;
@@ -667,3 +944,40 @@ TEST_F(Utf32EncodingTraitsTests, LengthTest)
     DoLengthTest<checked_le_traits>(U"\x00110000", dhorn::unicode::npos);
     DoLengthTest<checked_be_traits>(U"\x00001100", dhorn::unicode::npos);
 }
+
+TEST_F(Utf32EncodingTraitsTests, RangeTest)
+{
+    // UTF-32 code points can't be truncated, so the range versions are the same as the null terminated versions
+    const char32_t str[] = { U'f', U'\U0010FFFF', 0x0000'D800, U'o' };
+    auto result = traits::length(std::begin(str), std::end(str));
+    ASSERT_EQ(4_sz, result.code_points);
+    ASSERT_EQ(4_sz, result.code_units);
+
+    result = checked_traits::length(std::begin(str), std::end(str));
+    ASSERT_EQ(dhorn::unicode::npos, result.code_points);
+    ASSERT_EQ(2_sz, result.code_units);
+
+    auto [ch, pos] = traits::read(str + 1, std::end(str));
+    ASSERT_EQ(U'\U0010FFFF', ch);
+    ASSERT_EQ(str + 2, pos);
+}
+
+TEST_F(Utf32EncodingTraitsTests, ValidateTest)
+{
+    const char32_t invalidCodePoints[] = { 0x0000'D800, 0x0000'DFFF, 0x0011'0000, 0x8000'0000, 0xFFFF'FFFF };
+    for (auto ch : invalidCodePoints)
+    {
+        for (std::size_t prefix = 0; prefix < 20; ++prefix)
+        {
+            auto str = std::u32string(prefix, U'x') + ch + std::u32string(20, U'z');
+            ASSERT_EQ(str.data() + prefix, traits::validate(str.data(), str.data() + str.size())) << prefix;
+            ASSERT_EQ(str.data() + prefix, checked_traits::validate(str.data(), str.data() + str.size())) << prefix;
+        }
+    }
+
+    std::u32string valid = U"fooÿ\U0001F600\U0010FFFF";
+    ASSERT_EQ(valid.data() + valid.size(), traits::validate(valid.data(), valid.data() + valid.size()));
+
+    DoRandomRangeValidateTest<le_traits, char32_t>({ 0x0000'D7FF, 0x0000'D800, 0x0000'DFFF, 0x0010'FFFF, 0x0011'0000 });
+    DoRandomRangeValidateTest<be_traits, char32_t>({ 0xFFD7'0000, 0x00D8'0000, 0xFFDF'0000, 0xFFFF'1000, 0x0000'1100 });
+}
@@ -0,0 +1,141 @@
+/*
+ * Duncan Horn
+ *
+ * UnicodeIndexTests.cpp
+ *
+ * Tests for the unicode/index.h types
+ */
+
+#include <dhorn/unicode/index.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+using namespace dhorn::unicode;
+
+template <encoding Encoding>
+using code_unit_t = typename encoding_traits<Encoding>::value_type;
+
+template <encoding Encoding>
+static std::basic_string<code_unit_t<Encoding>> encode(const std::u32string& str)
+{
+    std::basic_string<code_unit_t<Encoding>> result;
+    for (auto ch : str)
+    {
+        encoding_traits<Encoding>::write(std::back_inserter(result), ch);
+    }
+
+    return result;
+}
+
+static std::u32string test_string(std::size_t length, std::mt19937& rng)
+{
+    // A mix of runs of characters of each size so that checkpoints land in the middle of multi-unit code points
+    std::uniform_int_distribution<int> kindDist(0, 3);
+    std::u32string result;
+    int kind = 0;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        if ((i % 20) == 0)
+        {
+            kind = kindDist(rng);
+        }
+
+        char32_t ch =
+            (kind == 0) ? std::uniform_int_distribution<char32_t>(0x01, 0x7F)(rng) :
+            (kind == 1) ? std::uniform_int_distribution<char32_t>(0x80, 0x7FF)(rng) :
+            (kind == 2) ? std::uniform_int_distribution<char32_t>(0x4E00, 0x9FFF)(rng) :
+            std::uniform_int_distribution<char32_t>(0x1'0000, 0x10'FFFF)(rng);
+        result.push_back(ch);
+    }
+
+    return result;
+}
+
+template <encoding Encoding>
+static void DoIndexTest(const std::u32string& str, std::size_t stride)
+{
+    auto encoded = encode<Encoding>(str);
+    code_point_index<Encoding> index(encoded, stride);
+    ASSERT_EQ(str.length(), index.length());
+    ASSERT_EQ(encoded.size(), index.size());
+
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < str.length(); ++i)
+    {
+        ASSERT_EQ(offset, index.offset(i));
+        ASSERT_EQ(str[i], index[i]);
+        ASSERT_EQ(str[i], index.at(i));
+        offset += encode<Encoding>(str.substr(i, 1)).size();
+    }
+
+    ASSERT_EQ(index.end(), index.find(str.length()));
+    ASSERT_THROW(index.at(str.length()), std::out_of_range);
+}
+
+template <encoding Encoding>
+static void DoSubstrTest(const std::u32string& str, std::size_t stride)
+{
+    auto encoded = encode<Encoding>(str);
+    code_point_index<Encoding> index(encoded, stride);
+
+    for (std::size_t pos = 0; pos <= str.length(); pos += 7)
+    {
+        for (std::size_t count : { std::size_t(0), std::size_t(1), std::size_t(5), stride - 1, stride, 3 * stride,
+            std::u32string::npos })
+        {
+            auto expect = encode<Encoding>(str.substr(pos, count));
+            auto view = index.substr(pos, count);
+            ASSERT_EQ(expect, std::basic_string<code_unit_t<Encoding>>(view.data(), view.size()));
+        }
+    }
+
+    ASSERT_THROW(index.substr(str.length() + 1), std::out_of_range);
+}
+
+TEST(UnicodeIndexTests, EmptyStringTest)
+{
+    code_point_index<encoding::utf_8> defaultIndex;
+    ASSERT_TRUE(defaultIndex.empty());
+    ASSERT_EQ(0u, defaultIndex.length());
+
+    std::string str;
+    code_point_index<encoding::utf_8> index(str);
+    ASSERT_TRUE(index.empty());
+    ASSERT_EQ(0u, index.length());
+    ASSERT_EQ(index.end(), index.find(0));
+    ASSERT_TRUE(index.substr().empty());
+}
+
+TEST(UnicodeIndexTests, Utf8IndexTest)
+{
+    std::mt19937 rng(42);
+    auto str = test_string(1000, rng);
+    for (std::size_t stride : { 1, 2, 3, 16, 128, 2000 })
+    {
+        DoIndexTest<encoding::utf_8>(str, stride);
+    }
+}
+
+TEST(UnicodeIndexTests, Utf16IndexTest)
+{
+    std::mt19937 rng(42);
+    auto str = test_string(1000, rng);
+    for (std::size_t stride : { 1, 2, 3, 16, 128, 2000 })
+    {
+        DoIndexTest<encoding::utf_16le>(str, stride);
+        DoIndexTest<encoding::utf_16be>(str, stride);
+    }
+}
+
+TEST(UnicodeIndexTests, SubstrTest)
+{
+    std::mt19937 rng(42);
+    auto str = test_string(500, rng);
+    for (std::size_t stride : { 1, 5, 64 })
+    {
+        DoSubstrTest<encoding::utf_8>(str, stride);
+        DoSubstrTest<encoding::utf_16le>(str, stride);
+        DoSubstrTest<encoding::utf_16be>(str, stride);
+    }
+}
@@ -11,6 +11,7 @@
 #include <forward_list>
 #include <gtest/gtest.h>
 #include <list>
+#include <string>
 
 const char empty_string8[] = u8"";
 const char foobar_string8[] = u8"foobar";
@@ -443,6 +444,84 @@ TEST(UnicodeIteratorTests, Utf32PostDecrementTest)
     DoPostDecrementTest<dhorn::unicode::encoding::utf_32be>(list.end(), test_string32);
 }
 
+template <
+    typename Itr,
+    dhorn::unicode::encoding Encoding = dhorn::unicode::character_encoding_v<typename std::iterator_traits<Itr>::value_type>>
+void DoBoundedIteratorTest(Itr begin, Itr end, std::u32string expected)
+{
+    using iterator = dhorn::unicode::bounded_iterator<Itr, Encoding>;
+    iterator endItr(end, end);
+
+    std::u32string result;
+    for (iterator itr(begin, end); itr != endItr; ++itr)
+    {
+        result.push_back(*itr);
+    }
+    ASSERT_TRUE(expected == result);
+
+    if constexpr (std::is_base_of_v<std::bidirectional_iterator_tag, typename iterator::iterator_category>)
+    {
+        result.clear();
+        for (auto itr = endItr; itr != iterator(begin, end);)
+        {
+            result.insert(result.begin(), *--itr);
+        }
+        ASSERT_TRUE(expected == result);
+    }
+}
+
+template <dhorn::unicode::encoding Encoding, typename Itr>
+void DoBoundedIteratorTest(Itr begin, Itr end, std::u32string expected)
+{
+    DoBoundedIteratorTest<Itr, Encoding>(begin, end, std::move(expected));
+}
+
+TEST(UnicodeIteratorTests, Utf8BoundedIteratorTest)
+{
+    // NOTE: The null terminator is excluded so that the strings are effectively not null terminated
+    DoBoundedIteratorTest(std::begin(empty_string8), std::end(empty_string8) - 1, empty_string32);
+    DoBoundedIteratorTest(std::begin(foobar_string8), std::end(foobar_string8) - 1, foobar_string32);
+    DoBoundedIteratorTest(std::begin(test_string8), std::end(test_string8) - 1, test_string32);
+
+    std::forward_list<char> list(std::begin(test_string8), std::end(test_string8) - 1);
+    DoBoundedIteratorTest(list.begin(), list.end(), test_string32);
+
+    // Truncating the last code point should give eof without reading past the end
+    std::u32string expected = test_string32;
+    expected.back() = dhorn::unicode::eof;
+    for (std::size_t i = 2; i <= 4; ++i)
+    {
+        DoBoundedIteratorTest(std::begin(test_string8), std::end(test_string8) - i, expected);
+    }
+}
+
+TEST(UnicodeIteratorTests, Utf16BoundedIteratorTest)
+{
+    DoBoundedIteratorTest(std::begin(empty_string16), std::end(empty_string16) - 1, empty_string32);
+    DoBoundedIteratorTest(std::begin(foobar_string16), std::end(foobar_string16) - 1, foobar_string32);
+    DoBoundedIteratorTest(std::begin(test_string16), std::end(test_string16) - 1, test_string32);
+
+    static_assert(dhorn::unicode::encoding::utf_16 == dhorn::unicode::encoding::utf_16le);
+    DoBoundedIteratorTest<dhorn::unicode::encoding::utf_16be>(
+        std::begin(test_string16_be), std::end(test_string16_be) - 1, test_string32);
+
+    std::u32string expected = test_string32;
+    expected.back() = dhorn::unicode::eof;
+    DoBoundedIteratorTest(std::begin(test_string16), std::end(test_string16) - 2, expected);
+    DoBoundedIteratorTest<dhorn::unicode::encoding::utf_16be>(
+        std::begin(test_string16_be), std::end(test_string16_be) - 2, expected);
+}
+
+TEST(UnicodeIteratorTests, Utf32BoundedIteratorTest)
+{
+    DoBoundedIteratorTest(std::begin(empty_string32), std::end(empty_string32) - 1, empty_string32);
+    DoBoundedIteratorTest(std::begin(foobar_string32), std::end(foobar_string32) - 1, foobar_string32);
+    DoBoundedIteratorTest(std::begin(test_string32), std::end(test_string32) - 1, test_string32);
+
+    DoBoundedIteratorTest<dhorn::unicode::encoding::utf_32be>(
+        std::begin(test_string32_be), std::end(test_string32_be) - 1, test_string32);
+}
+
 template <dhorn::unicode::encoding Encoding, typename CharTy>
 void DoOutputIteratorTest(const char32_t* str, const CharTy* expected)
 {
@@ -0,0 +1,331 @@
+/*
+ * Duncan Horn
+ *
+ * UnicodeTranscodeTests.cpp
+ *
+ * Tests for the unicode/transcode.h functions
+ */
+
+#include <algorithm>
+#include <dhorn/unicode/transcode.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dhorn::unicode;
+
+template <encoding Encoding>
+using code_unit_t = typename encoding_traits<Encoding>::value_type;
+
+template <encoding Encoding>
+static std::basic_string<code_unit_t<Encoding>> encode(const std::u32string& str)
+{
+    std::basic_string<code_unit_t<Encoding>> result;
+    for (auto ch : str)
+    {
+        encoding_traits<Encoding>::write(std::back_inserter(result), ch);
+    }
+
+    return result;
+}
+
+static std::u32string test_string(std::size_t length, std::mt19937& rng)
+{
+    // Long runs of ASCII and BMP characters so that the fast paths kick in, with the occasional multi-byte character
+    // thrown in
+    std::uniform_int_distribution<int> kindDist(0, 99);
+    std::u32string result;
+    int kind = 0;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        if ((i % 32) == 0)
+        {
+            kind = kindDist(rng);
+        }
+
+        char32_t ch;
+        if (kind < 50)
+        {
+            ch = std::uniform_int_distribution<char32_t>(0x01, 0x7F)(rng);
+        }
+        else if (kind < 75)
+        {
+            ch = std::uniform_int_distribution<char32_t>(0x80, 0xD7FF)(rng);
+        }
+        else
+        {
+            ch = std::uniform_int_distribution<char32_t>(0x01, 0x10'FFFF)(rng);
+            if (!is_valid_code_point(ch))
+            {
+                ch = U'?';
+            }
+        }
+
+        result.push_back(ch);
+    }
+
+    return result;
+}
+
+template <encoding From, encoding To>
+static void DoRoundTripTest()
+{
+    std::mt19937 rng(42);
+    for (std::size_t length : { 0, 1, 7, 15, 16, 17, 31, 64, 100, 1000 })
+    {
+        auto str = test_string(length, rng);
+        auto input = encode<From>(str);
+        auto expected = encode<To>(str);
+
+        auto begin = input.data();
+        auto end = begin + input.size();
+        auto [pos, size] = transcoded_length<From, To>(begin, end);
+        ASSERT_EQ(end, pos);
+        ASSERT_EQ(expected.size(), size);
+
+        std::vector<code_unit_t<To>> buffer(size + 1);
+        auto result = transcode<From, To>(begin, end, buffer.data());
+        ASSERT_EQ(end, result.input);
+        ASSERT_EQ(buffer.data() + size, result.output);
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(), buffer.begin()));
+
+        std::basic_string<code_unit_t<To>> output;
+        transcode<From, To>(begin, end, output);
+        ASSERT_TRUE(expected == output);
+    }
+}
+
+template <encoding From>
+static void DoRoundTripTest()
+{
+    DoRoundTripTest<From, encoding::utf_8>();
+    DoRoundTripTest<From, encoding::utf_16le>();
+    DoRoundTripTest<From, encoding::utf_16be>();
+    DoRoundTripTest<From, encoding::utf_32le>();
+    DoRoundTripTest<From, encoding::utf_32be>();
+}
+
+TEST(UnicodeTranscodeTests, Utf8RoundTripTest)
+{
+    DoRoundTripTest<encoding::utf_8>();
+}
+
+TEST(UnicodeTranscodeTests, Utf16RoundTripTest)
+{
+    DoRoundTripTest<encoding::utf_16le>();
+    DoRoundTripTest<encoding::utf_16be>();
+}
+
+TEST(UnicodeTranscodeTests, Utf32RoundTripTest)
+{
+    DoRoundTripTest<encoding::utf_32le>();
+    DoRoundTripTest<encoding::utf_32be>();
+}
+
+template <encoding From, encoding To>
+static void DoErrorTest(const std::basic_string<code_unit_t<From>>& invalid)
+{
+    // Put the invalid sequence at all offsets within an ASCII string long enough for the fast paths to take effect
+    for (std::size_t offset = 0; offset <= 40; ++offset)
+    {
+        auto input = encode<From>(std::u32string(offset, U'a'));
+        input += invalid;
+        input += encode<From>(std::u32string(40, U'b'));
+
+        auto begin = input.data();
+        auto end = begin + input.size();
+        auto [pos, size] = transcoded_length<From, To>(begin, end);
+        ASSERT_EQ(begin + offset, pos);
+        ASSERT_EQ(offset, size);
+
+        std::vector<code_unit_t<To>> buffer(input.size() * 4);
+        auto result = transcode<From, To>(begin, end, buffer.data());
+        ASSERT_EQ(begin + offset, result.input);
+        ASSERT_EQ(buffer.data() + offset, result.output);
+
+        // Invalid input should leave the string untouched
+        std::basic_string<code_unit_t<To>> output(2, static_cast<code_unit_t<To>>('z'));
+        auto stringResult = transcode<From, To>(begin, end, output);
+        ASSERT_EQ(begin + offset, stringResult.input);
+        ASSERT_EQ(2u, output.size());
+    }
+}
+
+template <encoding From>
+static void DoErrorTest(const std::basic_string<code_unit_t<From>>& invalid)
+{
+    DoErrorTest<From, encoding::utf_8>(invalid);
+    DoErrorTest<From, encoding::utf_16le>(invalid);
+    DoErrorTest<From, encoding::utf_16be>(invalid);
+    DoErrorTest<From, encoding::utf_32le>(invalid);
+    DoErrorTest<From, encoding::utf_32be>(invalid);
+}
+
+TEST(UnicodeTranscodeTests, Utf8ErrorTest)
+{
+    DoErrorTest<encoding::utf_8>("\x80");                   // Unexpected continuation byte
+    DoErrorTest<encoding::utf_8>("\xC0\xAF");               // Overlong
+    DoErrorTest<encoding::utf_8>("\xE0\x80\xAF");           // Overlong
+    DoErrorTest<encoding::utf_8>("\xED\xA0\x80");           // Surrogate
+    DoErrorTest<encoding::utf_8>("\xF4\x90\x80\x80");       // Too large
+    DoErrorTest<encoding::utf_8>("\xE2\x82");               // Truncated
+    DoErrorTest<encoding::utf_8>("\xFF");                   // Invalid byte
+}
+
+TEST(UnicodeTranscodeTests, Utf16ErrorTest)
+{
+    DoErrorTest<encoding::utf_16>(u"\xDC00");               // Unexpected low surrogate
+    DoErrorTest<encoding::utf_16>(u"\xD800");               // Unpaired high surrogate
+    DoErrorTest<encoding::utf_16>(u"\xD800\xD800");         // Two high surrogates
+
+    std::u16string swapped = { static_cast<char16_t>(0x00DC) };
+    if constexpr (encoding::utf_16 == encoding::utf_16le)
+    {
+        DoErrorTest<encoding::utf_16be>(swapped);
+    }
+    else
+    {
+        DoErrorTest<encoding::utf_16le>(swapped);
+    }
+}
+
+TEST(UnicodeTranscodeTests, Utf32ErrorTest)
+{
+    DoErrorTest<encoding::utf_32>(U"\xD800");               // Surrogate
+    DoErrorTest<encoding::utf_32>(std::u32string(1, 0x11'0000)); // Too large
+
+    std::u32string swapped = { static_cast<char32_t>(0x00D8'0000) };
+    if constexpr (encoding::utf_32 == encoding::utf_32le)
+    {
+        DoErrorTest<encoding::utf_32be>(swapped);
+    }
+    else
+    {
+        DoErrorTest<encoding::utf_32le>(swapped);
+    }
+}
+
+TEST(UnicodeTranscodeTests, StringAppendTest)
+{
+    std::u16string str = u"foo";
+    auto input = u8"baré\U0001F600";
+    auto result = transcode<encoding::utf_8, encoding::utf_16>(input, input + std::strlen(input), str);
+    ASSERT_EQ(input + std::strlen(input), result.input);
+    ASSERT_EQ(str.data() + str.size(), result.output);
+    ASSERT_TRUE(str == u"foobaré\U0001F600");
+}
+
+template <encoding From, encoding To>
+static void DoStreamingTest()
+{
+    std::mt19937 rng(42);
+    for (std::size_t length : { 0, 1, 16, 100, 1000 })
+    {
+        auto str = test_string(length, rng);
+        auto input = encode<From>(str);
+        auto expected = encode<To>(str);
+
+        // Split the input at random points, including in the middle of code points
+        for (std::size_t maxChunk : { 1, 2, 3, 7, 64 })
+        {
+            streaming_transcoder<From, To> transcoder;
+            std::basic_string<code_unit_t<To>> output;
+            for (std::size_t pos = 0; pos < input.size();)
+            {
+                auto chunk = std::min<std::size_t>(input.size() - pos, rng() % maxChunk + 1);
+                auto begin = input.data() + pos;
+                auto result = transcoder.feed(begin, begin + chunk, output);
+                ASSERT_EQ(begin + chunk, result.input);
+                ASSERT_EQ(output.data() + output.size(), result.output);
+                pos += chunk;
+            }
+
+            ASSERT_FALSE(transcoder.has_partial_code_point());
+            ASSERT_TRUE(transcoder.finish());
+            ASSERT_TRUE(expected == output);
+        }
+
+        // Same thing, but using a caller supplied buffer
+        streaming_transcoder<From, To> transcoder;
+        std::vector<code_unit_t<To>> buffer;
+        std::basic_string<code_unit_t<To>> output;
+        for (std::size_t pos = 0; pos < input.size();)
+        {
+            auto chunk = std::min<std::size_t>(input.size() - pos, rng() % 5 + 1);
+            buffer.assign(streaming_transcoder<From, To>::max_output_length(chunk), 0);
+            auto result = transcoder.feed(input.data() + pos, input.data() + pos + chunk, buffer.data());
+            ASSERT_EQ(input.data() + pos + chunk, result.input);
+            output.append(buffer.data(), result.output);
+            pos += chunk;
+        }
+
+        ASSERT_TRUE(transcoder.finish());
+        ASSERT_TRUE(expected == output);
+    }
+}
+
+template <encoding From>
+static void DoStreamingTest()
+{
+    DoStreamingTest<From, encoding::utf_8>();
+    DoStreamingTest<From, encoding::utf_16le>();
+    DoStreamingTest<From, encoding::utf_16be>();
+    DoStreamingTest<From, encoding::utf_32le>();
+    DoStreamingTest<From, encoding::utf_32be>();
+}
+
+TEST(UnicodeTranscodeTests, StreamingTest)
+{
+    DoStreamingTest<encoding::utf_8>();
+    DoStreamingTest<encoding::utf_16le>();
+    DoStreamingTest<encoding::utf_16be>();
+    DoStreamingTest<encoding::utf_32le>();
+    DoStreamingTest<encoding::utf_32be>();
+}
+
+TEST(UnicodeTranscodeTests, StreamingErrorTest)
+{
+    streaming_decoder<encoding::utf_8> decoder;
+    std::u32string output;
+
+    // Input that ends in the middle of a code point
+    const char truncated[] = "foo\xF0\x9F\x98";
+    auto result = decoder.feed(truncated, truncated + 6, output);
+    ASSERT_EQ(truncated + 6, result.input);
+    ASSERT_TRUE(decoder.has_partial_code_point());
+    ASSERT_FALSE(decoder.finish());
+    ASSERT_FALSE(decoder.has_partial_code_point());
+    ASSERT_TRUE(output == U"foo");
+
+    // An invalid sequence that starts in the previous chunk is reported at the start of the next chunk
+    output.clear();
+    const char first[] = "a\xE2";
+    const char second[] = "\x82z";
+    result = decoder.feed(first, first + 2, output);
+    ASSERT_EQ(first + 2, result.input);
+    result = decoder.feed(second, second + 2, output);
+    ASSERT_EQ(second, result.input);
+    ASSERT_FALSE(decoder.has_partial_code_point());
+    ASSERT_TRUE(output == U"a");
+
+    // The decoder can continue after skipping past the error
+    result = decoder.feed(second + 1, second + 2, output);
+    ASSERT_EQ(second + 2, result.input);
+    ASSERT_TRUE(output == U"az");
+
+    // Sequences that can never be valid shouldn't be held onto
+    const char overlong[] = "b\xE0\x80";
+    result = decoder.feed(overlong, overlong + 3, output);
+    ASSERT_EQ(overlong + 1, result.input);
+    ASSERT_FALSE(decoder.has_partial_code_point());
+
+    // Unpaired high surrogate split from its successor
+    streaming_decoder<encoding::utf_16> decoder16;
+    const char16_t first16[] = u"x\xD83D";
+    const char16_t second16[] = u"y";
+    auto result16 = decoder16.feed(first16, first16 + 2, output);
+    ASSERT_EQ(first16 + 2, result16.input);
+    result16 = decoder16.feed(second16, second16 + 1, output);
+    ASSERT_EQ(second16, result16.input);
+}
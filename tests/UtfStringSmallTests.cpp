@@ -0,0 +1,181 @@
+/*
+ * Duncan Horn
+ *
+ * UtfStringSmallTests.cpp
+ *
+ * Tests for the inline (small string) storage of the experimental/utf_string.h type
+ */
+
+#include <dhorn/experimental/utf_string.h>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace dhorn::experimental;
+
+static const char small_string[] = "small";
+static const char large_string[] = "this string is too long to be stored inline";
+
+TEST(UtfStringSmallTests, SizeTest)
+{
+    // The inline buffer shares storage with the heap pointers, so it shouldn't make the string any larger
+    ASSERT_EQ(sizeof(std::size_t) + 3 * sizeof(void*), sizeof(utf8_string));
+    ASSERT_EQ(sizeof(utf8_string), sizeof(utf16_string));
+    ASSERT_EQ(sizeof(utf8_string), sizeof(utf32_string));
+}
+
+TEST(UtfStringSmallTests, CapacityTest)
+{
+    utf8_string empty;
+    ASSERT_EQ(nullptr, empty.c_str());
+
+    // Short strings use the whole inline buffer
+    utf8_string str = "foo";
+    ASSERT_STREQ("foo", str.c_str());
+    const auto inlineCapacity = str.capacity();
+    ASSERT_EQ(2 * sizeof(void*) - 1, inlineCapacity);
+
+    // The last code unit of a full buffer is the null character
+    std::string expect(inlineCapacity, 'x');
+    utf8_string full = expect.c_str();
+    ASSERT_EQ(inlineCapacity, full.capacity());
+    ASSERT_EQ(expect.size(), full.size());
+    ASSERT_STREQ(expect.c_str(), full.c_str());
+
+    expect.push_back('y');
+    full.push_back(U'y');
+    ASSERT_LT(inlineCapacity, full.capacity());
+    ASSERT_EQ(expect.size(), full.size());
+    ASSERT_STREQ(expect.c_str(), full.c_str());
+}
+
+TEST(UtfStringSmallTests, MoveTest)
+{
+    utf8_string small = small_string;
+    utf8_string moved(std::move(small));
+    ASSERT_STREQ(small_string, moved.c_str());
+    ASSERT_EQ(std::size(small_string) - 1, moved.length());
+    ASSERT_EQ(0u, small.length());
+    ASSERT_EQ(0u, small.size());
+
+    utf8_string large = large_string;
+    moved = std::move(large);
+    ASSERT_STREQ(large_string, moved.c_str());
+    ASSERT_EQ(std::size(large_string) - 1, moved.size());
+
+    utf8_string other = "other";
+    moved = std::move(other);
+    ASSERT_STREQ("other", moved.c_str());
+    ASSERT_EQ(5u, moved.length());
+    ASSERT_EQ(5u, moved.size());
+
+    // Moved from strings are still usable
+    small = "again";
+    ASSERT_STREQ("again", small.c_str());
+}
+
+TEST(UtfStringSmallTests, SwapTest)
+{
+    // All combinations of empty, inline, and heap allocated strings
+    utf8_string small = small_string;
+    utf8_string large = large_string;
+    utf8_string empty;
+
+    small.swap(large);
+    ASSERT_STREQ(large_string, small.c_str());
+    ASSERT_STREQ(small_string, large.c_str());
+    ASSERT_EQ(std::size(small_string) - 1, large.length());
+    ASSERT_EQ(std::size(large_string) - 1, small.length());
+
+    large.swap(small);
+    utf8_string otherSmall = "other";
+    small.swap(otherSmall);
+    ASSERT_STREQ("other", small.c_str());
+    ASSERT_STREQ(small_string, otherSmall.c_str());
+
+    utf8_string otherLarge = "another string that is too long to be stored inline";
+    large.swap(otherLarge);
+    ASSERT_STREQ("another string that is too long to be stored inline", large.c_str());
+    ASSERT_STREQ(large_string, otherLarge.c_str());
+
+    empty.swap(small);
+    ASSERT_STREQ("other", empty.c_str());
+    ASSERT_TRUE(small.empty());
+    ASSERT_EQ(nullptr, small.c_str());
+
+    small.swap(empty);
+    ASSERT_STREQ("other", small.c_str());
+    ASSERT_TRUE(empty.empty());
+
+    empty.swap(large);
+    ASSERT_STREQ("another string that is too long to be stored inline", empty.c_str());
+    ASSERT_TRUE(large.empty());
+
+    // Inline strings must still be usable after being swapped
+    small.push_back(U'!');
+    ASSERT_STREQ("other!", small.c_str());
+    otherSmall += large_string;
+    ASSERT_STREQ((std::string(small_string) + large_string).c_str(), otherSmall.c_str());
+}
+
+TEST(UtfStringSmallTests, GrowTest)
+{
+    // Strings that start out inline need to correctly move to the heap when they grow
+    utf16_string str;
+    std::u16string expect;
+    for (int i = 0; i < 100; ++i)
+    {
+        char32_t ch = (i % 3) ? static_cast<char32_t>(u'a' + (i % 26)) : U'\U0001F600';
+        str.push_back(ch);
+        expect += (i % 3) ? std::u16string(1, static_cast<char16_t>(ch)) : u"\U0001F600";
+
+        ASSERT_EQ(static_cast<std::size_t>(i + 1), str.length());
+        ASSERT_EQ(expect.size(), str.size());
+        ASSERT_TRUE(std::equal(expect.c_str(), expect.c_str() + expect.size() + 1, str.c_str()));
+    }
+
+    utf32_string str32;
+    std::u32string expect32;
+    for (char32_t ch = U'a'; ch <= U'z'; ++ch)
+    {
+        str32.push_back(ch);
+        expect32.push_back(ch);
+        ASSERT_TRUE(std::equal(expect32.c_str(), expect32.c_str() + expect32.size() + 1, str32.c_str()));
+    }
+}
+
+TEST(UtfStringSmallTests, SelfReferenceTest)
+{
+    // Appending/assigning from our own buffer while moving from the inline buffer to the heap
+    utf8_string self = "0123456789";
+    self += self;
+    ASSERT_STREQ("01234567890123456789", self.c_str());
+    self += self;
+    ASSERT_STREQ("0123456789012345678901234567890123456789", self.c_str());
+
+    utf8_string suffix = "0123456789";
+    suffix += suffix.c_str() + 5;
+    ASSERT_STREQ("012345678956789", suffix.c_str());
+    suffix += suffix.c_str() + 10;
+    ASSERT_STREQ("01234567895678956789", suffix.c_str());
+
+    suffix = suffix.c_str() + 12;
+    ASSERT_STREQ("78956789", suffix.c_str());
+    ASSERT_EQ(8u, suffix.length());
+    suffix = suffix.c_str() + 2;
+    ASSERT_STREQ("956789", suffix.c_str());
+}
+
+TEST(UtfStringSmallTests, ConversionTest)
+{
+    utf16_string str16 = u"h\u00E9llo \U0001F600";
+    utf8_string str8 = str16;
+    ASSERT_STREQ(u8"h\u00E9llo \U0001F600", str8.c_str());
+    ASSERT_EQ(str16.length(), str8.length());
+
+    utf32_string str32 = str8;
+    ASSERT_EQ(str16.length(), str32.length());
+    ASSERT_EQ(std::u32string(U"h\u00E9llo \U0001F600"), std::u32string(str32.c_str()));
+
+    utf16_string back = str32;
+    ASSERT_EQ(std::u16string(str16.c_str()), std::u16string(back.c_str()));
+}
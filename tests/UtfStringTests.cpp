@@ -3652,6 +3652,62 @@ namespace dhorn
                 ASSERT_EQ(0, strcmp(str1.c_str(), "bar"));
                 ASSERT_EQ(0, strcmp(str2.c_str(), "foo"));
             }
+
+            TEST_METHOD(SmallStringSwapTest)
+            {
+                // Swap all combinations of inline and heap allocated strings
+                const char smallBuff[] = "small";
+                const char largeBuff[] = "this string is too long to be stored inline";
+                dhorn::experimental::utf8_string small = smallBuff;
+                dhorn::experimental::utf8_string large = largeBuff;
+                dhorn::experimental::utf8_string empty;
+
+                small.swap(large);
+                ASSERT_EQ(0, strcmp(small.c_str(), largeBuff));
+                ASSERT_EQ(0, strcmp(large.c_str(), smallBuff));
+                ASSERT_EQ(std::size(smallBuff) - 1, large.length());
+
+                large.swap(small);
+                dhorn::experimental::utf8_string otherSmall = "other";
+                small.swap(otherSmall);
+                ASSERT_EQ(0, strcmp(small.c_str(), "other"));
+                ASSERT_EQ(0, strcmp(otherSmall.c_str(), smallBuff));
+
+                empty.swap(small);
+                ASSERT_EQ(0, strcmp(empty.c_str(), "other"));
+                ASSERT_TRUE(small.empty());
+
+                dhorn::experimental::utf8_string moved(std::move(empty));
+                ASSERT_EQ(0, strcmp(moved.c_str(), "other"));
+                ASSERT_EQ(static_cast<std::size_t>(0), empty.length());
+                ASSERT_EQ(static_cast<std::size_t>(0), empty.size());
+            }
+
+            TEST_METHOD(SmallStringGrowTest)
+            {
+                // Strings that start out inline need to correctly move to the heap when they grow
+                dhorn::experimental::utf16_string str;
+                std::u16string expect;
+                for (int i = 0; i < 100; ++i)
+                {
+                    char32_t ch = (i % 3) ? static_cast<char32_t>(u'a' + (i % 26)) : U'\U0001F600';
+                    str.push_back(ch);
+                    expect += (i % 3) ? std::u16string(1, static_cast<char16_t>(ch)) : u"\U0001F600";
+
+                    ASSERT_EQ(static_cast<std::size_t>(i + 1), str.length());
+                    ASSERT_EQ(expect.size(), str.size());
+                    ASSERT_TRUE(std::equal(expect.c_str(), expect.c_str() + expect.size() + 1, str.c_str()));
+                }
+
+                dhorn::experimental::utf8_string self = "0123456789";
+                self += self;
+                self += self;
+                ASSERT_EQ(0, strcmp(self.c_str(), "0123456789012345678901234567890123456789"));
+
+                dhorn::experimental::utf8_string suffix = "0123456789";
+                suffix += suffix.c_str() + 5;
+                ASSERT_EQ(0, strcmp(suffix.c_str(), "012345678956789"));
+            }
         };
     }
 }